@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <cassert>
 #include <cmath>
 #include <cstdint>
@@ -8,6 +9,7 @@
 #include <exception>
 #include <functional>
 #include <iterator>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <optional>
@@ -48,6 +50,7 @@
 
 #include <charm/sycl/accessor.hpp>
 #include <charm/sycl/buffer.hpp>
+#include <charm/sycl/command_graph.hpp>
 #include <charm/sycl/context.hpp>
 #include <charm/sycl/device.hpp>
 #include <charm/sycl/device_accessor.hpp>
@@ -63,11 +66,13 @@
 #include <charm/sycl/queue.hpp>
 #include <charm/sycl/reduction.hpp>
 #include <charm/sycl/selector.hpp>
+#include <charm/sycl/usm.hpp>
 #include <charm/sycl/vec.hpp>
 //
 #include <charm/sycl/runtime/accessor.hpp>
 #include <charm/sycl/runtime/allocator.hpp>
 #include <charm/sycl/runtime/buffer.hpp>
+#include <charm/sycl/runtime/command_graph.hpp>
 #include <charm/sycl/runtime/context.hpp>
 #include <charm/sycl/runtime/device.hpp>
 #include <charm/sycl/runtime/event.hpp>
@@ -77,6 +82,7 @@
 #include <charm/sycl/runtime/queue.hpp>
 //
 #include <charm/sycl/buffer.ipp>
+#include <charm/sycl/command_graph.ipp>
 #include <charm/sycl/context.ipp>
 #include <charm/sycl/device.ipp>
 #include <charm/sycl/device_accessor.ipp>
@@ -100,6 +106,7 @@
 #include <charm/sycl/range_3.ipp>
 #include <charm/sycl/reduction.ipp>
 #include <charm/sycl/selector.ipp>
+#include <charm/sycl/usm.ipp>
 #include <charm/sycl/utils.ipp>
 #include <charm/sycl/vec.ipp>
 //
@@ -3,6 +3,31 @@
 
 CHARM_SYCL_BEGIN_NAMESPACE
 
+namespace property::buffer {
+
+// CHARM-SYCL extension: the placement of the host memory that the runtime allocates for a
+// buffer constructed without host data. Overrides CHARM_SYCL_HOST_MEMORY_PLACEMENT and
+// CHARM_SYCL_HOST_MEMORY_PAGES. Without either, the memory comes from calloc.
+struct host_memory {
+    enum class placement {
+        first_touch,  // on the node of the thread that writes each page first
+        interleave,   // round-robin over all NUMA nodes
+        bind,         // on NUMA node `node`
+    };
+
+    enum class pages {
+        normal,
+        transparent_huge,
+        huge,  // explicit 2 MiB pages, or transparent ones if none are reserved
+    };
+
+    placement place = placement::first_touch;
+    int node = 0;
+    pages page = pages::normal;
+};
+
+}  // namespace property::buffer
+
 template <class T, int Dimensions, class AllocatorT>
 struct buffer : detail::common_ref_ops<buffer<T, Dimensions, AllocatorT>> {
     using value_type = T;
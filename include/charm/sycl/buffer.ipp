@@ -21,8 +21,9 @@ buffer<T, Dimensions, AllocatorT>::buffer(T* hostData, const range<Dimensions>&
 template <class T, int Dimensions, class AllocatorT>
 buffer<T, Dimensions, AllocatorT>::buffer(T* hostData, const range<Dimensions>& bufferRange,
                                           [[maybe_unused]] AllocatorT allocator,
-                                          const property_list&)
-    : impl_(runtime::make_buffer(hostData, sizeof(T), detail::extend(bufferRange))) {
+                                          const property_list& propList)
+    : impl_(runtime::make_buffer(hostData, sizeof(T), detail::extend(bufferRange),
+                                 runtime::get_prop<property::buffer::host_memory>(propList))) {
     if (hostData) {
         set_final_data(hostData);
     }
@@ -38,16 +39,18 @@ template <class T, int Dimensions, class AllocatorT>
 buffer<T, Dimensions, AllocatorT>::buffer(const T* hostData,
                                           const range<Dimensions>& bufferRange,
                                           [[maybe_unused]] AllocatorT allocator,
-                                          const property_list&)
+                                          const property_list& propList)
     : impl_(runtime::make_buffer(const_cast<T*>(hostData), sizeof(T),
-                                 detail::extend(bufferRange))) {}
+                                 detail::extend(bufferRange),
+                                 runtime::get_prop<property::buffer::host_memory>(propList))) {}
 
 template <class T, int Dimensions, class AllocatorT>
 buffer<T, Dimensions, AllocatorT>::buffer(const std::shared_ptr<T>& hostData,
                                           const range<Dimensions>& bufferRange,
                                           [[maybe_unused]] AllocatorT allocator,
-                                          const property_list&)
-    : impl_(runtime::make_buffer(hostData.get(), sizeof(T), detail::extend(bufferRange))),
+                                          const property_list& propList)
+    : impl_(runtime::make_buffer(hostData.get(), sizeof(T), detail::extend(bufferRange),
+                                 runtime::get_prop<property::buffer::host_memory>(propList))),
       sp_(hostData) {
     set_final_data(hostData.get());
 }
@@ -62,8 +65,9 @@ template <class T, int Dimensions, class AllocatorT>
 buffer<T, Dimensions, AllocatorT>::buffer(const std::shared_ptr<T[]>& hostData,
                                           const range<Dimensions>& bufferRange,
                                           [[maybe_unused]] AllocatorT allocator,
-                                          const property_list&)
-    : impl_(runtime::make_buffer(hostData.get(), sizeof(T), detail::extend(bufferRange))),
+                                          const property_list& propList)
+    : impl_(runtime::make_buffer(hostData.get(), sizeof(T), detail::extend(bufferRange),
+                                 runtime::get_prop<property::buffer::host_memory>(propList))),
       sp_(hostData) {
     set_final_data(hostData.get());
 }
@@ -0,0 +1,48 @@
+#pragma once
+#include <charm/sycl.hpp>
+
+CHARM_SYCL_BEGIN_NAMESPACE
+
+/*
+ * Records the command groups submitted to a queue and submits them again on request.
+ *
+ * Command groups submitted between begin_recording() and end_recording() are captured instead
+ * of executed. The kernel, the range, the parameters and the accessed buffer regions of each
+ * command group are resolved once, so replay() does not run the command group functions again.
+ * The recorded nodes are ordered by their buffer accesses, like ordinary submissions, by the
+ * events given to handler::depends_on() while recording and, on an in-order queue, by their
+ * order of submission. An event of another graph cannot be given to handler::depends_on().
+ * The events returned while recording only serve that purpose: waiting for them returns at
+ * once, and they have no completion status.
+ *
+ * The dependencies and data transfers of a replay are analyzed once and reused by the following
+ * replays, as long as no other command group accesses the buffers of the graph in between.
+ *
+ * The graph keeps the buffers used by the recorded command groups alive. The host pointers
+ * they use must outlive the graph.
+ */
+struct command_graph {
+    explicit inline command_graph(queue const& q);
+
+    inline void begin_recording();
+
+    inline void end_recording();
+
+    // The number of recorded command groups.
+    inline size_t size() const;
+
+    // Replaces the `idx`-th scalar parameter of the `node`-th command group for the following
+    // replays. Parameter 0 of a kernel is the kernel object itself.
+    template <class T>
+    inline void set_arg(size_t node, size_t idx, T const& value);
+
+    // Submits all recorded command groups. The event completes when all of them have finished.
+    inline event replay();
+
+private:
+    friend struct runtime::impl_access;
+
+    runtime::command_graph_ptr impl_;
+};
+
+CHARM_SYCL_END_NAMESPACE
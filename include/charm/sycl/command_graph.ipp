@@ -0,0 +1,31 @@
+#pragma once
+#include <charm/sycl.hpp>
+
+CHARM_SYCL_BEGIN_NAMESPACE
+
+inline command_graph::command_graph(queue const& q)
+    : impl_(runtime::make_command_graph(runtime::impl_access::get_impl(q))) {}
+
+inline void command_graph::begin_recording() {
+    impl_->begin_recording();
+}
+
+inline void command_graph::end_recording() {
+    impl_->end_recording();
+}
+
+inline size_t command_graph::size() const {
+    return impl_->size();
+}
+
+template <class T>
+inline void command_graph::set_arg(size_t node, size_t idx, T const& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    impl_->set_arg(node, idx, std::addressof(value), sizeof(T));
+}
+
+inline event command_graph::replay() {
+    return runtime::impl_access::from_impl<event>(impl_->replay());
+}
+
+CHARM_SYCL_END_NAMESPACE
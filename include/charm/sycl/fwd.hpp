@@ -96,6 +96,8 @@ struct host_accessor;
 template <class T, int Dimensions = 1, class AllocatorT = buffer_allocator<T>>
 struct buffer;
 
+struct command_graph;
+
 struct context;
 
 struct device;
@@ -170,6 +172,10 @@ enum class errc : int {
 
 enum class memory_scope { work_item, sub_group, work_group, device, system };
 
+namespace usm {
+enum class alloc { host, device, shared, unknown };
+}
+
 template <class T>
 struct is_group : std::false_type {};
 
@@ -225,6 +231,11 @@ inline constexpr bool not_supported = false;
 
 namespace property::queue {
 struct enable_profiling;
+struct in_order;
+}
+
+namespace property::buffer {
+struct host_memory;
 }
 
 CHARM_SYCL_END_NAMESPACE
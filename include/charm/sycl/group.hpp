@@ -209,4 +209,35 @@ private:
     group<Dimensions> g_;
 };
 
+/*
+ * Group algorithms. Every work-item of the group must call them with the same arguments except
+ * `x`. They are implemented for the operations and types of CHARM_SYCL_FOR_EACH_BUILTIN_OP.
+ */
+template <class Group, class T>
+T group_broadcast(Group g, T x);
+
+template <class Group, class T>
+T group_broadcast(Group g, T x, typename Group::linear_id_type local_linear_id);
+
+template <class Group, class T>
+T group_broadcast(Group g, T x, typename Group::id_type local_id);
+
+template <class Group, class T, class BinaryOperation>
+T reduce_over_group(Group g, T x, BinaryOperation binary_op);
+
+template <class Group, class V, class T, class BinaryOperation>
+T reduce_over_group(Group g, V x, T init, BinaryOperation binary_op);
+
+template <class Group, class T, class BinaryOperation>
+T exclusive_scan_over_group(Group g, T x, BinaryOperation binary_op);
+
+template <class Group, class V, class T, class BinaryOperation>
+T exclusive_scan_over_group(Group g, V x, T init, BinaryOperation binary_op);
+
+template <class Group, class T, class BinaryOperation>
+T inclusive_scan_over_group(Group g, T x, BinaryOperation binary_op);
+
+template <class Group, class V, class BinaryOperation, class T>
+T inclusive_scan_over_group(Group g, V x, BinaryOperation binary_op, T init);
+
 CHARM_SYCL_END_NAMESPACE
@@ -6,8 +6,63 @@ CHARM_SYCL_BEGIN_NAMESPACE
 
 namespace runtime {
 void __charm_sycl_group_barrier(void const*, memory_scope);
+
+/*
+ * Group algorithms over the work-items of a work group. `lid` and `n` are the local linear id
+ * and the local linear range; the scans follow the order of the local linear ids. The exclusive
+ * scan yields the identity of the operation on the first work-item.
+ */
+#define CHARM_SYCL_DECLARE_GROUP_OP(op, t, T)                          \
+    T __charm_sycl_group_reduce_##op##_##t(T, size_t, size_t);         \
+    T __charm_sycl_group_inclusive_scan_##op##_##t(T, size_t, size_t); \
+    T __charm_sycl_group_exclusive_scan_##op##_##t(T, size_t, size_t);
+
+#define CHARM_SYCL_DECLARE_GROUP_BROADCAST(t, T) \
+    T __charm_sycl_group_broadcast_##t(T, size_t, size_t, size_t);
+
+CHARM_SYCL_FOR_EACH_BUILTIN_OP(CHARM_SYCL_DECLARE_GROUP_OP)
+CHARM_SYCL_FOR_EACH_BUILTIN_TYPE(CHARM_SYCL_DECLARE_GROUP_BROADCAST)
+
+#undef CHARM_SYCL_DECLARE_GROUP_BROADCAST
+#undef CHARM_SYCL_DECLARE_GROUP_OP
 }  // namespace runtime
 
+namespace detail {
+
+#define CHARM_SYCL_DEFINE_GROUP_OP(op, t, T)                                                 \
+    template <class U>                                                                       \
+    inline T group_reduce(op<U> const&, T x, size_t lid, size_t n) {                         \
+        return runtime::__charm_sycl_group_reduce_##op##_##t(x, lid, n);                     \
+    }                                                                                        \
+                                                                                             \
+    template <class U>                                                                       \
+    inline T group_inclusive_scan(op<U> const&, T x, size_t lid, size_t n) {                 \
+        return runtime::__charm_sycl_group_inclusive_scan_##op##_##t(x, lid, n);             \
+    }                                                                                        \
+                                                                                             \
+    template <class U>                                                                       \
+    inline T group_exclusive_scan(op<U> const&, T x, size_t lid, size_t n) {                 \
+        return runtime::__charm_sycl_group_exclusive_scan_##op##_##t(x, lid, n);             \
+    }
+
+#define CHARM_SYCL_DEFINE_GROUP_BROADCAST(t, T)                                  \
+    inline T group_broadcast_from(T x, size_t lid, size_t n, size_t from) {      \
+        return runtime::__charm_sycl_group_broadcast_##t(x, lid, n, from);       \
+    }
+
+CHARM_SYCL_FOR_EACH_BUILTIN_OP(CHARM_SYCL_DEFINE_GROUP_OP)
+CHARM_SYCL_FOR_EACH_BUILTIN_TYPE(CHARM_SYCL_DEFINE_GROUP_BROADCAST)
+
+#undef CHARM_SYCL_DEFINE_GROUP_BROADCAST
+#undef CHARM_SYCL_DEFINE_GROUP_OP
+
+template <class Group>
+inline constexpr bool is_work_group_v = std::is_same_v<std::decay_t<Group>, group<1>> ||
+                                        std::is_same_v<std::decay_t<Group>, group<2>> ||
+                                        std::is_same_v<std::decay_t<Group>, group<3>>;
+
+}  // namespace detail
+
 template <int _Dimensions>
 struct is_group<group<_Dimensions>> : std::true_type {};
 
@@ -27,6 +82,84 @@ void group_barrier(Group& g, memory_scope fence_scope) {
 #endif
 }
 
+template <class Group, class T>
+T group_broadcast(Group g, T x) {
+    return group_broadcast(g, x, typename Group::linear_id_type(0));
+}
+
+template <class Group, class T>
+T group_broadcast(Group g, T x, typename Group::linear_id_type local_linear_id) {
+#ifdef __SYCL_DEVICE_ONLY__
+    static_assert(detail::is_work_group_v<Group>, "not supported group");
+    return detail::group_broadcast_from(x, g.get_local_linear_id(), g.get_local_linear_range(),
+                                        local_linear_id);
+#else
+    (void)g;
+    (void)local_linear_id;
+    return x;
+#endif
+}
+
+template <class Group, class T>
+T group_broadcast(Group g, T x, typename Group::id_type local_id) {
+    return group_broadcast(
+        g, x, detail::linear_id<Group::dimensions>(g.get_local_range(), local_id));
+}
+
+template <class Group, class T, class BinaryOperation>
+T reduce_over_group(Group g, T x, BinaryOperation binary_op) {
+#ifdef __SYCL_DEVICE_ONLY__
+    static_assert(detail::is_work_group_v<Group>, "not supported group");
+    return detail::group_reduce(binary_op, x, g.get_local_linear_id(),
+                                g.get_local_linear_range());
+#else
+    (void)g;
+    (void)binary_op;
+    return x;
+#endif
+}
+
+template <class Group, class V, class T, class BinaryOperation>
+T reduce_over_group(Group g, V x, T init, BinaryOperation binary_op) {
+    return binary_op(init, reduce_over_group(g, T(x), binary_op));
+}
+
+template <class Group, class T, class BinaryOperation>
+T exclusive_scan_over_group(Group g, T x, BinaryOperation binary_op) {
+#ifdef __SYCL_DEVICE_ONLY__
+    static_assert(detail::is_work_group_v<Group>, "not supported group");
+    return detail::group_exclusive_scan(binary_op, x, g.get_local_linear_id(),
+                                        g.get_local_linear_range());
+#else
+    (void)g;
+    (void)binary_op;
+    return x;
+#endif
+}
+
+template <class Group, class V, class T, class BinaryOperation>
+T exclusive_scan_over_group(Group g, V x, T init, BinaryOperation binary_op) {
+    return binary_op(init, exclusive_scan_over_group(g, T(x), binary_op));
+}
+
+template <class Group, class T, class BinaryOperation>
+T inclusive_scan_over_group(Group g, T x, BinaryOperation binary_op) {
+#ifdef __SYCL_DEVICE_ONLY__
+    static_assert(detail::is_work_group_v<Group>, "not supported group");
+    return detail::group_inclusive_scan(binary_op, x, g.get_local_linear_id(),
+                                        g.get_local_linear_range());
+#else
+    (void)g;
+    (void)binary_op;
+    return x;
+#endif
+}
+
+template <class Group, class V, class BinaryOperation, class T>
+T inclusive_scan_over_group(Group g, V x, BinaryOperation binary_op, T init) {
+    return binary_op(init, inclusive_scan_over_group(g, T(x), binary_op));
+}
+
 template <int Dimensions>
 template <class WorkItemFunctionT>
 void group<Dimensions>::parallel_for_work_item(WorkItemFunctionT const& func) const {
@@ -47,6 +47,15 @@ struct handler {
         fill(dest, static_cast<T>(src));
     }
 
+    // USM operations. Unlike kernels, they are not ordered against other commands by any
+    // buffer; use depends_on().
+    inline void memcpy(void* dest, const void* src, size_t numBytes);
+
+    inline void memset(void* ptr, int value, size_t numBytes);
+
+    template <class T>
+    inline void fill(void* ptr, const T& pattern, size_t count);
+
     inline void depends_on(event ev);
 
     inline void depends_on(std::vector<event> const& events) {
@@ -143,6 +152,23 @@ private:
     char name_[3 + Len + 1];
 };
 
+/*
+ * A kernel name and the handles that the backends resolved for it. There is one instance per
+ * kernel name type (see detail::kernel_handle_of), so a backend looks up a kernel only the
+ * first time it is submitted.
+ */
+struct kernel_handle {
+    // The indices of `slots`.
+    enum backend : unsigned { CPU, CUDA, HIP, N_BACKENDS };
+
+    char const* name;
+    uint32_t hash;
+    mutable std::atomic<void*> slots[N_BACKENDS] = {};
+};
+
+// The runtime may reset the slots while the static handles are being destroyed at exit.
+static_assert(std::is_trivially_destructible_v<kernel_handle>);
+
 template <class Name>
 inline char const* __charm_sycl_kernel_name(size_t& name_len) {
 #if __has_builtin(__builtin_sycl_unique_stable_name)
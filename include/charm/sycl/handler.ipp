@@ -9,6 +9,22 @@
 
 CHARM_SYCL_BEGIN_NAMESPACE
 
+namespace detail {
+
+template <class Name>
+inline runtime::kernel_handle const& kernel_handle_of() {
+    static runtime::kernel_handle const handle = [] {
+        size_t name_len;
+        auto const* name = runtime::__charm_sycl_kernel_name<Name>(name_len);
+
+        return runtime::kernel_handle{name, fnv1a(name, name_len + 3)};
+    }();
+
+    return handle;
+}
+
+}  // namespace detail
+
 inline handler::handler(queue const& q)
     : q_(runtime::impl_access::get_impl(q)), impl_(runtime::make_handler(q_)) {}
 
@@ -32,11 +48,7 @@ inline void handler::parallel_for_(range<Dimensions> const& range, KernelType co
 #endif
 
     using Name = std::remove_cvref_t<KernelName>;
-    size_t name_len;
-    auto const* name = runtime::__charm_sycl_kernel_name<Name>(name_len);
-
-    auto const h = detail::fnv1a(name, name_len + 3);
-    impl_->parallel_for(detail::extend(range), name, h);
+    impl_->parallel_for(detail::extend(range), detail::kernel_handle_of<Name>());
 
     do_bind<Name>(kernel);
 }
@@ -50,11 +62,7 @@ inline void handler::parallel_for_(nd_range<Dimensions> const& range,
 #endif
 
     using Name = std::remove_cvref_t<KernelName>;
-    size_t name_len;
-    auto const* name = runtime::__charm_sycl_kernel_name<Name>(name_len);
-
-    auto const h = detail::fnv1a(name, name_len + 3);
-    impl_->parallel_for(detail::extend(range), name, h);
+    impl_->parallel_for(detail::extend(range), detail::kernel_handle_of<Name>());
 
     do_bind<Name>(kernel);
 }
@@ -67,12 +75,7 @@ inline void handler::single_task_(KernelType const& kernel) {
 #endif
 
     using Name = std::remove_cvref_t<KernelName>;
-    size_t name_len;
-    auto const* name = runtime::__charm_sycl_kernel_name<Name>(name_len);
-
-    auto const h = detail::fnv1a(name, name_len + 3);
-
-    impl_->single_task(name, h);
+    impl_->single_task(detail::kernel_handle_of<Name>());
 
     do_bind<Name>(kernel);
 }
@@ -325,7 +328,7 @@ void handler::parallel_for_reduce(range<Dimensions> const& range, KernelType& fn
 
             for (size_t k [[clang::annotate("charm_sycl_parallel_for top 1")]] =
                      runtime::__charm_sycl_parallel_iter1_begin();
-                 runtime::__charm_sycl_parallel_iter1_cond(k, range1);
+                 runtime::__charm_sycl_parallel_iter1_cond(k, range2);
                  k = runtime::__charm_sycl_parallel_iter1_step(k)) {
                 for (size_t j [[clang::annotate("charm_sycl_parallel_for 2")]] =
                          runtime::__charm_sycl_parallel_iter2_begin();
@@ -342,7 +345,7 @@ void handler::parallel_for_reduce(range<Dimensions> const& range, KernelType& fn
                 }
             }
 
-            bool is_leader = runtime::__charm_sycl_is_reduce_leader_2();
+            bool is_leader = runtime::__charm_sycl_is_reduce_leader_3();
             (reducers.finalize(is_leader), ...);
         });
     }
@@ -490,6 +493,33 @@ void handler::fill(accessor<T, Dim, Mode, Tgt> const& dest, T const& src) {
     });
 }
 
+inline void handler::memcpy(void* dest, const void* src, size_t numBytes) {
+#ifdef __SYCL_DEVICE_ONLY__
+    (void)dest;
+    (void)src;
+    (void)numBytes;
+#else
+    impl_->memcpy(dest, src, numBytes);
+#endif
+}
+
+inline void handler::memset(void* ptr, int value, size_t numBytes) {
+    fill(ptr, static_cast<unsigned char>(value), numBytes);
+}
+
+template <class T>
+inline void handler::fill(void* ptr, const T& pattern, size_t count) {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+#ifdef __SYCL_DEVICE_ONLY__
+    (void)ptr;
+    (void)pattern;
+    (void)count;
+#else
+    impl_->fill(ptr, std::addressof(pattern), sizeof(T), count);
+#endif
+}
+
 inline event handler::finalize() {
     return runtime::impl_access::from_impl<event>(impl_->finalize());
 }
@@ -501,7 +531,7 @@ auto constexpr has_impl_v = decltype(runtime::impl_access::has_impl(std::declval
 
 template <class... Args>
 inline void handler::__bind(Args const&... args) {
-    impl_->reserve_binds(sizeof...(Args));
+    impl_->reserve_binds(sizeof...(Args), (size_t(0) + ... + sizeof(Args)));
     impl_->begin_binds();
     try {
         bind_args<true, 0>(args...);
@@ -549,7 +579,10 @@ inline void handler::do_bind(KernelType& fn) {
     static constinit auto const desc = ::__cham_sycl_kernel_descs::get<KernelName>();
     static constinit auto const accessors = desc.accessors();
 
-    impl_->reserve_binds(accessors.size() + 1);
+    // The function object is copied by a single bind, and the kernel wrapper patches the
+    // pointers of the accessors in the copy. Each accessor is still bound on its own, since its
+    // bind registers the dependencies and transfers of its buffer region.
+    impl_->reserve_binds(accessors.size() + 1, desc.params_size());
     impl_->begin_binds();
     try {
         auto* fn_ptr =
@@ -6,6 +6,9 @@ CHARM_SYCL_BEGIN_NAMESPACE
 
 namespace property::queue {
 struct enable_profiling {};
+
+// Each command group runs after the previous one submitted to the queue has completed.
+struct in_order {};
 }  // namespace property::queue
 
 struct queue {
@@ -50,9 +53,7 @@ struct queue {
 
     inline device get_device() const;
 
-    inline bool is_in_order() const {
-        return false;
-    }
+    inline bool is_in_order() const;
 
     // template <typename Param>
     // typename Param::return_type get_info() const;
@@ -72,6 +73,22 @@ struct queue {
 
     inline void throw_asynchronous();
 
+    /* -- USM functions -- */
+
+    inline event memcpy(void* dest, const void* src, size_t numBytes);
+
+    inline event memcpy(void* dest, const void* src, size_t numBytes, event depEvent);
+
+    inline event memset(void* ptr, int value, size_t numBytes);
+
+    inline event memset(void* ptr, int value, size_t numBytes, event depEvent);
+
+    template <class T>
+    inline event fill(void* ptr, const T& pattern, size_t count);
+
+    template <class T>
+    inline event fill(void* ptr, const T& pattern, size_t count, event depEvent);
+
     /* -- convenience shortcuts -- */
 
     // template <typename KernelName, typename KernelType>
@@ -44,7 +44,8 @@ inline queue::queue(const context& syclContext, const device& syclDevice, const
     : impl_(runtime::make_queue(
           runtime::impl_access::get_impl(syclContext),
           runtime::impl_access::get_impl(syclDevice),
-          runtime::get_prop<property::queue::enable_profiling>(propList))) {}
+          runtime::get_prop<property::queue::enable_profiling>(propList),
+          runtime::get_prop<property::queue::in_order>(propList))) {}
 
 inline backend queue::get_backend() const noexcept {
     return impl_->get_backend();
@@ -58,15 +59,17 @@ inline device queue::get_device() const {
     return runtime::impl_access::from_impl<device>(impl_->get_device());
 }
 
+inline bool queue::is_in_order() const {
+    return impl_->is_in_order();
+}
+
 template <typename T>
 inline event queue::submit(T cgf) {
     handler cgh(*this);
     cgf(cgh);
 
-    auto const ev = cgh.finalize();
-    impl_->add(runtime::impl_access::get_impl(ev));
-
-    return ev;
+    // The runtime adds the event to the queue when the handler is finalized.
+    return cgh.finalize();
 }
 
 inline void queue::wait() {
@@ -82,4 +85,45 @@ inline void queue::throw_asynchronous() {
     // TODO
 }
 
+inline event queue::memcpy(void* dest, const void* src, size_t numBytes) {
+    return submit([&](handler& h) {
+        h.memcpy(dest, src, numBytes);
+    });
+}
+
+inline event queue::memcpy(void* dest, const void* src, size_t numBytes, event depEvent) {
+    return submit([&](handler& h) {
+        h.depends_on(depEvent);
+        h.memcpy(dest, src, numBytes);
+    });
+}
+
+inline event queue::memset(void* ptr, int value, size_t numBytes) {
+    return submit([&](handler& h) {
+        h.memset(ptr, value, numBytes);
+    });
+}
+
+inline event queue::memset(void* ptr, int value, size_t numBytes, event depEvent) {
+    return submit([&](handler& h) {
+        h.depends_on(depEvent);
+        h.memset(ptr, value, numBytes);
+    });
+}
+
+template <class T>
+inline event queue::fill(void* ptr, const T& pattern, size_t count) {
+    return submit([&](handler& h) {
+        h.fill(ptr, pattern, count);
+    });
+}
+
+template <class T>
+inline event queue::fill(void* ptr, const T& pattern, size_t count, event depEvent) {
+    return submit([&](handler& h) {
+        h.depends_on(depEvent);
+        h.fill(ptr, pattern, count);
+    });
+}
+
 CHARM_SYCL_END_NAMESPACE
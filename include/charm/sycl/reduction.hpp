@@ -11,18 +11,92 @@ struct plus {
         -> std::conditional_t<std::is_void_v<T>, decltype(lhs + rhs), T>;
 };
 
+template <class T = void>
+struct minimum {
+    template <class Lhs, class Rhs>
+    auto operator()(Lhs&& lhs, Rhs&& rhs) const
+        -> std::conditional_t<std::is_void_v<T>, std::common_type_t<Lhs, Rhs>, T>;
+};
+
+template <class T = void>
+struct maximum {
+    template <class Lhs, class Rhs>
+    auto operator()(Lhs&& lhs, Rhs&& rhs) const
+        -> std::conditional_t<std::is_void_v<T>, std::common_type_t<Lhs, Rhs>, T>;
+};
+
+template <class T = void>
+struct bit_and {
+    template <class Lhs, class Rhs>
+    auto operator()(Lhs&& lhs, Rhs&& rhs) const
+        -> std::conditional_t<std::is_void_v<T>, decltype(lhs & rhs), T>;
+};
+
+template <class T = void>
+struct bit_or {
+    template <class Lhs, class Rhs>
+    auto operator()(Lhs&& lhs, Rhs&& rhs) const
+        -> std::conditional_t<std::is_void_v<T>, decltype(lhs | rhs), T>;
+};
+
+template <class T = void>
+struct bit_xor {
+    template <class Lhs, class Rhs>
+    auto operator()(Lhs&& lhs, Rhs&& rhs) const
+        -> std::conditional_t<std::is_void_v<T>, decltype(lhs ^ rhs), T>;
+};
+
 namespace runtime {
 bool __charm_sycl_is_reduce_leader_1();
 bool __charm_sycl_is_reduce_leader_2();
 bool __charm_sycl_is_reduce_leader_3();
 
-void __charm_sycl_reduce_initialize_f(float*);
-void __charm_sycl_reduce_combine_f(float*, float);
-void __charm_sycl_reduce_finalize_f(float*, float, bool);
+/*
+ * __charm_sycl_reduce_finalize_<op>_<type>(global, partial, is_leader) combines the partial
+ * result of a work-item into `*global`. The type suffixes follow the Itanium ABI: f=float,
+ * d=double, i=int, j=unsigned int, l=long, m=unsigned long, x=long long, y=unsigned long long.
+ */
+#define CHARM_SYCL_FOR_EACH_ARITH_OP(X, t, T) X(plus, t, T) X(minimum, t, T) X(maximum, t, T)
 
-void __charm_sycl_reduce_initialize_d(double*);
-void __charm_sycl_reduce_combine_d(double*, double);
-void __charm_sycl_reduce_finalize_d(double*, double, bool);
+#define CHARM_SYCL_FOR_EACH_INT_OP(X, t, T) \
+    CHARM_SYCL_FOR_EACH_ARITH_OP(X, t, T) X(bit_and, t, T) X(bit_or, t, T) X(bit_xor, t, T)
+
+// Calls X(t, T) for each type that has builtin implementations.
+#define CHARM_SYCL_FOR_EACH_BUILTIN_TYPE(X)                                             \
+    X(f, float) X(d, double) X(i, int) X(j, unsigned int) X(l, long) X(m, unsigned long) \
+    X(x, long long) X(y, unsigned long long)
+
+// Calls X(op, t, T) for each operation and type that has a builtin implementation.
+#define CHARM_SYCL_FOR_EACH_BUILTIN_OP(X)           \
+    CHARM_SYCL_FOR_EACH_ARITH_OP(X, f, float)       \
+    CHARM_SYCL_FOR_EACH_ARITH_OP(X, d, double)      \
+    CHARM_SYCL_FOR_EACH_INT_OP(X, i, int)           \
+    CHARM_SYCL_FOR_EACH_INT_OP(X, j, unsigned int)  \
+    CHARM_SYCL_FOR_EACH_INT_OP(X, l, long)          \
+    CHARM_SYCL_FOR_EACH_INT_OP(X, m, unsigned long) \
+    CHARM_SYCL_FOR_EACH_INT_OP(X, x, long long)     \
+    CHARM_SYCL_FOR_EACH_INT_OP(X, y, unsigned long long)
+
+#define CHARM_SYCL_DECLARE_REDUCE(op, t, T) \
+    void __charm_sycl_reduce_finalize_##op##_##t(T*, T, bool);
+
+CHARM_SYCL_FOR_EACH_BUILTIN_OP(CHARM_SYCL_DECLARE_REDUCE)
+
+#undef CHARM_SYCL_DECLARE_REDUCE
 }  // namespace runtime
 
+namespace detail {
+// Selects the builtin from the operation. Not named __charm_sycl_*: the kernel compiler keeps
+// the names of such functions unmangled.
+#define CHARM_SYCL_DEFINE_REDUCE(op, t, T)                                     \
+    template <class U>                                                         \
+    inline void reduce_finalize(op<U> const&, T* ptr, T val, bool is_leader) { \
+        runtime::__charm_sycl_reduce_finalize_##op##_##t(ptr, val, is_leader); \
+    }
+
+CHARM_SYCL_FOR_EACH_BUILTIN_OP(CHARM_SYCL_DEFINE_REDUCE)
+
+#undef CHARM_SYCL_DEFINE_REDUCE
+}  // namespace detail
+
 CHARM_SYCL_END_NAMESPACE
@@ -4,17 +4,129 @@
 
 CHARM_SYCL_BEGIN_NAMESPACE
 
+template <class T>
+template <class Lhs, class Rhs>
+inline auto plus<T>::operator()(Lhs&& lhs, Rhs&& rhs) const
+    -> std::conditional_t<std::is_void_v<T>, decltype(lhs + rhs), T> {
+    return lhs + rhs;
+}
+
+template <class T>
+template <class Lhs, class Rhs>
+inline auto minimum<T>::operator()(Lhs&& lhs, Rhs&& rhs) const
+    -> std::conditional_t<std::is_void_v<T>, std::common_type_t<Lhs, Rhs>, T> {
+    return rhs < lhs ? rhs : lhs;
+}
+
+template <class T>
+template <class Lhs, class Rhs>
+inline auto maximum<T>::operator()(Lhs&& lhs, Rhs&& rhs) const
+    -> std::conditional_t<std::is_void_v<T>, std::common_type_t<Lhs, Rhs>, T> {
+    return lhs < rhs ? rhs : lhs;
+}
+
+template <class T>
+template <class Lhs, class Rhs>
+inline auto bit_and<T>::operator()(Lhs&& lhs, Rhs&& rhs) const
+    -> std::conditional_t<std::is_void_v<T>, decltype(lhs & rhs), T> {
+    return lhs & rhs;
+}
+
+template <class T>
+template <class Lhs, class Rhs>
+inline auto bit_or<T>::operator()(Lhs&& lhs, Rhs&& rhs) const
+    -> std::conditional_t<std::is_void_v<T>, decltype(lhs | rhs), T> {
+    return lhs | rhs;
+}
+
+template <class T>
+template <class Lhs, class Rhs>
+inline auto bit_xor<T>::operator()(Lhs&& lhs, Rhs&& rhs) const
+    -> std::conditional_t<std::is_void_v<T>, decltype(lhs ^ rhs), T> {
+    return lhs ^ rhs;
+}
+
 namespace detail {
 
+// The identity of the operations supported by reducer.
+template <class BinaryOperation>
+struct known_identity;
+
+template <class T>
+struct known_identity<plus<T>> {
+    template <class U>
+    static constexpr U get() {
+        return U(0);
+    }
+};
+
+template <class T>
+struct known_identity<minimum<T>> {
+    template <class U>
+    static constexpr U get() {
+        if constexpr (std::numeric_limits<U>::has_infinity) {
+            return std::numeric_limits<U>::infinity();
+        } else {
+            return std::numeric_limits<U>::max();
+        }
+    }
+};
+
+template <class T>
+struct known_identity<maximum<T>> {
+    template <class U>
+    static constexpr U get() {
+        if constexpr (std::numeric_limits<U>::has_infinity) {
+            return -std::numeric_limits<U>::infinity();
+        } else {
+            return std::numeric_limits<U>::lowest();
+        }
+    }
+};
+
+template <class T>
+struct known_identity<bit_and<T>> {
+    template <class U>
+    static constexpr U get() {
+        return static_cast<U>(~U(0));
+    }
+};
+
+template <class T>
+struct known_identity<bit_or<T>> {
+    template <class U>
+    static constexpr U get() {
+        return U(0);
+    }
+};
+
+template <class T>
+struct known_identity<bit_xor<T>> {
+    template <class U>
+    static constexpr U get() {
+        return U(0);
+    }
+};
+
+template <class BinaryOperation, template <class> class Op>
+inline constexpr bool is_op_v = false;
+
+template <class T, template <class> class Op>
+inline constexpr bool is_op_v<Op<T>, Op> = true;
+
 template <class DataT, class OpT, class BinaryOperation, int Dimensions>
 struct reducer;
 
-template <class DataT, class OpT, class PlusT>
-struct reducer<DataT, OpT, plus<PlusT>, 0> {
+/*
+ * Each work-item, or each thread on the CPU, accumulates into its own copy of the reducer.
+ * finalize() combines the copy into the result with the builtin of the operation.
+ */
+template <class DataT, class OpT, class BinaryOperation>
+struct reducer<DataT, OpT, BinaryOperation, 0> {
     explicit reducer(accessor<DataT, 1, access_mode::discard_write> const& acc) : acc_(acc) {}
 
     explicit reducer(accessor<DataT, 1, access_mode::discard_write> const& acc,
-                     plus<PlusT> const&)
+                     BinaryOperation const&)
         : acc_(acc) {}
 
     reducer(reducer const&) = delete;
@@ -23,51 +135,47 @@ struct reducer<DataT, OpT, plus<PlusT>, 0> {
     reducer& operator=(reducer const&&) = delete;
 
     inline void initialize() {
-        if constexpr (std::is_same_v<OpT, float>) {
-            runtime::__charm_sycl_reduce_initialize_f(&val_);
-        } else if constexpr (std::is_same_v<OpT, double>) {
-            runtime::__charm_sycl_reduce_initialize_d(&val_);
-        }
+        val_ = identity();
     }
 
     inline reducer& combine(OpT const& partial) {
-        if constexpr (std::is_same_v<OpT, float>) {
-            runtime::__charm_sycl_reduce_combine_f(&val_, partial);
-        } else if constexpr (std::is_same_v<OpT, double>) {
-            runtime::__charm_sycl_reduce_combine_d(&val_, partial);
-        }
+        val_ = BinaryOperation()(val_, partial);
         return *this;
     }
 
     inline void finalize(bool is_leader) {
-        if constexpr (std::is_same_v<OpT, float>) {
-            runtime::__charm_sycl_reduce_finalize_f(acc_.get_pointer(), val_, is_leader);
-        } else if constexpr (std::is_same_v<OpT, double>) {
-            runtime::__charm_sycl_reduce_finalize_d(acc_.get_pointer(), val_, is_leader);
-        }
+        reduce_finalize(BinaryOperation(), acc_.get_pointer(), val_, is_leader);
     }
 
-    static inline constexpr auto is_zero_identity() {
-        if constexpr (std::is_same_v<OpT, float>) {
-            return true;
-        } else if constexpr (std::is_same_v<OpT, double>) {
-            return true;
-        }
+    static inline constexpr bool is_zero_identity() {
+        return identity() == DataT(0);
     }
 
-    static inline constexpr auto identity() {}
+    static inline constexpr DataT identity() {
+        return known_identity<BinaryOperation>::template get<DataT>();
+    }
 
-    static inline bool check_zero(OpT const& v) {
-        if constexpr (std::is_same_v<OpT, float>) {
-            return std::fpclassify(v) == FP_ZERO;
-        } else if constexpr (std::is_same_v<OpT, double>) {
-            return std::fpclassify(v) == FP_ZERO;
-        }
+    friend reducer& operator+=(reducer& self, OpT const& rhs)
+        requires is_op_v<BinaryOperation, plus>
+    {
+        return self.combine(rhs);
     }
 
-    // constexpr std::enable_if_t<has_known_identity_v<T>, T> identity() const;
+    friend reducer& operator&=(reducer& self, OpT const& rhs)
+        requires is_op_v<BinaryOperation, bit_and>
+    {
+        return self.combine(rhs);
+    }
+
+    friend reducer& operator|=(reducer& self, OpT const& rhs)
+        requires is_op_v<BinaryOperation, bit_or>
+    {
+        return self.combine(rhs);
+    }
 
-    friend reducer& operator+=(reducer& self, OpT const& rhs) {
+    friend reducer& operator^=(reducer& self, OpT const& rhs)
+        requires is_op_v<BinaryOperation, bit_xor>
+    {
         return self.combine(rhs);
     }
 
@@ -86,9 +194,6 @@ private:
 // operator []
 // TODO:
 // operator *=
-// operator &=
-// operator |=
-// operator ^=
 // operator ++
 
 template <class DataT, int Dimensions, class AllocatorT, class BinaryOperation>
@@ -96,15 +201,25 @@ inline auto reduction(buffer<DataT, Dimensions, AllocatorT> vars, handler& cgh,
                       std::optional<DataT>, BinaryOperation&& combiner, property_list const&) {
     using OpT = std::remove_reference_t<
         std::remove_cv_t<std::invoke_result_t<BinaryOperation, DataT, DataT>>>;
-    using R = reducer<DataT, OpT, BinaryOperation, 0>;
+    using R = reducer<DataT, OpT, std::remove_cvref_t<BinaryOperation>, 0>;
 
     auto fill_ev =
         runtime::impl_access::make<sycl::queue>(runtime::impl_access::get_queue(cgh))
             .submit([&](handler& filler) {
-                auto acc = vars.get_access(filler, write_only);
 #ifndef __SYCL_DEVICE_ONLY__
-                auto acc_ = runtime::impl_access::get_impl(acc);
-                runtime::impl_access::get_impl(filler)->fill_zero(acc_, sizeof(DataT));
+                if constexpr (R::is_zero_identity()) {
+                    auto acc = vars.get_access(filler, write_only);
+                    auto acc_ = runtime::impl_access::get_impl(acc);
+                    runtime::impl_access::get_impl(filler)->fill_zero(acc_, sizeof(DataT));
+                } else {
+                    // The copy runs asynchronously, so the source must outlive the call.
+                    static constexpr DataT identity = R::identity();
+
+                    auto acc = vars.template get_access<access_mode::write>(
+                        filler, range<Dimensions>(1));
+                    auto acc_ = runtime::impl_access::get_impl(acc);
+                    runtime::impl_access::get_impl(filler)->copy(&identity, acc_);
+                }
 #endif
             });
 
@@ -33,7 +33,7 @@ struct allocator {
     }
 
     constexpr void deallocate(pointer p, size_type) {
-        free(p);
+        ::free(p);
     }
 
     inline friend bool operator==(allocator const&, allocator const&) {
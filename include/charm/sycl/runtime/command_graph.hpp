@@ -0,0 +1,25 @@
+#pragma once
+
+#include <charm/sycl.hpp>
+
+CHARM_SYCL_BEGIN_NAMESPACE
+
+namespace runtime {
+
+struct command_graph : refcnt_base {
+    virtual ~command_graph() = default;
+
+    virtual void begin_recording() = 0;
+
+    virtual void end_recording() = 0;
+
+    virtual size_t size() const = 0;
+
+    virtual void set_arg(size_t node, size_t idx, void const* ptr, size_t size) = 0;
+
+    virtual event_ptr replay() = 0;
+};
+
+}  // namespace runtime
+
+CHARM_SYCL_END_NAMESPACE
@@ -15,6 +15,12 @@ struct event : refcnt_base {
     virtual uint64_t profiling_command_submit() = 0;
     virtual uint64_t profiling_command_start() = 0;
     virtual uint64_t profiling_command_end() = 0;
+
+    // Whether the command has finished. Backends that cannot tell without blocking
+    // return false.
+    virtual bool is_complete() const {
+        return false;
+    }
 };
 
 struct event_barrier {
@@ -7,6 +7,7 @@ namespace runtime {
 
 struct accessor;
 struct buffer;
+struct command_graph;
 struct context;
 struct device;
 struct event_barrier;
@@ -20,6 +21,7 @@ struct queue;
 
 using accessor_ptr = intrusive_ptr<accessor>;
 using buffer_ptr = intrusive_ptr<buffer>;
+using command_graph_ptr = intrusive_ptr<command_graph>;
 using context_ptr = intrusive_ptr<context>;
 using device_ptr = intrusive_ptr<device>;
 using event_ptr = intrusive_ptr<event>;
@@ -39,12 +41,20 @@ host_accessor_ptr make_host_accessor(buffer_ptr const& buf, range<3> range, id<3
                                      access_mode mode);
 
 // TODO: Use Allocator
-buffer_ptr make_buffer(void* init_ptr, size_t elemsize, range<3> const& rng);
+buffer_ptr make_buffer(void* init_ptr, size_t elemsize, range<3> const& rng,
+                       sycl::property::buffer::host_memory const*);
 
 handler_ptr make_handler(queue_ptr const&);
 
 queue_ptr make_queue(context_ptr const&, device_ptr const&,
-                     sycl::property::queue::enable_profiling const*);
+                     sycl::property::queue::enable_profiling const*,
+                     sycl::property::queue::in_order const*);
+
+command_graph_ptr make_command_graph(queue_ptr const&);
+
+void* usm_alloc(queue_ptr const&, usm::alloc kind, size_t byte);
+
+void usm_free(void* ptr);
 
 vec<platform_ptr> get_platforms();
 
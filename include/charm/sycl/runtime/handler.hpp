@@ -10,17 +10,18 @@ struct handler : refcnt_base {
 
     virtual void depends_on(event_ptr const&) = 0;
 
-    virtual void single_task(char const* name, uint32_t hash) = 0;
+    virtual void single_task(kernel_handle const& kernel) = 0;
 
-    virtual void parallel_for(range<3> const& range, char const* name, uint32_t hash) = 0;
+    virtual void parallel_for(range<3> const& range, kernel_handle const& kernel) = 0;
 
-    virtual void parallel_for(nd_range<3> const& ndr, char const* name, uint32_t hash) = 0;
+    virtual void parallel_for(nd_range<3> const& ndr, kernel_handle const& kernel) = 0;
 
     virtual void set_desc(void const* desc) = 0;
 
     virtual event_ptr finalize() = 0;
 
-    virtual void reserve_binds(size_t n) = 0;
+    // `n` binds follow, whose kernel parameters take `param_byte` bytes in total.
+    virtual void reserve_binds(size_t n, size_t param_byte) = 0;
     virtual void begin_binds() = 0;
     virtual void end_pre_binds() = 0;
     virtual void end_binds() = 0;
@@ -40,6 +41,10 @@ struct handler : refcnt_base {
     virtual void copy(void const* src, accessor_ptr const& dest) = 0;
 
     virtual void fill_zero(accessor_ptr const& src, size_t len_byte) = 0;
+
+    virtual void memcpy(void* dest, void const* src, size_t len_byte) = 0;
+
+    virtual void fill(void* dest, void const* pattern, size_t pattern_byte, size_t count) = 0;
 };
 
 }  // namespace runtime
@@ -15,6 +15,8 @@ struct queue : refcnt_base {
 
     virtual context_ptr get_context() const = 0;
 
+    virtual bool is_in_order() const = 0;
+
     virtual void add(event_ptr const&) = 0;
 
     virtual void wait() = 0;
@@ -0,0 +1,36 @@
+#pragma once
+#include <charm/sycl.hpp>
+
+CHARM_SYCL_BEGIN_NAMESPACE
+
+/*
+ * Unified shared memory.
+ *
+ * The allocations come from a caching pool of the runtime, so freeing and allocating the same
+ * sizes again does not reach the system allocator. The functions return nullptr if the backend
+ * of the queue does not support the kind of allocation. USM must be freed while the queue or
+ * another object of the same runtime is alive.
+ */
+inline void* malloc_device(size_t numBytes, const queue& syclQueue);
+
+template <class T>
+inline T* malloc_device(size_t count, const queue& syclQueue);
+
+inline void* malloc_host(size_t numBytes, const queue& syclQueue);
+
+template <class T>
+inline T* malloc_host(size_t count, const queue& syclQueue);
+
+inline void* malloc_shared(size_t numBytes, const queue& syclQueue);
+
+template <class T>
+inline T* malloc_shared(size_t count, const queue& syclQueue);
+
+inline void* malloc(size_t numBytes, const queue& syclQueue, usm::alloc kind);
+
+template <class T>
+inline T* malloc(size_t count, const queue& syclQueue, usm::alloc kind);
+
+inline void free(void* ptr, const queue& syclQueue);
+
+CHARM_SYCL_END_NAMESPACE
@@ -0,0 +1,46 @@
+#pragma once
+#include <charm/sycl.hpp>
+
+CHARM_SYCL_BEGIN_NAMESPACE
+
+inline void* malloc(size_t numBytes, const queue& syclQueue, usm::alloc kind) {
+    return runtime::usm_alloc(runtime::impl_access::get_impl(syclQueue), kind, numBytes);
+}
+
+template <class T>
+inline T* malloc(size_t count, const queue& syclQueue, usm::alloc kind) {
+    return static_cast<T*>(malloc(count * sizeof(T), syclQueue, kind));
+}
+
+inline void* malloc_device(size_t numBytes, const queue& syclQueue) {
+    return malloc(numBytes, syclQueue, usm::alloc::device);
+}
+
+template <class T>
+inline T* malloc_device(size_t count, const queue& syclQueue) {
+    return malloc<T>(count, syclQueue, usm::alloc::device);
+}
+
+inline void* malloc_host(size_t numBytes, const queue& syclQueue) {
+    return malloc(numBytes, syclQueue, usm::alloc::host);
+}
+
+template <class T>
+inline T* malloc_host(size_t count, const queue& syclQueue) {
+    return malloc<T>(count, syclQueue, usm::alloc::host);
+}
+
+inline void* malloc_shared(size_t numBytes, const queue& syclQueue) {
+    return malloc(numBytes, syclQueue, usm::alloc::shared);
+}
+
+template <class T>
+inline T* malloc_shared(size_t count, const queue& syclQueue) {
+    return malloc<T>(count, syclQueue, usm::alloc::shared);
+}
+
+inline void free(void* ptr, const queue&) {
+    runtime::usm_free(ptr);
+}
+
+CHARM_SYCL_END_NAMESPACE
@@ -2,6 +2,8 @@
 
 #include <cstdint>
 #include <cstdlib>
+#include <string>
+#include <string_view>
 
 namespace utils {
 
@@ -50,4 +52,66 @@ static_assert(fnv1a("", 0) == UINT32_C(0x811c9dc5));
 static_assert(fnv1a("a", 1) == UINT32_C(0xe40c292c));
 static_assert(fnv1a("foobar", 6) == UINT32_C(0xbf9cf968));
 
+/*
+ * FNV-1a with a 128-bit hash, which is fed incrementally. Used where collisions matter, such as
+ * the keys of a cache.
+ *
+ * https://tools.ietf.org/html/draft-eastlake-fnv-17.html
+ */
+struct fnv1a_128 {
+    __extension__ using uint128_t = unsigned __int128;
+
+    constexpr void update(char const* str, size_t len) {
+        uint128_t constexpr FNV_prime = (uint128_t(1) << 88) | 0x13b;
+
+        while (len > 0) {
+            h_ = h_ ^ static_cast<unsigned char>(*str++);
+            h_ = h_ * FNV_prime;
+            len--;
+        }
+    }
+
+    constexpr void update(std::string_view str) {
+        update(str.data(), str.size());
+    }
+
+    constexpr uint64_t high() const {
+        return static_cast<uint64_t>(h_ >> 64);
+    }
+
+    constexpr uint64_t low() const {
+        return static_cast<uint64_t>(h_);
+    }
+
+    // 32 hexadecimal digits.
+    std::string hex() const {
+        std::string s(32, '0');
+        auto h = h_;
+
+        for (size_t i = s.size(); i > 0; i--) {
+            s[i - 1] = "0123456789abcdef"[static_cast<unsigned>(h & 0xf)];
+            h >>= 4;
+        }
+
+        return s;
+    }
+
+private:
+    uint128_t h_ =
+        (uint128_t(UINT64_C(0x6c62272e07bb0142)) << 64) | UINT64_C(0x62b821756295c58d);
+};
+
+constexpr inline fnv1a_128 fnv1a_128_of(std::string_view str) {
+    fnv1a_128 h;
+    h.update(str);
+    return h;
+}
+
+static_assert(fnv1a_128_of("").high() == UINT64_C(0x6c62272e07bb0142));
+static_assert(fnv1a_128_of("").low() == UINT64_C(0x62b821756295c58d));
+static_assert(fnv1a_128_of("a").high() == UINT64_C(0xd228cb696f1a8caf));
+static_assert(fnv1a_128_of("a").low() == UINT64_C(0x78912b704e4a8964));
+static_assert(fnv1a_128_of("foobar").high() == UINT64_C(0x343e1662793c64bf));
+static_assert(fnv1a_128_of("foobar").low() == UINT64_C(0x6f0d3597ba446f18));
+
 }  // namespace utils
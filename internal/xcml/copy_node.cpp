@@ -1,6 +1,6 @@
 #include <unordered_map>
-#include <pugixml.hpp>
 #include <utils/naming.hpp>
+#include <xcml_clone.hpp>
 #include <xcml_type.hpp>
 #include <xcml_visitor.hpp>
 #include "xcml_utils.hpp"
@@ -119,24 +119,16 @@ private:
 namespace xcml {
 
 expr_ptr copy_expr_impl(xcml_program_node_ptr const& prg, expr_ptr const& node) {
-    pugi::xml_document doc;
-    xcml::to_xml(doc, node);
-
-    xcml::expr_ptr cloned;
-    xcml::make_from_xml(*doc.begin(), cloned);
-
     copy_expr_visitor vis;
-    return vis.apply(prg, cloned);
+    return vis.apply(prg, deep_copy(node));
 }
 
 compound_stmt_ptr clone_compound(compound_stmt_ptr const& node) {
-    pugi::xml_document doc;
-    xcml::to_xml(doc, node);
-
-    xcml::compound_stmt_ptr cloned;
-    xcml::make_from_xml(*doc.begin(), cloned);
+    return deep_copy(node);
+}
 
-    return cloned;
+xcml_program_node_ptr clone_program(xcml_program_node_ptr const& prg) {
+    return deep_copy(prg);
 }
 
 }  // namespace xcml
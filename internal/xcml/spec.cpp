@@ -8,7 +8,7 @@ namespace {
 static char const* SPEC = R"#(
     (N symbol_id             id                 () ((sclass sclass) (string type) (string name) (expr value) (attr* gccAttributes) (cuda_attribute* cudaAttributes)))
     (N pragma                pragma             () ((string value)))
-    (S compound_stmt         compoundStatement  () ((symbol% symbols) (decl% declarations) (stmt% body)))
+    (S compound_stmt         compoundStatement  () ((symbol% symbols) (decl% declarations) (stmt% body) (pragma* pragma)))
     (N gcc_attribute         gccAttribute       () ((string name)))
     (N cuda_attribute        cudaAttribute      () ((string value)))
     (S for_stmt              forStatement       () ((expr init) (expr condition) (expr iter) (compound body) (pragma* pragma)))
@@ -2,6 +2,7 @@
 
 // clang-format off
 #include "xcml_type.hpp"
+#include "xcml_clone.hpp"
 #include "xcml_to_xml.hpp"
 #include "xcml_from_xml.hpp"
 #include "xcml_visitor.hpp"
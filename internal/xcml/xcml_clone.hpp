@@ -0,0 +1,13 @@
+#pragma once
+
+#include "xcml_type_fwd.hpp"
+
+namespace xcml {
+
+// Structural deep copies, which share no node with the original.
+node_ptr deep_copy(node_ptr const& node);
+expr_ptr deep_copy(expr_ptr const& node);
+compound_stmt_ptr deep_copy(compound_stmt_ptr const& node);
+xcml_program_node_ptr deep_copy(xcml_program_node_ptr const& node);
+
+}  // namespace xcml
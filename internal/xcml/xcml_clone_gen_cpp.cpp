@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <fmt/format.h>
+#include "spec.hpp"
+
+namespace {
+
+std::vector<char> buffer;
+
+template <class... Args>
+void pr(char const* fmt, Args&&... args) {
+    if constexpr (sizeof...(Args) == 0) {
+        buffer.insert(buffer.end(), fmt, fmt + std::strlen(fmt));
+    } else {
+        fmt::format_to(std::back_inserter(buffer), fmt::runtime(fmt),
+                       std::forward<Args>(args)...);
+    }
+}
+
+void sep() {
+    pr("\n\n");
+}
+
+// Members that are copied by the copy constructor.
+bool is_value(std::string_view type) {
+    for (std::string_view v : {"string", "bool", "size_t", "size_t#", "sclass", "ref_scope"}) {
+        if (type == v) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool is_container(std::string_view type) {
+    return !type.empty() && (type.back() == '*' || type.back() == '%');
+}
+
+void gen_clone(spec const& spec) {
+    pr("std::shared_ptr<{}> clone(std::shared_ptr<{}> const& obj) {{", spec.name, spec.name);
+    pr("if (!obj) { return nullptr; }");
+    sep();
+    pr("auto res = std::make_shared<{}>(*obj);", spec.name);
+
+    if (spec.is_unary()) {
+        pr("res->expr = clone(res->expr);");
+    }
+    if (spec.is_binary()) {
+        pr("res->lhs = clone(res->lhs);");
+        pr("res->rhs = clone(res->rhs);");
+    }
+
+    for (auto const& [type, name] : spec.members) {
+        if (is_value(type)) {
+            continue;
+        }
+
+        if (is_container(type)) {
+            pr("clone_each(res->{});", name);
+        } else {
+            pr("res->{} = clone(res->{});", name, name);
+        }
+    }
+
+    pr("return res;");
+    pr("}");
+    sep();
+}
+
+template <class F>
+void gen_router(std::vector<spec> const& specs, std::string_view type, std::string_view kind,
+                F filter) {
+    pr("std::shared_ptr<{}> clone(std::shared_ptr<{}> const& obj) {{", type, type);
+    pr("if (!obj) { return nullptr; }");
+    sep();
+    pr("switch (obj->kind()) {");
+
+    for (auto const& spec : specs) {
+        if (filter(spec)) {
+            pr("case UINT32_C(0x{:08x}):", spec.kind());
+            pr("return clone(std::static_pointer_cast<{}>(obj));", spec.name);
+        }
+    }
+
+    pr("}");
+    sep();
+    pr(R"(throw std::runtime_error(std::string("Unknown {}: ") + )"
+       R"(std::string(obj->node_name()));)",
+       kind);
+    pr("}");
+    sep();
+}
+
+struct router {
+    std::string_view type;
+    std::string_view kind;
+    bool (*filter)(spec const&);
+};
+
+router const ROUTERS[] = {
+    {"node", "node", [](spec const&) { return true; }},
+    {"stmt_node", "stmt",
+     [](spec const& s) { return s.is_stmt() || s.is_expr() || s.is_unary() || s.is_binary(); }},
+    {"expr_node", "expr",
+     [](spec const& s) { return s.is_expr() || s.is_unary() || s.is_binary(); }},
+    {"decl_node", "decl", [](spec const& s) { return s.is_decl(); }},
+    {"type_node", "type", [](spec const& s) { return s.is_type(); }},
+    {"params_node", "param", [](spec const& s) { return s.is_param(); }},
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    auto specs = load_specs();
+
+    pr(R"(
+        #include <stdexcept>
+        #include <string>
+        #include "xcml_clone.hpp"
+        #include "xcml_type.hpp"
+
+        using namespace xcml;
+
+        namespace {
+    )");
+
+    for (auto const& spec : specs) {
+        pr("std::shared_ptr<{}> clone(std::shared_ptr<{}> const& obj);", spec.name, spec.name);
+    }
+    for (auto const& r : ROUTERS) {
+        pr("std::shared_ptr<{}> clone(std::shared_ptr<{}> const& obj);", r.type, r.type);
+    }
+    sep();
+
+    pr(R"(
+        template <class Container>
+        void clone_each(Container& nodes) {
+            for (auto& n : nodes) {
+                n = clone(n);
+            }
+        }
+
+        }
+
+        namespace xcml {
+            node_ptr deep_copy(node_ptr const& node) {
+                return clone(node);
+            }
+
+            expr_ptr deep_copy(expr_ptr const& node) {
+                return clone(node);
+            }
+
+            compound_stmt_ptr deep_copy(compound_stmt_ptr const& node) {
+                return clone(node);
+            }
+
+            xcml_program_node_ptr deep_copy(xcml_program_node_ptr const& node) {
+                return clone(node);
+            }
+        }
+
+        namespace {
+    )");
+
+    for (auto const& spec : specs) {
+        gen_clone(spec);
+    }
+    for (auto const& r : ROUTERS) {
+        gen_router(specs, r.type, r.kind, r.filter);
+    }
+
+    pr("}\n");
+
+    if (argc == 2) {
+        std::ofstream ofs(argv[1]);
+        ofs.write(buffer.data(), buffer.size());
+    } else {
+        std::cout.write(buffer.data(), buffer.size());
+    }
+
+    return 0;
+}
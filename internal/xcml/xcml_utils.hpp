@@ -59,6 +59,9 @@ inline void clear_extra(xcml_program_node_ptr prg) {
 
 compound_stmt_ptr clone_compound(compound_stmt_ptr const& node);
 
+// Returns a deep copy of `prg` that shares no node with it.
+xcml_program_node_ptr clone_program(xcml_program_node_ptr const& prg);
+
 expr_ptr copy_expr_impl(xcml_program_node_ptr const& prg, expr_ptr const& node);
 
 template <class Expr>
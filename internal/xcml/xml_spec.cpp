@@ -32,6 +32,9 @@ static char const* XML_SPEC = R"#(
 (pragma ()
     value)
 (compound_stmt ()
+    (.if pragma
+        (pragma ()
+            (.for-each pragma)))
     (symbols ()
         (.for-each symbols))
     (declarations ()
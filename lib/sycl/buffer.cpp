@@ -1,17 +1,66 @@
 #include <charm/sycl.hpp>
+#include "host_memory.hpp"
 #include "rt.hpp"
 
 CHARM_SYCL_BEGIN_NAMESPACE
 
 namespace runtime::impl {
 
-buffer_impl::buffer_impl(void* init_ptr, size_t elemsize, sycl::range<3> const& rng)
+namespace {
+
+dep::host_memory_policy to_policy(sycl::property::buffer::host_memory const* host_mem) {
+    using prop = sycl::property::buffer::host_memory;
+
+    if (!host_mem) {
+        return dep::host_memory_policy::from_env();
+    }
+
+    dep::host_memory_policy p;
+
+    switch (host_mem->place) {
+        case prop::placement::first_touch:
+            p.place = dep::host_memory_policy::placement::first_touch;
+            break;
+
+        case prop::placement::interleave:
+            p.place = dep::host_memory_policy::placement::interleave;
+            break;
+
+        case prop::placement::bind:
+            p.place = dep::host_memory_policy::placement::bind;
+            break;
+    }
+
+    switch (host_mem->page) {
+        case prop::pages::normal:
+            p.page = dep::host_memory_policy::pages::normal;
+            break;
+
+        case prop::pages::transparent_huge:
+            p.page = dep::host_memory_policy::pages::transparent_huge;
+            break;
+
+        case prop::pages::huge:
+            p.page = dep::host_memory_policy::pages::huge;
+            break;
+    }
+
+    p.node = host_mem->node;
+    p.requested = true;
+
+    return p;
+}
+
+}  // namespace
+
+buffer_impl::buffer_impl(void* init_ptr, size_t elemsize, sycl::range<3> const& rng,
+                         sycl::property::buffer::host_memory const* host_mem)
     : elemsize_(elemsize),
       range_(rng),
       write_back_(false),
       write_back_ptr_(nullptr),
-      dep_(impl::global_state::get_depmgr()->new_buffer(init_ptr, elemsize,
-                                                        impl::convert(rng))) {}
+      dep_(impl::global_state::get_depmgr()->new_buffer(init_ptr, elemsize, impl::convert(rng),
+                                                        to_policy(host_mem))) {}
 
 void buffer_impl::write_back() {
     write_back(dep::memory_access::read_write);
@@ -49,7 +98,8 @@ void buffer_impl::do_writeback(dep::memory_access acc) {
     task->set_host_fn();
     task->begin_params();
     try {
-        task->set_buffer_param(*dep_, acc, dep::id(), 0);
+        task->set_buffer_param(*dep_, acc, dep::id(),
+                               dep::range(range_[0], range_[1], range_[2]), 0);
     } catch (...) {
         task->end_params();
         throw;
@@ -79,16 +129,18 @@ size_t buffer_impl::elem_size() const {
     return elemsize_;
 }
 
-intrusive_ptr<buffer_impl> make_buffer(void* init_ptr, size_t elemsize, range<3> const& rng) {
-    return make_intrusive<buffer_impl>(init_ptr, elemsize, rng);
+intrusive_ptr<buffer_impl> make_buffer(void* init_ptr, size_t elemsize, range<3> const& rng,
+                                       sycl::property::buffer::host_memory const* host_mem) {
+    return make_intrusive<buffer_impl>(init_ptr, elemsize, rng, host_mem);
 }
 
 }  // namespace runtime::impl
 
 namespace runtime {
 
-intrusive_ptr<buffer> make_buffer(void* init_ptr, size_t elemsize, range<3> const& rng) {
-    return impl::make_buffer(init_ptr, elemsize, rng);
+intrusive_ptr<buffer> make_buffer(void* init_ptr, size_t elemsize, range<3> const& rng,
+                                  sycl::property::buffer::host_memory const* host_mem) {
+    return impl::make_buffer(init_ptr, elemsize, rng, host_mem);
 }
 
 }  // namespace runtime
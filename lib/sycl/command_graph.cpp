@@ -0,0 +1,620 @@
+#include <charm/sycl.hpp>
+#include "rt.hpp"
+#include <algorithm>
+#include <variant>
+
+CHARM_SYCL_BEGIN_NAMESPACE
+
+namespace runtime::impl {
+
+namespace {
+
+struct recorded_event_barrier final : runtime::event_barrier {
+    void add(runtime::event&) override {}
+
+    void wait() override {}
+};
+
+// Returned to a command group submitted while recording. Nothing is executed, so there is
+// nothing to wait for, and the event has no status: the command group runs once per replay,
+// whose event tells whether it has completed.
+struct recorded_event final : dep::event {
+    explicit recorded_event(command_graph_impl const* graph, size_t idx)
+        : graph(graph), idx(idx) {}
+
+    runtime::event_barrier* create_barrier() override {
+        return new recorded_event_barrier();
+    }
+
+    void release_barrier(runtime::event_barrier* ptr) override {
+        delete ptr;
+    }
+
+    uint64_t profiling_command_submit() override {
+        return 0;
+    }
+
+    uint64_t profiling_command_start() override {
+        return 0;
+    }
+
+    uint64_t profiling_command_end() override {
+        return 0;
+    }
+
+    bool is_complete() const override {
+        throw_error(errc::invalid, "a recorded command group has no status");
+    }
+
+    // The graph and the index of the recorded command group.
+    command_graph_impl const* graph;
+    size_t idx;
+};
+
+using node = command_graph_impl::node;
+
+// The calls of a handler, which are repeated on the task of a replay. Their values are resolved
+// when they are recorded, except the scalar parameters, which set_arg() may replace.
+namespace op {
+
+struct enable_profiling {
+    void operator()(dep::task& t, node const&) const {
+        t.enable_profiling();
+    }
+};
+
+struct use_device {
+    dep::device* dev;
+
+    void operator()(dep::task& t, node const&) const {
+        t.use_device(*dev);
+    }
+};
+
+struct use_host {
+    void operator()(dep::task& t, node const&) const {
+        t.use_host();
+    }
+};
+
+struct set_host_fn {
+    std::function<void()> f;
+
+    void operator()(dep::task& t, node const&) const {
+        t.set_host_fn(f);
+    }
+};
+
+// The handle of a kernel lives as long as the program.
+struct set_kernel {
+    runtime::kernel_handle const* kernel;
+
+    void operator()(dep::task& t, node const&) const {
+        t.set_kernel(*kernel);
+    }
+};
+
+struct set_single {
+    void operator()(dep::task& t, node const&) const {
+        t.set_single();
+    }
+};
+
+struct set_range {
+    dep::range range;
+
+    void operator()(dep::task& t, node const&) const {
+        t.set_range(range);
+    }
+};
+
+struct set_nd_range {
+    dep::nd_range ndr;
+
+    void operator()(dep::task& t, node const&) const {
+        t.set_nd_range(ndr);
+    }
+};
+
+struct set_local_mem_size {
+    size_t byte;
+
+    void operator()(dep::task& t, node const&) const {
+        t.set_local_mem_size(byte);
+    }
+};
+
+// A buffer is null if the side of the copy is a host pointer.
+struct copy {
+    int dim;
+    std::shared_ptr<dep::buffer> src_buf;
+    void const* src;
+    dep::memory_access src_acc;
+    size_t src_off_byte;
+    size_t i_src_stride;
+    size_t j_src_stride;
+    std::shared_ptr<dep::buffer> dst_buf;
+    void* dst;
+    dep::memory_access dst_acc;
+    size_t dst_off_byte;
+    size_t i_dst_stride;
+    size_t j_dst_stride;
+    size_t i_loop;
+    size_t j_loop;
+    size_t len_byte;
+
+    void operator()(dep::task& t, node const&) const;
+};
+
+void copy::operator()(dep::task& t, node const&) const {
+    switch (dim) {
+        case 1:
+            if (!dst_buf) {
+                t.copy_1d(*src_buf, src_acc, src_off_byte, dst, len_byte);
+            } else if (!src_buf) {
+                t.copy_1d(src, *dst_buf, dst_acc, dst_off_byte, len_byte);
+            } else {
+                t.copy_1d(*src_buf, src_acc, src_off_byte, *dst_buf, dst_acc, dst_off_byte,
+                          len_byte);
+            }
+            break;
+
+        case 2:
+            if (!dst_buf) {
+                t.copy_2d(*src_buf, src_acc, src_off_byte, i_src_stride, dst, i_dst_stride,
+                          i_loop, len_byte);
+            } else if (!src_buf) {
+                t.copy_2d(src, i_src_stride, *dst_buf, dst_acc, dst_off_byte, i_dst_stride,
+                          i_loop, len_byte);
+            } else {
+                t.copy_2d(*src_buf, src_acc, src_off_byte, i_src_stride, *dst_buf, dst_acc,
+                          dst_off_byte, i_dst_stride, i_loop, len_byte);
+            }
+            break;
+
+        default:
+            if (!dst_buf) {
+                t.copy_3d(*src_buf, src_acc, src_off_byte, i_src_stride, j_src_stride, dst,
+                          i_dst_stride, j_dst_stride, i_loop, j_loop, len_byte);
+            } else if (!src_buf) {
+                t.copy_3d(src, i_src_stride, j_src_stride, *dst_buf, dst_acc, dst_off_byte,
+                          i_dst_stride, j_dst_stride, i_loop, j_loop, len_byte);
+            } else {
+                t.copy_3d(*src_buf, src_acc, src_off_byte, i_src_stride, j_src_stride,
+                          *dst_buf, dst_acc, dst_off_byte, i_dst_stride, j_dst_stride, i_loop,
+                          j_loop, len_byte);
+            }
+            break;
+    }
+}
+
+struct fill_zero {
+    std::shared_ptr<dep::buffer> dst;
+    size_t len_byte;
+
+    void operator()(dep::task& t, node const&) const {
+        t.fill_zero(*dst, len_byte);
+    }
+};
+
+struct copy_usm {
+    void const* src;
+    void* dst;
+    size_t len_byte;
+
+    void operator()(dep::task& t, node const&) const {
+        t.copy_usm(src, dst, len_byte);
+    }
+};
+
+struct fill_usm {
+    void* dst;
+    std::vector<std::byte> pattern;
+    size_t count;
+
+    void operator()(dep::task& t, node const&) const {
+        t.fill_usm(dst, pattern.data(), pattern.size(), count);
+    }
+};
+
+struct set_desc {
+    rts::func_desc const* desc;
+
+    void operator()(dep::task& t, node const&) const {
+        t.set_desc(desc);
+    }
+};
+
+struct begin_params {
+    size_t n_params;
+    size_t param_byte;
+
+    void operator()(dep::task& t, node const&) const {
+        t.begin_params(n_params, param_byte);
+    }
+};
+
+struct use_buffer {
+    std::shared_ptr<dep::buffer> buf;
+
+    void operator()(dep::task& t, node const&) const {
+        t.use_buffer(*buf);
+    }
+};
+
+struct set_param {
+    size_t idx;
+
+    void operator()(dep::task& t, node const& n) const;
+};
+
+struct set_buffer_param {
+    std::shared_ptr<dep::buffer> buf;
+    dep::memory_access acc;
+    dep::id offset;
+    dep::range range;
+    size_t offset_byte;
+
+    void operator()(dep::task& t, node const&) const {
+        t.set_buffer_param(*buf, acc, offset, range, offset_byte);
+    }
+};
+
+struct end_params {
+    void operator()(dep::task& t, node const&) const {
+        t.end_params();
+    }
+};
+
+using any = std::variant<enable_profiling, use_device, use_host, set_host_fn, set_kernel,
+                         set_single, set_range, set_nd_range, set_local_mem_size, copy,
+                         fill_zero, copy_usm, fill_usm, set_desc, begin_params, use_buffer,
+                         set_param, set_buffer_param, end_params>;
+
+}  // namespace op
+
+}  // namespace
+
+// `ops` repeats the calls made to the task of the dependency manager; the scalar parameters are
+// kept in `params` so that they can be replaced. The node runs after the nodes at `preds` and
+// after `events`, which are not recorded.
+struct command_graph_impl::node {
+    std::vector<op::any> ops;
+    std::vector<std::vector<std::byte>> params;
+    std::vector<size_t> preds;
+    std::vector<runtime::event_ptr> events;
+};
+
+namespace {
+
+void op::set_param::operator()(dep::task& t, node const& n) const {
+    t.set_param(n.params[idx].data(), n.params[idx].size());
+}
+
+// Records the calls of a handler into a node.
+struct recording_task final : dep::task {
+    explicit recording_task(command_graph_impl& graph)
+        : graph_(graph), node_(std::make_unique<node>()) {}
+
+    void add_dependency(runtime::event_ptr const& ev) {
+        if (auto const* rec = dynamic_cast<recorded_event const*>(ev.get())) {
+            if (rec->graph != &graph_) {
+                throw_error(errc::invalid, "the event belongs to another command_graph");
+            }
+
+            node_->preds.push_back(rec->idx);
+        } else {
+            node_->events.push_back(ev);
+        }
+    }
+
+    void enable_profiling() override {
+        add(op::enable_profiling{});
+    }
+
+    // The dependencies are given to add_dependency().
+    void depends_on(dep::event const&) override {}
+
+    void depends_on(std::shared_ptr<dep::task> const&) override {}
+
+    void set_chain(uint64_t) override {}
+
+    void use_device(dep::device& dev) override {
+        add(op::use_device{&dev});
+    }
+
+    void use_host() override {
+        add(op::use_host{});
+    }
+
+    void set_host_fn(std::function<void()> const& f) override {
+        add(op::set_host_fn{f});
+    }
+
+    void set_kernel(runtime::kernel_handle const& kernel) override {
+        add(op::set_kernel{&kernel});
+    }
+
+    void set_single() override {
+        add(op::set_single{});
+    }
+
+    void set_range(dep::range const& range) override {
+        add(op::set_range{range});
+    }
+
+    void set_nd_range(dep::nd_range const& ndr) override {
+        add(op::set_nd_range{ndr});
+    }
+
+    void set_local_mem_size(size_t byte) override {
+        add(op::set_local_mem_size{byte});
+    }
+
+    void copy_1d(dep::buffer& src, dep::memory_access src_acc, size_t src_off_byte,
+                 dep::buffer& dst, dep::memory_access dst_acc, size_t dst_off_byte,
+                 size_t len_byte) override {
+        add(op::copy{1, src.shared_from_this(), nullptr, src_acc, src_off_byte, 0, 0,
+                     dst.shared_from_this(), nullptr, dst_acc, dst_off_byte, 0, 0, 0, 0,
+                     len_byte});
+    }
+
+    void copy_1d(dep::buffer& src, dep::memory_access src_acc, size_t src_off_byte, void* dst,
+                 size_t len_byte) override {
+        add(op::copy{1, src.shared_from_this(), nullptr, src_acc, src_off_byte, 0, 0, nullptr,
+                     dst, {}, 0, 0, 0, 0, 0, len_byte});
+    }
+
+    void copy_1d(void const* src, dep::buffer& dst, dep::memory_access dst_acc,
+                 size_t dst_off_byte, size_t len_byte) override {
+        add(op::copy{1, nullptr, src, {}, 0, 0, 0, dst.shared_from_this(), nullptr, dst_acc,
+                     dst_off_byte, 0, 0, 0, 0, len_byte});
+    }
+
+    void copy_2d(dep::buffer& src, dep::memory_access src_acc, size_t src_off_byte,
+                 size_t src_stride, dep::buffer& dst, dep::memory_access dst_acc,
+                 size_t dst_off_byte, size_t dst_stride, size_t loop,
+                 size_t len_byte) override {
+        add(op::copy{2, src.shared_from_this(), nullptr, src_acc, src_off_byte, src_stride, 0,
+                     dst.shared_from_this(), nullptr, dst_acc, dst_off_byte, dst_stride, 0,
+                     loop, 0, len_byte});
+    }
+
+    void copy_2d(dep::buffer& src, dep::memory_access src_acc, size_t src_off_byte,
+                 size_t src_stride, void* dst, size_t dst_stride, size_t loop,
+                 size_t len_byte) override {
+        add(op::copy{2, src.shared_from_this(), nullptr, src_acc, src_off_byte, src_stride, 0,
+                     nullptr, dst, {}, 0, dst_stride, 0, loop, 0, len_byte});
+    }
+
+    void copy_2d(void const* src, size_t src_stride, dep::buffer& dst,
+                 dep::memory_access dst_acc, size_t dst_off_byte, size_t dst_stride,
+                 size_t loop, size_t len_byte) override {
+        add(op::copy{2, nullptr, src, {}, 0, src_stride, 0, dst.shared_from_this(), nullptr,
+                     dst_acc, dst_off_byte, dst_stride, 0, loop, 0, len_byte});
+    }
+
+    void copy_3d(dep::buffer& src, dep::memory_access src_acc, size_t src_off_byte,
+                 size_t i_src_stride, size_t j_src_stride, dep::buffer& dst,
+                 dep::memory_access dst_acc, size_t dst_off_byte, size_t i_dst_stride,
+                 size_t j_dst_stride, size_t i_loop, size_t j_loop, size_t len_byte) override {
+        add(op::copy{3, src.shared_from_this(), nullptr, src_acc, src_off_byte, i_src_stride,
+                     j_src_stride, dst.shared_from_this(), nullptr, dst_acc, dst_off_byte,
+                     i_dst_stride, j_dst_stride, i_loop, j_loop, len_byte});
+    }
+
+    void copy_3d(dep::buffer& src, dep::memory_access src_acc, size_t src_off_byte,
+                 size_t i_src_stride, size_t j_src_stride, void* dst, size_t i_dst_stride,
+                 size_t j_dst_stride, size_t i_loop, size_t j_loop, size_t len_byte) override {
+        add(op::copy{3, src.shared_from_this(), nullptr, src_acc, src_off_byte, i_src_stride,
+                     j_src_stride, nullptr, dst, {}, 0, i_dst_stride, j_dst_stride, i_loop,
+                     j_loop, len_byte});
+    }
+
+    void copy_3d(void const* src, size_t i_src_stride, size_t j_src_stride, dep::buffer& dst,
+                 dep::memory_access dst_acc, size_t dst_off_byte, size_t i_dst_stride,
+                 size_t j_dst_stride, size_t i_loop, size_t j_loop, size_t len_byte) override {
+        add(op::copy{3, nullptr, src, {}, 0, i_src_stride, j_src_stride, dst.shared_from_this(),
+                     nullptr, dst_acc, dst_off_byte, i_dst_stride, j_dst_stride, i_loop, j_loop,
+                     len_byte});
+    }
+
+    void fill_zero(dep::buffer& dst, size_t len_byte) override {
+        add(op::fill_zero{dst.shared_from_this(), len_byte});
+    }
+
+    void copy_usm(void const* src, void* dst, size_t len_byte) override {
+        add(op::copy_usm{src, dst, len_byte});
+    }
+
+    void fill_usm(void* dst, void const* pattern, size_t pattern_byte, size_t count) override {
+        auto const* p = static_cast<std::byte const*>(pattern);
+
+        add(op::fill_usm{dst, std::vector<std::byte>(p, p + pattern_byte), count});
+    }
+
+    void set_desc(rts::func_desc const* desc) override {
+        add(op::set_desc{desc});
+    }
+
+    void begin_params(size_t n_params, size_t param_byte) override {
+        add(op::begin_params{n_params, param_byte});
+    }
+
+    void use_buffer(dep::buffer& buf) override {
+        add(op::use_buffer{buf.shared_from_this()});
+    }
+
+    void set_param(void const* ptr, size_t size) override {
+        auto const* p = static_cast<std::byte const*>(ptr);
+
+        add(op::set_param{node_->params.size()});
+        node_->params.emplace_back(p, p + size);
+    }
+
+    void set_buffer_param(dep::buffer& buf, dep::memory_access acc, dep::id const& offset,
+                          dep::range const& range, size_t offset_byte) override {
+        add(op::set_buffer_param{buf.shared_from_this(), acc, offset, range, offset_byte});
+    }
+
+    void end_params() override {
+        add(op::end_params{});
+    }
+
+    std::unique_ptr<dep::event> submit() override {
+        auto const idx = graph_.size();
+
+        graph_.add(std::move(node_));
+        return std::make_unique<recorded_event>(&graph_, idx);
+    }
+
+private:
+    template <class Op>
+    void add(Op&& op) {
+        node_->ops.emplace_back(std::forward<Op>(op));
+    }
+
+    command_graph_impl& graph_;
+    std::unique_ptr<node> node_;
+};
+
+}  // namespace
+
+bool is_recorded_event(runtime::event const& ev) {
+    return dynamic_cast<recorded_event const*>(&ev) != nullptr;
+}
+
+bool record_dependency(dep::task& task, runtime::event_ptr const& ev) {
+    auto* rec = dynamic_cast<recording_task*>(&task);
+
+    if (rec == nullptr) {
+        return false;
+    }
+
+    rec->add_dependency(ev);
+    return true;
+}
+
+command_graph_impl::command_graph_impl(intrusive_ptr<queue_impl> const& q) : q_(q) {}
+
+command_graph_impl::~command_graph_impl() {
+    if (recording_) {
+        q_->stop_recording();
+    }
+}
+
+void command_graph_impl::begin_recording() {
+    if (recording_ || !q_->start_recording(this)) {
+        throw_error(errc::invalid, "the queue is already being recorded");
+    }
+
+    plan_.reset();
+    nodes_.clear();
+    recording_ = true;
+}
+
+void command_graph_impl::end_recording() {
+    if (!recording_) {
+        throw_error(errc::invalid, "the graph is not being recorded");
+    }
+
+    q_->stop_recording();
+    recording_ = false;
+}
+
+size_t command_graph_impl::size() const {
+    return nodes_.size();
+}
+
+void command_graph_impl::set_arg(size_t n, size_t idx, void const* ptr, size_t size) {
+    if (n >= nodes_.size() || idx >= nodes_[n]->params.size()) {
+        throw_error(errc::invalid, "no such parameter in the graph");
+    }
+
+    auto& param = nodes_[n]->params[idx];
+
+    if (param.size() != size) {
+        throw_error(errc::kernel_argument, "the size of the parameter does not match");
+    }
+
+    std::memcpy(param.data(), ptr, size);
+}
+
+runtime::event_ptr command_graph_impl::replay() {
+    if (recording_) {
+        throw_error(errc::invalid, "the graph is being recorded");
+    }
+
+    if (!plan_) {
+        plan_ = global_state::get_depmgr()->new_task_graph();
+    }
+
+    // On an in-order queue, the graph runs after the previous command group.
+    auto order = q_->lock_order();
+    auto prev = q_->pending_event();
+    auto const* after = prev ? static_cast<dep::event const*>(prev.get()) : nullptr;
+
+    plan_->begin(after);
+
+    try {
+        for (auto const& n : nodes_) {
+            auto task = plan_->new_task(n->preds);
+
+            for (auto const& e : n->events) {
+                task->depends_on(*static_pointer_cast<dep::event>(e));
+            }
+
+            try {
+                for (auto const& op : n->ops) {
+                    std::visit(
+                        [&](auto const& f) {
+                            f(*task, *n);
+                        },
+                        op);
+                }
+            } catch (...) {
+                task->end_params();
+                throw;
+            }
+
+            task->submit();
+        }
+    } catch (...) {
+        plan_->cancel();
+        throw;
+    }
+
+    auto ev = plan_->finish();
+
+    auto res = make_event(std::move(ev));
+    q_->add(res);
+    return res;
+}
+
+std::shared_ptr<dep::task> command_graph_impl::new_task() {
+    return std::make_shared<recording_task>(*this);
+}
+
+void command_graph_impl::add(std::unique_ptr<node>&& n) {
+    // On an in-order queue, each command group runs after the previous one.
+    if (q_->is_in_order() && !nodes_.empty()) {
+        n->preds.push_back(nodes_.size() - 1);
+    }
+
+    std::sort(n->preds.begin(), n->preds.end());
+    n->preds.erase(std::unique(n->preds.begin(), n->preds.end()), n->preds.end());
+
+    nodes_.push_back(std::move(n));
+}
+
+}  // namespace runtime::impl
+
+namespace runtime {
+
+intrusive_ptr<command_graph> make_command_graph(intrusive_ptr<queue> const& q) {
+    return make_intrusive<impl::command_graph_impl>(static_pointer_cast<impl::queue_impl>(q));
+}
+
+}  // namespace runtime
+
+CHARM_SYCL_END_NAMESPACE
@@ -10,6 +10,7 @@
 #include "../logging.hpp"
 #include "context.hpp"
 #include "dev_rts/coarse_task.hpp"
+#include "dev_rts/kernel_cache.hpp"
 
 using CUDA = sycl::runtime::cuda_interface;
 using BLAS = sycl::runtime::cublas_interface_11000;
@@ -49,6 +50,12 @@ namespace rts = sycl::rts;
 
 LOGGING_DEFINE_SCOPE(cuda)
 
+// The functions resolved from the module. They are reset when the module is unloaded.
+dev_rts::kernel_cache& functions() {
+    static dev_rts::kernel_cache cache(sycl::runtime::kernel_handle::CUDA);
+    return cache;
+}
+
 template <class CUDA>
 inline void check_cuda_error(typename CUDA::result_t err, char const* expr) {
     if (err != CUDA::k_CUDA_SUCCESS) {
@@ -401,7 +408,15 @@ struct kernel_op : dev_rts::op_base {
         }
 
         function_t fn;
-        _(CUDA::cu_module_get_function(&fn, mod_, desc_->name));
+        if (auto const* kernel = desc_->kernel) {
+            fn = function_t(functions().get(*kernel, [&] {
+                function_t f;
+                _(CUDA::cu_module_get_function(&f, mod_, kernel->name));
+                return f.get();
+            }));
+        } else {
+            _(CUDA::cu_module_get_function(&fn, mod_, desc_->name));
+        }
 
         if (desc_->is_ndr) {
             auto const gz = desc_->range[0];
@@ -415,7 +430,7 @@ struct kernel_op : dev_rts::op_base {
                       format::ptr(this), desc_->name, gx, gy, gz, bx, by, bz, desc_->lmem,
                       format::ptr(*stream));
             _(CUDA::cu_launch_kernel(fn, gx, gy, gz, bx, by, bz, desc_->lmem, stream,
-                                     desc_->args.data(), nullptr));
+                                     desc_->params.data(), nullptr));
         } else {
             unsigned gx, gy, gz, bx, by, bz;
             heuristic(gx, gy, gz, bx, by, bz);
@@ -425,7 +440,7 @@ struct kernel_op : dev_rts::op_base {
                       format::ptr(*stream));
 
             _(CUDA::cu_launch_kernel(fn, gx, gy, gz, bx, by, bz, desc_->lmem, stream,
-                                     desc_->args.data(), nullptr));
+                                     desc_->params.data(), nullptr));
         }
     }
 
@@ -482,26 +497,38 @@ private:
     }
 
     void set_buffer_param(rts::buffer& buf, void* h_ptr, rts::memory_domain const& dom,
-                          rts::memory_access ma, rts::id const&, size_t offset_byte) override {
+                          rts::memory_access ma, rts::id const&, size_t offset_byte,
+                          rts::region_list const& xfer) override {
+        if (ma != rts::memory_access::write_only) {
+            transfer(buf, h_ptr, dom, xfer);
+        }
+
+        auto const devptr = get_ptr(buf, offset_byte);
+        k_.add_param(devptr);
+    }
+
+    void transfer(rts::buffer& buf, void* h_ptr, rts::memory_domain const& src,
+                  rts::region_list const& xfer) override {
         auto& buf_ = static_cast<buffer_t&>(buf);
         auto const is_device_task = k_.is_device;
-        auto const htod =
-            (ma != rts::memory_access::write_only) && is_device_task && dom.is_host();
-        auto const dtoh =
-            (ma != rts::memory_access::write_only) && !is_device_task && !dom.is_host();
+        auto const htod = is_device_task && src.is_host();
+        auto const dtoh = !is_device_task && !src.is_host();
 
         DEBUG_FMT("this={} {}(htod={}, dtoh={})", format::ptr(this), __func__, htod, dtoh);
 
-        if (htod) {
-            commit(make_copy_1d_op(h_ptr, buf_, 0, buf_.byte_size()));
-        } else if (dtoh) {
-            commit(make_copy_1d_op(buf_, 0, h_ptr, buf_.byte_size()));
-        } else {
-            commit();
+        std::vector<dev_rts::op_ptr> ops;
+
+        for (auto const& r : xfer) {
+            auto* h_ptr_r = ::dev_rts::advance_ptr(h_ptr, r.begin);
+
+            if (htod) {
+                ops.push_back(make_copy_1d_op(h_ptr_r, buf_, r.begin, r.size()));
+            } else if (dtoh) {
+                ops.push_back(make_copy_1d_op(buf_, r.begin, h_ptr_r, r.size()));
+            }
         }
 
-        auto const devptr = get_ptr(buf, offset_byte);
-        k_.add_param(devptr);
+        commit(std::move(ops));
     }
 
     dev_rts::op_ptr make_kernel_op() override {
@@ -717,6 +744,8 @@ struct subsystem_impl final : ::dev_rts::subsystem_base<platform_impl, buffer_im
         // q_task.reset();
         sycl::runtime::cuda_contexts<CUDA, BLAS, SOL>::workspaces.clear();
 
+        functions().clear();
+
         result_t err1 = CUDA::k_CUDA_SUCCESS;
         if (mod_) {
             err1 = CUDA::cu_module_unload(mod_);
@@ -1,8 +1,13 @@
 #include "dep.hpp"
+#include <algorithm>
 #include <atomic>
+#include <deque>
 #include <mutex>
 #include <thread>
+#include <vector>
 #include <assert.h>
+#include "dev_rts/pool.hpp"
+#include "host_memory.hpp"
 #include "logging.hpp"
 #include "rts.hpp"
 
@@ -13,16 +18,14 @@ LOGGING_DEFINE_SCOPE(dep)
 namespace dep = CHARM_SYCL_NS::dep;
 namespace rts = CHARM_SYCL_NS::rts;
 
-static std::mutex g_lock;
-
 constexpr uint64_t HOST_INIT_VER = 1;
 constexpr uint64_t DEV_INIT_VER = 0;
 
-struct delete_by_free {
-    void operator()(void* p) const {
-        free(p);
-    }
-};
+// The bytes that a 3D copy touches, from its first element to the end of its last one.
+dep::region region_3d(size_t off_byte, size_t i_stride, size_t j_stride, size_t i_loop,
+                      size_t j_loop, size_t len_byte) {
+    return {off_byte, off_byte + (i_loop - 1) * i_stride + (j_loop - 1) * j_stride + len_byte};
+}
 
 struct device_impl final : dep::device {
     explicit device_impl(std::shared_ptr<dep::dependency_manager> const& mgr,
@@ -118,6 +121,15 @@ private:
     std::shared_ptr<rts::platform> rts_;
 };
 
+// The parts of a region that are stale in a memory domain and hold their latest version in
+// `src`.
+struct stale_part {
+    dep::memory_domain const* src;
+    dep::region_list xfer;
+};
+
+using stale_list = std::vector<stale_part>;
+
 struct dependency_manager_impl final : std::enable_shared_from_this<dependency_manager_impl>,
                                        dep::dependency_manager {
     explicit dependency_manager_impl(std::shared_ptr<rts::subsystem> const& ss) : ss_(ss) {
@@ -130,143 +142,270 @@ struct dependency_manager_impl final : std::enable_shared_from_this<dependency_m
 
     std::shared_ptr<dep::task> new_task() override;
 
-    std::unique_ptr<dep::buffer> new_buffer(void* h_ptr, size_t element_size,
-                                            rts::range size) override;
+    std::unique_ptr<dep::task_graph> new_task_graph() override;
+
+    std::unique_ptr<dep::buffer> new_buffer(void* h_ptr, size_t element_size, rts::range size,
+                                            dep::host_memory_policy const& policy) override;
 
     std::vector<std::shared_ptr<dep::platform>> get_platforms() override;
 
-    void local_read(std::shared_ptr<rts::task> const& task, dep::buffer& buf,
-                    dep::memory_domain const& dom);
+    void* usm_alloc(usm::alloc kind, size_t byte) override {
+        return ss_->usm_alloc(kind, byte);
+    }
+
+    bool usm_free(void* ptr) override {
+        return ss_->usm_free(ptr);
+    }
 
-    void local_write(std::shared_ptr<rts::task> const& task, dep::buffer& buf,
-                     dep::memory_domain const& dom);
+    // `chain` identifies the in-order queue of `task`, or is 0. See dep::task::set_chain.
+    void local_read(std::shared_ptr<rts::task> const& task, uint64_t chain, dep::buffer& buf,
+                    dep::memory_domain const& dom, dep::region const& r);
 
-    void local_read_write(std::shared_ptr<rts::task> const& task, dep::buffer& buf,
-                          dep::memory_domain const& dom);
+    void local_write(std::shared_ptr<rts::task> const& task, uint64_t chain, dep::buffer& buf,
+                     dep::memory_domain const& dom, dep::region const& r);
 
-    void transfer_read(std::shared_ptr<rts::task> const& task, dep::buffer& buf,
-                       dep::memory_domain const& src, dep::memory_domain const& dst);
+    void local_read_write(std::shared_ptr<rts::task> const& task, uint64_t chain,
+                          dep::buffer& buf, dep::memory_domain const& dom,
+                          dep::region const& r);
 
-    void transfer_write(std::shared_ptr<rts::task> const& task, dep::buffer& buf,
-                        dep::memory_domain const& src, dep::memory_domain const& dst);
+    void transfer_read(std::shared_ptr<rts::task> const& task, uint64_t chain,
+                       dep::buffer& buf, dep::memory_domain const& dst, dep::region const& r,
+                       stale_list const& stale);
 
-    void transfer_read_write(std::shared_ptr<rts::task> const& task, dep::buffer& buf,
-                             dep::memory_domain const& src, dep::memory_domain const& dst);
+    void transfer_read_write(std::shared_ptr<rts::task> const& task, uint64_t chain,
+                             dep::buffer& buf, dep::memory_domain const& dst,
+                             dep::region const& r, stale_list const& stale);
 
     dep::memory_domain& get_host_memory_domain() {
         return ss_->get_host_memory_domain();
     }
 
+    // Returns a submitted task that completes after all of `tasks`, or nullptr if the subsystem
+    // cannot create one.
+    std::shared_ptr<rts::task> join(std::vector<std::shared_ptr<rts::task>> const& tasks);
+
 private:
     std::shared_ptr<rts::subsystem> ss_;
 };
 
-struct memory_state {
-    void init(uint64_t ver) {
-        ver_ = ver;
-    }
+// Disjoint byte ranges covering a whole buffer, each of which is associated with a value.
+template <class T>
+struct region_map {
+    struct entry {
+        dep::region r;
+        T value;
+    };
 
-    void prepare_read(std::shared_ptr<rts::task> const& task) {
-        set_dependency(task, false);
-        read_ = true;
-        add_reader(task);
-    }
+    explicit region_map(size_t size, T const& init) : entries_{entry{{0, size}, init}} {}
 
-    void prepare_write(std::shared_ptr<rts::task> const& task, uint64_t new_ver) {
-        set_dependency(task, true);
-        read_ = true;
-        readers_.clear();
-        set_writer(task);
-        ver_ = new_ver;
+    // Calls `f(entry&)` for each part of `r` that has its own value.
+    template <class F>
+    void for_each(dep::region const& r, F&& f) {
+        auto const [first, last] = split(r);
+
+        for (auto i = first; i < last; i++) {
+            f(entries_[i]);
+        }
     }
 
-    uint64_t version() const {
-        return ver_;
+    // Associates `value` with the whole of `r`. The entry is merged with its neighbours that
+    // have the same value, so that the map does not keep the boundaries of past accesses.
+    void assign(dep::region const& r, T const& value) {
+        auto const [first, last] = split(r);
+
+        if (first >= last) {
+            return;
+        }
+
+        entries_[first] = entry{r, value};
+        entries_.erase(entries_.begin() + first + 1, entries_.begin() + last);
+
+        if (first + 1 < entries_.size() && entries_[first + 1].value == value) {
+            entries_[first].r.end = entries_[first + 1].r.end;
+            entries_.erase(entries_.begin() + first + 1);
+        }
+
+        if (first > 0 && entries_[first - 1].value == value) {
+            entries_[first - 1].r.end = entries_[first].r.end;
+            entries_.erase(entries_.begin() + first);
+        }
     }
 
 private:
-    void add_reader(std::shared_ptr<rts::task> const& task) {
-        assert(read_);
-        assert(task != nullptr);
+    std::pair<size_t, size_t> split(dep::region const& r) {
+        auto const first = split_at(r.begin);
+        auto const last = split_at(r.end);
+        return {first, last};
+    }
+
+    // Makes `pos` an entry boundary and returns the index of the entry starting at `pos`.
+    size_t split_at(size_t pos) {
+        auto it = std::upper_bound(entries_.begin(), entries_.end(), pos,
+                                   [](size_t p, entry const& e) {
+                                       return p < e.r.end;
+                                   });
+
+        if (it == entries_.end() || it->r.begin == pos) {
+            return it - entries_.begin();
+        }
+
+        auto e = *it;
+        e.r.begin = pos;
+        it->r.end = pos;
 
-        readers_.push_back(task);
+        it = entries_.insert(std::next(it), std::move(e));
+
+        return it - entries_.begin();
     }
 
-    void set_writer(std::shared_ptr<rts::task> const& task) {
-        assert(read_ && readers_.empty());
-        assert(task != nullptr);
+    std::vector<entry> entries_;
+};
+
+/*
+ * Tasks that access each region of a buffer in one memory domain.
+ *
+ * A region keeps its last writer and the readers since that write. Completed tasks are dropped
+ * when they are found, and a reader list that grows beyond MAX_READERS is collapsed into a
+ * single join task so that a read-mostly buffer neither accumulates tasks nor gives the next
+ * writer an unbounded number of predecessors.
+ *
+ * A task of an in-order queue already runs after every earlier task of that queue. It adds no
+ * dependency on them, and it replaces them in the reader list instead of being appended.
+ */
+struct memory_state {
+    explicit memory_state(size_t size, uint64_t ver)
+        : map_(size, segment{ver, nullptr, 0, {}, 0}) {}
 
-        read_ = false;
-        writer_ = task;
+    void prepare_read(dependency_manager_impl& dep, std::shared_ptr<rts::task> const& task,
+                      uint64_t chain, dep::region const& r) {
+        map_.for_each(r, [&](auto& e) {
+            set_dependency(task, chain, e.value, false);
+            add_reader(dep, task, chain, e.value);
+        });
     }
 
-    bool is_reading() const {
-        return read_ && !readers_.empty();
+    void prepare_write(std::shared_ptr<rts::task> const& task, uint64_t chain,
+                       dep::region const& r, uint64_t new_ver) {
+        map_.for_each(r, [&](auto& e) {
+            set_dependency(task, chain, e.value, true);
+        });
+        map_.assign(r, segment{new_ver, task, chain, {}, 0});
     }
 
-    bool is_writing() const {
-        return !read_;
+    // Calls `f(region, version)` for each part of `r` that has its own version.
+    template <class F>
+    void for_each_version(dep::region const& r, F&& f) {
+        map_.for_each(r, [&](auto const& e) {
+            f(e.r, e.value.ver);
+        });
     }
 
-    void clear() {
-        read_ = true;
-        writer_ = nullptr;
-        readers_.clear();
+private:
+    static constexpr size_t MAX_READERS = 32;
+
+    struct segment {
+        uint64_t ver;
+        std::shared_ptr<rts::task> writer;
+        uint64_t writer_chain;
+        std::vector<std::shared_ptr<rts::task>> readers;
+        // The in-order queue of all the readers, or 0 if they come from several queues.
+        uint64_t readers_chain;
+
+        bool operator==(segment const&) const = default;
+    };
+
+    void add_reader(dependency_manager_impl& dep, std::shared_ptr<rts::task> const& task,
+                    uint64_t chain, segment& seg) {
+        assert(task != nullptr);
+
+        if (!seg.readers.empty() && seg.readers.back() == task) {
+            return;
+        }
+
+        if (chain != 0 && seg.readers_chain == chain && !seg.readers.empty()) {
+            seg.readers.assign(1, task);
+            return;
+        }
+
+        seg.readers_chain = seg.readers.empty() ? chain : 0;
+
+        if (seg.readers.size() >= MAX_READERS) {
+            std::erase_if(seg.readers, [&](auto const& r) {
+                return r == task || r->is_complete();
+            });
+
+            if (seg.readers.size() >= MAX_READERS) {
+                if (auto join = dep.join(seg.readers)) {
+                    DEBUG_FMT("buffer[{}] join[{}] replaces {} readers", format::ptr(this),
+                              format::ptr(join.get()), seg.readers.size());
+                    seg.readers.assign(1, std::move(join));
+                }
+            }
+        }
+
+        seg.readers.push_back(task);
     }
 
-    void set_dependency(std::shared_ptr<rts::task> const& task, bool wait_for_prior_readers) {
+    void set_dependency(std::shared_ptr<rts::task> const& task, uint64_t chain,
+                        segment& seg, bool wait_for_prior_readers) {
         assert(task != nullptr);
 
-        if (writer_) {
+        if (seg.writer && seg.writer != task && seg.writer->is_complete()) {
+            seg.writer.reset();
+        }
+
+        if (seg.writer && seg.writer != task && !same_chain(chain, seg.writer_chain)) {
             DEBUG_FMT("buffer[{}] task[{}] depends on writer[{}]", format::ptr(this),
-                      format::ptr(task.get()), format::ptr(writer_.get()));
-            task->depends_on(writer_);
+                      format::ptr(task.get()), format::ptr(seg.writer.get()));
+            task->depends_on(seg.writer);
         }
 
-        if (wait_for_prior_readers) {
-            for (auto& r : readers_) {
-                DEBUG_FMT("buffer[{}] task[{}] depends on reader[{}]", format::ptr(this),
-                          format::ptr(task.get()), format::ptr(r.get()));
-                task->depends_on(r);
+        if (wait_for_prior_readers && !same_chain(chain, seg.readers_chain)) {
+            for (auto& r : seg.readers) {
+                if (r != task && !r->is_complete()) {
+                    DEBUG_FMT("buffer[{}] task[{}] depends on reader[{}]", format::ptr(this),
+                              format::ptr(task.get()), format::ptr(r.get()));
+                    task->depends_on(r);
+                }
             }
         }
     }
 
-    bool read_ = true;
-    std::shared_ptr<rts::task> writer_;
-    std::vector<std::shared_ptr<rts::task>> readers_;
-    uint64_t ver_ = DEV_INIT_VER;
+    static bool same_chain(uint64_t chain, uint64_t other) {
+        return chain != 0 && chain == other;
+    }
+
+    region_map<segment> map_;
 };
 
 struct memory_state_map {
-    memory_state_map() : states_(1) {
-        states_.front().init(HOST_INIT_VER);
+    explicit memory_state_map(size_t size) : size_(size) {
+        states_.emplace_back(size_, HOST_INIT_VER);
     }
 
     memory_state& get(rts::dom_id dom) {
-        if (static_cast<size_t>(dom) >= states_.size()) {
-            states_.resize(dom + 1);
+        while (static_cast<size_t>(dom) >= states_.size()) {
+            states_.emplace_back(size_, DEV_INIT_VER);
         }
         return states_.at(dom);
     }
 
-    memory_state const& get(rts::dom_id dom) const {
-        return const_cast<memory_state_map*>(this)->get(dom);
-    }
-
 private:
+    size_t size_;
     std::vector<memory_state> states_;
 };
 
 struct buffer_impl final : dep::buffer {
     buffer_impl(std::shared_ptr<dep::dependency_manager>&& mgr, dep::memory_domain const& h_dom,
-                void* h_ptr, std::unique_ptr<void, delete_by_free>&& hp,
-                std::unique_ptr<rts::buffer>&& rts)
+                void* h_ptr, rts::host_memory_ptr&& hp, size_t element_size,
+                rts::range const& size, std::unique_ptr<rts::buffer>&& rts)
         : mgr_(std::move(mgr)),
           h_ptr_(h_ptr),
           hp_(std::move(hp)),
-          ver_(HOST_INIT_VER),
-          owner_(h_dom),
+          element_size_(element_size),
+          size_(size),
+          latest_(byte_size(), version_info{HOST_INIT_VER, &h_dom}),
+          map_(byte_size()),
           rts_(std::move(rts)) {
         assert(h_dom.id() == rts::HOST_DOM_ID);
     }
@@ -283,26 +422,79 @@ struct buffer_impl final : dep::buffer {
         return map_.get(dom);
     }
 
-    memory_state const& get_state(rts::dom_id dom) const {
-        return map_.get(dom);
+    size_t byte_size() const {
+        return element_size_ * size_.size[0] * size_.size[1] * size_.size[2];
     }
 
-    bool has_latest(rts::dom_id dom) const {
-        return version() == get_state(dom).version();
+    dep::region whole() const {
+        return {0, byte_size()};
     }
 
-    uint64_t version() const {
-        return ver_;
+    // The bytes spanned by the elements [offset, offset + range).
+    dep::region region_of(dep::id const& offset, dep::range const& range) const {
+        if (range.size[0] == 0 || range.size[1] == 0 || range.size[2] == 0) {
+            return {0, 0};
+        }
+
+        auto const linear = [this](size_t i, size_t j, size_t k) {
+            return (i * size_.size[1] + j) * size_.size[2] + k;
+        };
+        auto const first = linear(offset.size[0], offset.size[1], offset.size[2]);
+        auto const last = linear(offset.size[0] + range.size[0] - 1,
+                                 offset.size[1] + range.size[1] - 1,
+                                 offset.size[2] + range.size[2] - 1);
+
+        return clamp({first * element_size_, (last + 1) * element_size_});
     }
 
-    dep::memory_domain const& owner() const {
-        return owner_;
+    dep::region clamp(dep::region const& r) const {
+        auto const end = std::min(r.end, byte_size());
+        return {std::min(r.begin, end), end};
     }
 
-    void set_version(dep::memory_domain const& new_owner, uint64_t new_ver) {
-        assert(ver_ < new_ver);
-        owner_ = new_owner;
-        ver_ = new_ver;
+    // Appends the parts of `r` that are stale in `dom` to `stale`, one entry per domain that
+    // holds their latest version.
+    void find_stale(dep::memory_domain const& dom, dep::region const& r, stale_list& stale) {
+        auto& st = get_state(dom.id());
+
+        latest_.for_each(r, [&](auto const& l) {
+            st.for_each_version(l.r, [&](dep::region const& q, uint64_t ver) {
+                if (ver == l.value.ver) {
+                    return;
+                }
+
+                auto it = std::find_if(stale.begin(), stale.end(), [&](auto const& s) {
+                    return s.src == l.value.owner;
+                });
+                if (it == stale.end()) {
+                    it = stale.insert(stale.end(), stale_part{l.value.owner, {}});
+                }
+
+                auto& xfer = it->xfer;
+                if (!xfer.empty() && xfer.back().end == q.begin) {
+                    xfer.back().end = q.end;
+                } else {
+                    xfer.push_back(q);
+                }
+            });
+        });
+    }
+
+    // Calls `f(region, version)` for each part of `r` that has its own latest version.
+    template <class F>
+    void for_each_latest(dep::region const& r, F&& f) {
+        latest_.for_each(r, [&](auto const& l) {
+            f(l.r, l.value.ver);
+        });
+    }
+
+    uint64_t next_version() {
+        return next_ver_++;
+    }
+
+    void set_version(dep::memory_domain const& new_owner, dep::region const& r,
+                     uint64_t new_ver) {
+        latest_.assign(r, version_info{new_ver, &new_owner});
     }
 
     rts::buffer& to_rts() {
@@ -313,14 +505,71 @@ struct buffer_impl final : dep::buffer {
         return h_ptr_;
     }
 
+    // The number of tasks that have accessed the buffer, by which a task_graph finds out
+    // whether another task has accessed it since the last submission of the graph.
+    uint64_t n_accesses() const {
+        return n_accesses_;
+    }
+
+    void count_access() {
+        n_accesses_++;
+    }
+
+    // The tasks that a task_graph replays are not added to the memory states. Instead, every
+    // task that accesses the buffer afterwards runs after them, until they complete.
+    std::shared_ptr<rts::task> const& fence() {
+        if (fence_ && fence_->is_complete()) {
+            fence_.reset();
+        }
+        return fence_;
+    }
+
+    void set_fence(std::shared_ptr<rts::task> const& fence) {
+        fence_ = fence;
+    }
+
+    // Guards the versions, the memory states, the access count and the fence.
+    void lock() {
+        mutex_.lock();
+    }
+
+    void unlock() {
+        mutex_.unlock();
+    }
+
 private:
+    struct version_info {
+        uint64_t ver;
+        dep::memory_domain const* owner;
+
+        bool operator==(version_info const&) const = default;
+    };
+
+    std::mutex mutex_;
     std::shared_ptr<dep::dependency_manager> mgr_;
     void* h_ptr_;
-    std::unique_ptr<void, delete_by_free> hp_;
-    uint64_t ver_;
-    std::reference_wrapper<dep::memory_domain const> owner_;
+    rts::host_memory_ptr hp_;
+    size_t element_size_;
+    rts::range size_;
+    uint64_t next_ver_ = HOST_INIT_VER + 1;
+    region_map<version_info> latest_;
     memory_state_map map_;
     std::unique_ptr<rts::buffer> rts_;
+    uint64_t n_accesses_ = 0;
+    std::shared_ptr<rts::task> fence_;
+};
+
+// The buffer accesses of a task of a task_graph and what depends() found for them, which a
+// replay of the task reuses instead of analyzing them again.
+struct task_analysis {
+    struct access {
+        buffer_impl* buf;
+        dep::memory_access acc;
+        rts::memory_domain const* tgt;
+        stale_list stale;
+    };
+
+    std::vector<access> accesses;
 };
 
 struct task_impl final : dep::task {
@@ -329,6 +578,15 @@ struct task_impl final : dep::task {
         DEBUG_FMT("task[{}] create (this={})", format::ptr(rts_.get()), format::ptr(this));
     }
 
+    // A task of a task_graph. The buffer accesses are recorded in `analysis`, or taken from it
+    // without being analyzed if `replay` is true.
+    explicit task_impl(dependency_manager_impl& dep, std::shared_ptr<rts::task> rts,
+                       task_analysis& analysis, bool replay)
+        : dep_(dep), rts_(rts), analysis_(&analysis), replay_(replay) {
+        DEBUG_FMT("task[{}] create (this={}, replay={})", format::ptr(rts_.get()),
+                  format::ptr(this), replay);
+    }
+
     ~task_impl() {
         DEBUG_FMT("task[{}] destroy (this={})", format::ptr(rts_.get()), format::ptr(this));
     }
@@ -352,8 +610,16 @@ struct task_impl final : dep::task {
         rts_->depends_on(task_->rts_);
     }
 
+    void set_chain(uint64_t chain) override {
+        chain_ = chain;
+    }
+
     void use_device(dep::device& dev) override {
-        tgt_ = &dev.get_memory_domain();
+        auto const& dom = dev.get_memory_domain();
+
+        // A device on the host memory shares the coherence state of the host: its accesses
+        // only order against the other tasks and never schedule a transfer.
+        tgt_ = dom.aliases_host() ? &dep_.get_host_memory_domain() : &dom;
         rts_->set_device(*dev.get());
         rts_->use_device();
     }
@@ -374,67 +640,117 @@ struct task_impl final : dep::task {
         rts_->set_param(ptr, size);
     }
 
-    void begin_params() override {
-        g_lock.lock();
+    void begin_params(size_t n_params, size_t param_byte) override {
+        assert(!locked_ && bufs_.empty());
+
+        if (n_params > 0) {
+            rts_->reserve_params(n_params, param_byte);
+        }
     }
 
-    rts::memory_domain const& depends(dep::buffer& buf, dep::memory_access acc) {
-        auto& buf_ = dynamic_cast<buffer_impl&>(buf);
-        auto const& owner = buf_.owner();
+    void use_buffer(dep::buffer& buf) override {
+        // The task_graph holds the locks of the buffers of a replay.
+        if (replay_) {
+            return;
+        }
 
-        assert(tgt_ != nullptr);
-        DEBUG_FMT("depends: task[{}] buffer[{}] target={} acc={}", format::ptr(rts_.get()),
-                  format::ptr(&buf_.to_rts()), tgt_->id(), static_cast<unsigned>(acc));
+        auto* buf_ = &dynamic_cast<buffer_impl&>(buf);
 
-        if (buf_.has_latest(tgt_->id())) {
-            switch (acc) {
-                case dep::memory_access::none:
-                    break;
+        if (!locked_) {
+            bufs_.push_back(buf_);
+        } else {
+            lock_buffer(*buf_);
+        }
+    }
 
-                case dep::memory_access::read_only:
-                    dep_.local_read(rts_, buf, *tgt_);
-                    break;
+    // Registers the dependencies of accessing `r` of `buf`. The stale parts of `r` are copied
+    // from each domain that holds their latest version: those of the returned domain are stored
+    // in `xfer` for set_buffer_param, and the others are transferred here.
+    rts::memory_domain const& depends(dep::buffer& buf, dep::memory_access acc,
+                                      dep::region const& r, dep::region_list& xfer) {
+        auto& buf_ = dynamic_cast<buffer_impl&>(buf);
+        auto const* tgt = tgt_;
+        auto const* stale = &stale_;
 
-                case dep::memory_access::write_only:
-                    dep_.local_write(rts_, buf, *tgt_);
-                    break;
+        if (replay_) {
+            auto const& a = analysis_->accesses.at(next_access_++);
+            tgt = a.tgt;
+            stale = &a.stale;
+        } else {
+            analyze(buf_, acc, r);
 
-                case dep::memory_access::read_write:
-                    dep_.local_read_write(rts_, buf, *tgt_);
-                    break;
+            if (analysis_) {
+                analysis_->accesses.push_back({&buf_, acc, tgt_, stale_});
             }
+        }
 
-            return *tgt_;
-        } else {
+        xfer.clear();
+
+        if (stale->empty()) {
+            return *tgt;
+        }
+
+        for (auto it = std::next(stale->begin()); it != stale->end(); ++it) {
+            rts_->transfer(buf_.to_rts(), buf_.h_ptr(), *it->src, it->xfer);
+        }
+
+        xfer = stale->front().xfer;
+        return *stale->front().src;
+    }
+
+    // Finds the stale parts of `r` in the target domain, which are stored in `stale_`.
+    void analyze(buffer_impl& buf, dep::memory_access acc, dep::region const& r) {
+        lock_buffer(buf);
+        buf.count_access();
+
+        if (auto const& fence = buf.fence()) {
+            rts_->depends_on(fence);
+        }
+
+        assert(tgt_ != nullptr);
+        DEBUG_FMT("depends: task[{}] buffer[{}] target={} acc={} region=[{}, {})",
+                  format::ptr(rts_.get()), format::ptr(&buf.to_rts()), tgt_->id(),
+                  static_cast<unsigned>(acc), r.begin, r.end);
+
+        stale_.clear();
+
+        if (acc == dep::memory_access::read_only || acc == dep::memory_access::read_write) {
+            buf.find_stale(*tgt_, r, stale_);
+        }
+
+        if (stale_.empty()) {
             switch (acc) {
                 case dep::memory_access::none:
                     break;
 
                 case dep::memory_access::read_only:
-                    dep_.transfer_read(rts_, buf, owner, *tgt_);
+                    dep_.local_read(rts_, chain_, buf, *tgt_, r);
                     break;
 
                 case dep::memory_access::write_only:
-                    dep_.transfer_write(rts_, buf, owner, *tgt_);
+                    dep_.local_write(rts_, chain_, buf, *tgt_, r);
                     break;
 
                 case dep::memory_access::read_write:
-                    dep_.transfer_read_write(rts_, buf, owner, *tgt_);
+                    dep_.local_read_write(rts_, chain_, buf, *tgt_, r);
                     break;
             }
-
-            return owner;
+        } else if (acc == dep::memory_access::read_only) {
+            dep_.transfer_read(rts_, chain_, buf, *tgt_, r, stale_);
+        } else {
+            dep_.transfer_read_write(rts_, chain_, buf, *tgt_, r, stale_);
         }
     }
 
     void set_buffer_param(dep::buffer& buf, dep::memory_access acc, dep::id const& offset,
-                          size_t offset_byte) override {
+                          dep::range const& range, size_t offset_byte) override {
         DEBUG_FMT("task[{}] {} (this={})", format::ptr(rts_.get()), __func__,
                   format::ptr(this));
 
         auto& buf_ = dynamic_cast<buffer_impl&>(buf);
-        auto const& dom = depends(buf, acc);
-        rts_->set_buffer_param(buf_.to_rts(), buf_.h_ptr(), dom, acc, offset, offset_byte);
+        auto const& dom = depends(buf, acc, buf_.region_of(offset, range), xfer_);
+        rts_->set_buffer_param(buf_.to_rts(), buf_.h_ptr(), dom, acc, offset, offset_byte,
+                               xfer_);
     }
 
     void copy_1d(dep::buffer& src, dep::memory_access src_acc, size_t src_off_byte,
@@ -443,12 +759,20 @@ struct task_impl final : dep::task {
         DEBUG_FMT("task[{}] {} (this={})", format::ptr(rts_.get()), __func__,
                   format::ptr(this));
         auto& dst_ = static_cast<buffer_impl&>(dst);
-        auto const& dst_dom = depends(dst, dst_acc);
         auto& src_ = static_cast<buffer_impl&>(src);
-        auto const& src_dom = depends(src, src_acc);
+        auto const dst_r = dst_.clamp({dst_off_byte, dst_off_byte + len_byte});
+        auto const src_r = src_.clamp({src_off_byte, src_off_byte + len_byte});
+
+        use_buffer(dst);
+        use_buffer(src);
+
+        auto const& dst_dom = depends(dst, dst_acc, dst_r, dst_xfer_);
+        auto const& src_dom = depends(src, src_acc, src_r, xfer_);
 
-        rts_->set_buffer_param(dst_.to_rts(), dst_.h_ptr(), dst_dom, dst_acc, rts::id(), 0);
-        rts_->set_buffer_param(src_.to_rts(), src_.h_ptr(), src_dom, src_acc, rts::id(), 0);
+        rts_->set_buffer_param(dst_.to_rts(), dst_.h_ptr(), dst_dom, dst_acc, rts::id(), 0,
+                               dst_xfer_);
+        rts_->set_buffer_param(src_.to_rts(), src_.h_ptr(), src_dom, src_acc, rts::id(), 0,
+                               xfer_);
         rts_->copy_1d(src_.to_rts(), src_off_byte, dst_.to_rts(), dst_off_byte, len_byte);
     }
 
@@ -457,9 +781,11 @@ struct task_impl final : dep::task {
         DEBUG_FMT("task[{}] {} (this={})", format::ptr(rts_.get()), __func__,
                   format::ptr(this));
         auto& src_ = static_cast<buffer_impl&>(src);
-        auto const& src_dom = depends(src, src_acc);
+        auto const src_r = src_.clamp({src_off_byte, src_off_byte + len_byte});
+        auto const& src_dom = depends(src, src_acc, src_r, xfer_);
 
-        rts_->set_buffer_param(src_.to_rts(), src_.h_ptr(), src_dom, src_acc, rts::id(), 0);
+        rts_->set_buffer_param(src_.to_rts(), src_.h_ptr(), src_dom, src_acc, rts::id(), 0,
+                               xfer_);
         rts_->copy_1d(src_.to_rts(), src_off_byte, dst, len_byte);
     }
 
@@ -468,9 +794,11 @@ struct task_impl final : dep::task {
         DEBUG_FMT("task[{}] {} (this={})", format::ptr(rts_.get()), __func__,
                   format::ptr(this));
         auto& dst_ = static_cast<buffer_impl&>(dst);
-        auto const& dst_dom = depends(dst, dst_acc);
+        auto const dst_r = dst_.clamp({dst_off_byte, dst_off_byte + len_byte});
+        auto const& dst_dom = depends(dst, dst_acc, dst_r, dst_xfer_);
 
-        rts_->set_buffer_param(dst_.to_rts(), dst_.h_ptr(), dst_dom, dst_acc, rts::id(), 0);
+        rts_->set_buffer_param(dst_.to_rts(), dst_.h_ptr(), dst_dom, dst_acc, rts::id(), 0,
+                               dst_xfer_);
         rts_->copy_1d(src, dst_.to_rts(), dst_off_byte, len_byte);
     }
 
@@ -481,12 +809,22 @@ struct task_impl final : dep::task {
         DEBUG_FMT("task[{}] {} (this={})", format::ptr(rts_.get()), __func__,
                   format::ptr(this));
         auto& dst_ = static_cast<buffer_impl&>(dst);
-        auto const& dst_dom = depends(dst, dst_acc);
         auto& src_ = static_cast<buffer_impl&>(src);
-        auto const& src_dom = depends(src, src_acc);
+        auto const dst_r =
+            dst_.clamp({dst_off_byte, dst_off_byte + (loop - 1) * dst_stride + len_byte});
+        auto const src_r =
+            src_.clamp({src_off_byte, src_off_byte + (loop - 1) * src_stride + len_byte});
 
-        rts_->set_buffer_param(dst_.to_rts(), dst_.h_ptr(), dst_dom, dst_acc, rts::id(), 0);
-        rts_->set_buffer_param(src_.to_rts(), src_.h_ptr(), src_dom, src_acc, rts::id(), 0);
+        use_buffer(dst);
+        use_buffer(src);
+
+        auto const& dst_dom = depends(dst, dst_acc, dst_r, dst_xfer_);
+        auto const& src_dom = depends(src, src_acc, src_r, xfer_);
+
+        rts_->set_buffer_param(dst_.to_rts(), dst_.h_ptr(), dst_dom, dst_acc, rts::id(), 0,
+                               dst_xfer_);
+        rts_->set_buffer_param(src_.to_rts(), src_.h_ptr(), src_dom, src_acc, rts::id(), 0,
+                               xfer_);
         rts_->copy_2d(src_.to_rts(), src_off_byte, src_stride, dst_.to_rts(), dst_off_byte,
                       dst_stride, loop, len_byte);
     }
@@ -497,9 +835,12 @@ struct task_impl final : dep::task {
         DEBUG_FMT("task[{}] {} (this={})", format::ptr(rts_.get()), __func__,
                   format::ptr(this));
         auto& src_ = static_cast<buffer_impl&>(src);
-        auto const& src_dom = depends(src, src_acc);
+        auto const src_r =
+            src_.clamp({src_off_byte, src_off_byte + (loop - 1) * src_stride + len_byte});
+        auto const& src_dom = depends(src, src_acc, src_r, xfer_);
 
-        rts_->set_buffer_param(src_.to_rts(), src_.h_ptr(), src_dom, src_acc, rts::id(), 0);
+        rts_->set_buffer_param(src_.to_rts(), src_.h_ptr(), src_dom, src_acc, rts::id(), 0,
+                               xfer_);
         rts_->copy_2d(src_.to_rts(), src_off_byte, src_stride, dst, dst_stride, loop, len_byte);
     }
 
@@ -509,9 +850,12 @@ struct task_impl final : dep::task {
         DEBUG_FMT("task[{}] {} (this={})", format::ptr(rts_.get()), __func__,
                   format::ptr(this));
         auto& dst_ = static_cast<buffer_impl&>(dst);
-        auto const& dst_dom = depends(dst, dst_acc);
+        auto const dst_r =
+            dst_.clamp({dst_off_byte, dst_off_byte + (loop - 1) * dst_stride + len_byte});
+        auto const& dst_dom = depends(dst, dst_acc, dst_r, dst_xfer_);
 
-        rts_->set_buffer_param(dst_.to_rts(), dst_.h_ptr(), dst_dom, dst_acc, rts::id(), 0);
+        rts_->set_buffer_param(dst_.to_rts(), dst_.h_ptr(), dst_dom, dst_acc, rts::id(), 0,
+                               dst_xfer_);
         rts_->copy_2d(src, src_stride, dst_.to_rts(), dst_off_byte, dst_stride, loop, len_byte);
     }
 
@@ -522,12 +866,22 @@ struct task_impl final : dep::task {
         DEBUG_FMT("task[{}] {} (this={})", format::ptr(rts_.get()), __func__,
                   format::ptr(this));
         auto& dst_ = static_cast<buffer_impl&>(dst);
-        auto const& dst_dom = depends(dst, dst_acc);
         auto& src_ = static_cast<buffer_impl&>(src);
-        auto const& src_dom = depends(src, src_acc);
+        auto const dst_r = dst_.clamp(
+            region_3d(dst_off_byte, i_dst_stride, j_dst_stride, i_loop, j_loop, len_byte));
+        auto const src_r = src_.clamp(
+            region_3d(src_off_byte, i_src_stride, j_src_stride, i_loop, j_loop, len_byte));
+
+        use_buffer(dst);
+        use_buffer(src);
 
-        rts_->set_buffer_param(dst_.to_rts(), dst_.h_ptr(), dst_dom, dst_acc, rts::id(), 0);
-        rts_->set_buffer_param(src_.to_rts(), src_.h_ptr(), src_dom, src_acc, rts::id(), 0);
+        auto const& dst_dom = depends(dst, dst_acc, dst_r, dst_xfer_);
+        auto const& src_dom = depends(src, src_acc, src_r, xfer_);
+
+        rts_->set_buffer_param(dst_.to_rts(), dst_.h_ptr(), dst_dom, dst_acc, rts::id(), 0,
+                               dst_xfer_);
+        rts_->set_buffer_param(src_.to_rts(), src_.h_ptr(), src_dom, src_acc, rts::id(), 0,
+                               xfer_);
         rts_->copy_3d(src_.to_rts(), src_off_byte, i_src_stride, j_src_stride, dst_.to_rts(),
                       dst_off_byte, i_dst_stride, j_dst_stride, i_loop, j_loop, len_byte);
     }
@@ -538,9 +892,12 @@ struct task_impl final : dep::task {
         DEBUG_FMT("task[{}] {} (this={})", format::ptr(rts_.get()), __func__,
                   format::ptr(this));
         auto& src_ = static_cast<buffer_impl&>(src);
-        auto const& src_dom = depends(src, src_acc);
+        auto const src_r = src_.clamp(
+            region_3d(src_off_byte, i_src_stride, j_src_stride, i_loop, j_loop, len_byte));
+        auto const& src_dom = depends(src, src_acc, src_r, xfer_);
 
-        rts_->set_buffer_param(src_.to_rts(), src_.h_ptr(), src_dom, src_acc, rts::id(), 0);
+        rts_->set_buffer_param(src_.to_rts(), src_.h_ptr(), src_dom, src_acc, rts::id(), 0,
+                               xfer_);
         rts_->copy_3d(src_.to_rts(), src_off_byte, i_src_stride, j_src_stride, dst,
                       i_dst_stride, j_dst_stride, i_loop, j_loop, len_byte);
     }
@@ -551,9 +908,12 @@ struct task_impl final : dep::task {
         DEBUG_FMT("task[{}] {} (this={})", format::ptr(rts_.get()), __func__,
                   format::ptr(this));
         auto& dst_ = static_cast<buffer_impl&>(dst);
-        auto const& dst_dom = depends(dst, dst_acc);
+        auto const dst_r = dst_.clamp(
+            region_3d(dst_off_byte, i_dst_stride, j_dst_stride, i_loop, j_loop, len_byte));
+        auto const& dst_dom = depends(dst, dst_acc, dst_r, dst_xfer_);
 
-        rts_->set_buffer_param(dst_.to_rts(), dst_.h_ptr(), dst_dom, dst_acc, rts::id(), 0);
+        rts_->set_buffer_param(dst_.to_rts(), dst_.h_ptr(), dst_dom, dst_acc, rts::id(), 0,
+                               dst_xfer_);
         rts_->copy_3d(src, i_src_stride, j_src_stride, dst_.to_rts(), dst_off_byte,
                       i_dst_stride, j_dst_stride, i_loop, j_loop, len_byte);
     }
@@ -562,15 +922,27 @@ struct task_impl final : dep::task {
         DEBUG_FMT("task[{}] {} (this={})", format::ptr(rts_.get()), __func__,
                   format::ptr(this));
         auto& dst_ = static_cast<buffer_impl&>(dst);
-        depends(dst, dep::memory_access::write_only);
+        depends(dst, dep::memory_access::write_only, dst_.clamp({0, byte_len}), xfer_);
         rts_->fill(dst_.to_rts(), byte_len);
     }
 
-    void set_kernel(char const* name, uint32_t hash) override {
+    void copy_usm(void const* src, void* dst, size_t len_byte) override {
+        DEBUG_FMT("task[{}] {} (this={})", format::ptr(rts_.get()), __func__,
+                  format::ptr(this));
+        rts_->copy_usm(src, dst, len_byte);
+    }
+
+    void fill_usm(void* dst, void const* pattern, size_t pattern_byte, size_t count) override {
         DEBUG_FMT("task[{}] {} (this={})", format::ptr(rts_.get()), __func__,
                   format::ptr(this));
-        DEBUG_FMT("task[{}] uses `{}`", format::ptr(rts_.get()), name);
-        rts_->set_kernel(name, hash);
+        rts_->fill_usm(dst, pattern, pattern_byte, count);
+    }
+
+    void set_kernel(runtime::kernel_handle const& kernel) override {
+        DEBUG_FMT("task[{}] {} (this={})", format::ptr(rts_.get()), __func__,
+                  format::ptr(this));
+        DEBUG_FMT("task[{}] uses `{}`", format::ptr(rts_.get()), kernel.name);
+        rts_->set_kernel(kernel);
     }
 
     void set_desc(rts::func_desc const* desc) override {
@@ -595,7 +967,14 @@ struct task_impl final : dep::task {
     }
 
     void end_params() override {
-        g_lock.unlock();
+        if (locked_) {
+            for (auto it = bufs_.rbegin(); it != bufs_.rend(); ++it) {
+                (*it)->unlock();
+            }
+        }
+
+        bufs_.clear();
+        locked_ = false;
     }
 
     std::unique_ptr<dep::event> submit() override {
@@ -606,27 +985,299 @@ struct task_impl final : dep::task {
     }
 
 private:
+    // Locks all declared buffers on the first call. Taking the locks together and in address
+    // order avoids deadlocks and keeps the dependencies of a task atomic with respect to other
+    // tasks sharing any of its buffers. A buffer that is accessed after that must have been
+    // declared, since locking it out of order could deadlock.
+    void lock_buffer(buffer_impl& buf) {
+        if (locked_) {
+            if (std::find(bufs_.begin(), bufs_.end(), &buf) == bufs_.end()) {
+                DEBUG_FMT("task[{}] buffer[{}] was not declared by use_buffer()",
+                          format::ptr(rts_.get()), format::ptr(&buf.to_rts()));
+                CHARM_SYCL_NS::throw_error(CHARM_SYCL_NS::errc::runtime,
+                                           "a buffer of the task was not declared");
+            }
+            return;
+        }
+
+        bufs_.push_back(&buf);
+        std::sort(bufs_.begin(), bufs_.end());
+        bufs_.erase(std::unique(bufs_.begin(), bufs_.end()), bufs_.end());
+
+        for (auto* b : bufs_) {
+            b->lock();
+        }
+        locked_ = true;
+    }
+
     dependency_manager_impl& dep_;
     std::shared_ptr<rts::task> rts_;
+    task_analysis* analysis_ = nullptr;
+    bool replay_ = false;
+    size_t next_access_ = 0;
     dep::memory_domain const* tgt_ = nullptr;
+    uint64_t chain_ = 0;
+    std::vector<buffer_impl*> bufs_;
+    bool locked_ = false;
+    stale_list stale_;
+    dep::region_list xfer_;
+    dep::region_list dst_xfer_;
+};
+
+/*
+ * The tasks of a task_graph, as analyzed by the last submission that set them up.
+ *
+ * A submission replays the analysis only if no other task has accessed the buffers since the
+ * last submission of the graph, and if the analysis started from the coherence states left by
+ * the submission before. The tasks then make the same data transfers as they did, and leave the
+ * same coherence states behind. The dependencies found by the analysis are replaced by
+ * precomputed ones: a replayed task runs after the earlier tasks of the graph that it conflicts
+ * with in a buffer, and after the previous submission of the graph if it accesses a buffer that
+ * no earlier task of the graph conflicts with.
+ *
+ * Replayed tasks are not added to the memory states of their buffers, so the last submission
+ * is set as the fence of each buffer, which the next tasks accessing the buffer wait for.
+ */
+struct task_graph_impl final : dep::task_graph {
+    explicit task_graph_impl(std::shared_ptr<dependency_manager_impl> dep,
+                             std::shared_ptr<rts::subsystem> ss)
+        : dep_(std::move(dep)), ss_(std::move(ss)) {}
+
+    void begin(dep::event const* after) override {
+        after_ = after;
+        tasks_.clear();
+
+        // The buffers stay locked until the replay finishes.
+        lock_buffers();
+
+        auto const unchanged = captured_ && this->unchanged();
+
+        replay_ = reusable_ && unchanged;
+        if (replay_) {
+            return;
+        }
+
+        unlock_buffers();
+
+        steady_ = unchanged;
+        nodes_.clear();
+        bufs_.clear();
+        n_accesses_.clear();
+        captured_ = false;
+        reusable_ = false;
+    }
+
+    std::shared_ptr<dep::task> new_task(std::vector<size_t> const& preds) override {
+        auto t = ss_->new_task();
+
+        if (replay_) {
+            auto& n = nodes_.at(tasks_.size());
+
+            for (auto p : n.deps) {
+                t->depends_on(tasks_[p]);
+            }
+            if (n.after_last) {
+                t->depends_on(last_);
+            }
+            if (n.preds.empty() && after_) {
+                t->depends_on(*after_);
+            }
+
+            tasks_.push_back(t);
+            return std::make_shared<task_impl>(*dep_, std::move(t), n.analysis, true);
+        }
+
+        for (auto p : preds) {
+            t->depends_on(tasks_.at(p));
+        }
+        if (preds.empty() && after_) {
+            t->depends_on(*after_);
+        }
+
+        auto& n = nodes_.emplace_back(node{preds, {}, false, {}});
+
+        tasks_.push_back(t);
+        return std::make_shared<task_impl>(*dep_, std::move(t), n.analysis, false);
+    }
+
+    std::unique_ptr<dep::event> finish() override {
+        auto ev = join();
+
+        if (replay_) {
+            for (size_t i = 0; i < bufs_.size(); i++) {
+                bufs_[i]->set_fence(last_);
+                bufs_[i]->count_access();
+                n_accesses_[i] = bufs_[i]->n_accesses();
+            }
+
+            unlock_buffers();
+            replay_ = false;
+
+            DEBUG_FMT("task_graph[{}] replayed {} tasks", format::ptr(this), nodes_.size());
+        } else {
+            analyze();
+
+            lock_buffers();
+            for (auto* b : bufs_) {
+                n_accesses_.push_back(b->n_accesses());
+            }
+            unlock_buffers();
+
+            captured_ = true;
+            reusable_ = steady_;
+        }
+
+        tasks_.clear();
+        after_ = nullptr;
+
+        return ev;
+    }
+
+    void cancel() override {
+        if (replay_) {
+            unlock_buffers();
+            replay_ = false;
+        }
+
+        tasks_.clear();
+        after_ = nullptr;
+        captured_ = false;
+        reusable_ = false;
+    }
+
+private:
+    struct node {
+        // The tasks of the same submission that this task runs after, as given to new_task().
+        std::vector<size_t> preds;
+        // `preds` and the earlier tasks that this task conflicts with in a buffer.
+        std::vector<size_t> deps;
+        // Whether this task accesses a buffer that no earlier task conflicts with.
+        bool after_last;
+        task_analysis analysis;
+    };
+
+    static bool writes(dep::memory_access acc) {
+        return acc == dep::memory_access::write_only || acc == dep::memory_access::read_write;
+    }
+
+    // Finds the buffers of the tasks and the conflicts between the tasks.
+    void analyze() {
+        std::vector<std::pair<buffer_impl*, std::pair<size_t, dep::memory_access>>> seen;
+
+        for (size_t j = 0; j < nodes_.size(); j++) {
+            auto& n = nodes_[j];
+
+            n.deps = n.preds;
+
+            for (auto const& a : n.analysis.accesses) {
+                if (a.acc == dep::memory_access::none) {
+                    continue;
+                }
+
+                auto conflicts = false;
+
+                for (auto const& [b, prev] : seen) {
+                    if (b == a.buf && prev.first != j &&
+                        (writes(a.acc) || writes(prev.second))) {
+                        n.deps.push_back(prev.first);
+                        conflicts = true;
+                    }
+                }
+
+                n.after_last = n.after_last || !conflicts;
+                seen.emplace_back(a.buf, std::make_pair(j, a.acc));
+                bufs_.push_back(a.buf);
+            }
+
+            std::sort(n.deps.begin(), n.deps.end());
+            n.deps.erase(std::unique(n.deps.begin(), n.deps.end()), n.deps.end());
+        }
+
+        std::sort(bufs_.begin(), bufs_.end());
+        bufs_.erase(std::unique(bufs_.begin(), bufs_.end()), bufs_.end());
+    }
+
+    // Whether no other task has accessed the buffers since the last submission. The buffers
+    // must be locked.
+    bool unchanged() const {
+        for (size_t i = 0; i < bufs_.size(); i++) {
+            if (bufs_[i]->n_accesses() != n_accesses_[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // The buffers are sorted by address, which is the order in which tasks lock them.
+    void lock_buffers() {
+        for (auto* b : bufs_) {
+            b->lock();
+        }
+    }
+
+    void unlock_buffers() {
+        for (auto it = bufs_.rbegin(); it != bufs_.rend(); ++it) {
+            (*it)->unlock();
+        }
+    }
+
+    // Submits a task that completes after the tasks of the submission, which is the last
+    // submission from now on.
+    std::unique_ptr<dep::event> join() {
+        auto join = ss_->new_task();
+
+        join->use_host();
+        join->set_host({});
+        for (auto const& t : tasks_) {
+            join->depends_on(t);
+        }
+
+        auto ev = join->submit();
+        last_ = std::move(join);
+        return ev;
+    }
+
+    std::shared_ptr<dependency_manager_impl> dep_;
+    std::shared_ptr<rts::subsystem> ss_;
+    // A deque keeps the analyses in place while the tasks of a submission record them.
+    std::deque<node> nodes_;
+    std::vector<std::shared_ptr<rts::task>> tasks_;
+    // The buffers of the tasks, and the number of accesses to each after the last submission.
+    std::vector<buffer_impl*> bufs_;
+    std::vector<uint64_t> n_accesses_;
+    std::shared_ptr<rts::task> last_;
+    dep::event const* after_ = nullptr;
+    // Whether the tasks have been analyzed by a complete submission.
+    bool captured_ = false;
+    // Whether the submission being set up starts from the states left by the last submission.
+    bool steady_ = false;
+    // Whether the next submission can replay the analysis.
+    bool reusable_ = false;
+    // Whether the submission being set up replays the analysis.
+    bool replay_ = false;
 };
 
 std::shared_ptr<dep::task> dependency_manager_impl::new_task() {
-    return std::make_shared<task_impl>(*this, ss_->new_task());
+    using allocator = CHARM_SYCL_NS::dev_rts::pool_allocator<task_impl>;
+    return std::allocate_shared<task_impl>(allocator(), *this, ss_->new_task());
+}
+
+std::unique_ptr<dep::task_graph> dependency_manager_impl::new_task_graph() {
+    return std::make_unique<task_graph_impl>(shared_from_this(), ss_);
 }
 
-std::unique_ptr<dep::buffer> dependency_manager_impl::new_buffer(void* h_ptr,
-                                                                 size_t element_size,
-                                                                 rts::range size) {
-    std::unique_ptr<void, delete_by_free> hp;
+std::unique_ptr<dep::buffer> dependency_manager_impl::new_buffer(
+    void* h_ptr, size_t element_size, rts::range size, dep::host_memory_policy const& policy) {
+    rts::host_memory_ptr hp;
 
     if (!h_ptr) {
-        hp.reset(calloc(element_size, size.size[0] * size.size[1] * size.size[2]));
+        hp = rts::alloc_host_memory(element_size * size.size[0] * size.size[1] * size.size[2],
+                                    policy);
         h_ptr = hp.get();
     }
 
     return std::make_unique<buffer_impl>(shared_from_this(), ss_->get_host_memory_domain(),
-                                         h_ptr, std::move(hp),
+                                         h_ptr, std::move(hp), element_size, size,
                                          ss_->new_buffer(h_ptr, element_size, size));
 }
 
@@ -640,89 +1291,127 @@ std::vector<std::shared_ptr<dep::platform>> dependency_manager_impl::get_platfor
     return res;
 }
 
+std::shared_ptr<rts::task> dependency_manager_impl::join(
+    std::vector<std::shared_ptr<rts::task>> const& tasks) {
+    if (!ss_->has_join_task()) {
+        return nullptr;
+    }
+
+    auto join = ss_->new_task();
+
+    join->use_host();
+    join->set_host({});
+    for (auto const& t : tasks) {
+        join->depends_on(t);
+    }
+    join->submit();
+
+    return join;
+}
+
 void dependency_manager_impl::local_read(std::shared_ptr<rts::task> const& task,
-                                         dep::buffer& buf, dep::memory_domain const& dom) {
+                                         uint64_t chain, dep::buffer& buf,
+                                         dep::memory_domain const& dom, dep::region const& r) {
     auto& buf_ = dynamic_cast<buffer_impl&>(buf);
 
     auto& ss = buf_.get_state(dom.id());
 
-    DEBUG_FMT("buffer L-RO[{}]: v{}@dom{:x}", format::ptr(&buf_.to_rts()), ss.version(),
+    DEBUG_FMT("buffer L-RO[{}]: [{}, {})@dom{:x}", format::ptr(&buf_.to_rts()), r.begin, r.end,
               dom.id());
 
-    ss.prepare_read(task);
+    ss.prepare_read(*this, task, chain, r);
 }
 
 void dependency_manager_impl::local_write(std::shared_ptr<rts::task> const& task,
-                                          dep::buffer& buf, dep::memory_domain const& dom) {
+                                          uint64_t chain, dep::buffer& buf,
+                                          dep::memory_domain const& dom, dep::region const& r) {
     auto& buf_ = dynamic_cast<buffer_impl&>(buf);
 
     auto& ss = buf_.get_state(dom.id());
-    auto const new_ver = ss.version() + 1;
+    auto const new_ver = buf_.next_version();
 
-    DEBUG_FMT("buffer L-WO[{}]: (v{} -> v{})@dom{:x}", format::ptr(&buf_.to_rts()),
-              ss.version(), new_ver, dom.id());
+    DEBUG_FMT("buffer L-WO[{}]: [{}, {}) -> v{}@dom{:x}", format::ptr(&buf_.to_rts()), r.begin,
+              r.end, new_ver, dom.id());
 
-    ss.prepare_write(task, new_ver);
-    buf_.set_version(dom, new_ver);
+    ss.prepare_write(task, chain, r, new_ver);
+    buf_.set_version(dom, r, new_ver);
 }
 
 void dependency_manager_impl::local_read_write(std::shared_ptr<rts::task> const& task,
-                                               dep::buffer& buf,
-                                               dep::memory_domain const& dom) {
-    local_write(task, buf, dom);
+                                               uint64_t chain, dep::buffer& buf,
+                                               dep::memory_domain const& dom,
+                                               dep::region const& r) {
+    local_write(task, chain, buf, dom, r);
 }
 
 void dependency_manager_impl::transfer_read(std::shared_ptr<rts::task> const& task,
-                                            dep::buffer& buf, dep::memory_domain const& src,
-                                            dep::memory_domain const& dst) {
+                                            uint64_t chain, dep::buffer& buf,
+                                            dep::memory_domain const& dst,
+                                            dep::region const& r, stale_list const& stale) {
     auto& buf_ = dynamic_cast<buffer_impl&>(buf);
 
-    auto& ss = buf_.get_state(src.id());
     auto& ds = buf_.get_state(dst.id());
-    auto const new_ver = ss.version();
 
-    DEBUG_FMT("buffer T-RO[{}]: v{}@dom{:x} --> (v{} -> v{})@dom{:x}",
-              format::ptr(&buf_.to_rts()), ss.version(), src.id(), ds.version(), new_ver,
-              dst.id());
+    // The stale parts of all sources in the order of their positions.
+    std::vector<std::pair<dep::region, dep::memory_domain const*>> parts;
+    for (auto const& s : stale) {
+        for (auto const& x : s.xfer) {
+            parts.emplace_back(x, s.src);
+        }
+    }
+    std::sort(parts.begin(), parts.end(), [](auto const& a, auto const& b) {
+        return a.first.begin < b.first.begin;
+    });
 
-    ss.prepare_read(task);
-    ds.prepare_write(task, new_ver);
-}
+    auto pos = r.begin;
 
-void dependency_manager_impl::transfer_write(std::shared_ptr<rts::task> const& task,
-                                             dep::buffer& buf, dep::memory_domain const& src,
-                                             dep::memory_domain const& dst) {
-    auto& buf_ = dynamic_cast<buffer_impl&>(buf);
+    for (auto const& [x, src] : parts) {
+        DEBUG_FMT("buffer T-RO[{}]: [{}, {})@dom{:x} --> dom{:x}", format::ptr(&buf_.to_rts()),
+                  x.begin, x.end, src->id(), dst.id());
 
-    auto& ss = buf_.get_state(src.id());
-    auto& ds = buf_.get_state(dst.id());
-    auto const new_ver = ss.version() + 1;
+        if (pos < x.begin) {
+            ds.prepare_read(*this, task, chain, {pos, x.begin});
+        }
+
+        buf_.get_state(src->id()).prepare_read(*this, task, chain, x);
+        buf_.for_each_latest(x, [&](dep::region const& q, uint64_t ver) {
+            ds.prepare_write(task, chain, q, ver);
+        });
 
-    DEBUG_FMT("buffer T-WO[{}]: v{}@dom{:x} --> (v{} -> v{})@dom{:x}",
-              format::ptr(&buf_.to_rts()), ss.version(), src.id(), ds.version(), new_ver,
-              dst.id());
+        pos = x.end;
+    }
 
-    ds.prepare_write(task, new_ver);
-    buf_.set_version(dst, new_ver);
+    if (pos < r.end) {
+        ds.prepare_read(*this, task, chain, {pos, r.end});
+    }
 }
 
 void dependency_manager_impl::transfer_read_write(std::shared_ptr<rts::task> const& task,
-                                                  dep::buffer& buf,
-                                                  dep::memory_domain const& src,
-                                                  dep::memory_domain const& dst) {
+                                                  uint64_t chain, dep::buffer& buf,
+                                                  dep::memory_domain const& dst,
+                                                  dep::region const& r,
+                                                  stale_list const& stale) {
     auto& buf_ = dynamic_cast<buffer_impl&>(buf);
 
-    auto& ss = buf_.get_state(src.id());
     auto& ds = buf_.get_state(dst.id());
-    auto const new_ver = ss.version() + 1;
+    auto const new_ver = buf_.next_version();
+
+    for (auto const& s : stale) {
+        auto& ss = buf_.get_state(s.src->id());
+
+        for (auto const& x : s.xfer) {
+            DEBUG_FMT("buffer T-RW[{}]: [{}, {})@dom{:x} --> dom{:x}",
+                      format::ptr(&buf_.to_rts()), x.begin, x.end, s.src->id(), dst.id());
+
+            ss.prepare_read(*this, task, chain, x);
+        }
+    }
 
-    DEBUG_FMT("buffer T-RW[{}]: v{}@dom{:x} --> (v{} -> v{})@dom{:x}",
-              format::ptr(&buf_.to_rts()), ss.version(), src.id(), ds.version(), new_ver,
-              dst.id());
+    DEBUG_FMT("buffer T-RW[{}]: [{}, {}) -> v{}@dom{:x}", format::ptr(&buf_.to_rts()), r.begin,
+              r.end, new_ver, dst.id());
 
-    ss.prepare_read(task);
-    ds.prepare_write(task, new_ver);
-    buf_.set_version(dst, new_ver);
+    ds.prepare_write(task, chain, r, new_ver);
+    buf_.set_version(dst, r, new_ver);
 }
 
 }  // namespace
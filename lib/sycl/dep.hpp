@@ -8,6 +8,7 @@ namespace rts {
 
 struct device;
 struct func_desc;
+struct host_memory_policy;
 struct memory_domain;
 struct subsystem;
 
@@ -20,8 +21,10 @@ struct device;
 struct event;
 struct event_barrier;
 struct buffer;
+struct task_graph;
 struct dependency_manager;
 
+using rts::host_memory_policy;
 using rts::memory_domain;
 
 struct id {
@@ -84,6 +87,25 @@ inline size_t acc_linear_off(accessor const& acc) {
            acc.offset[0] * acc.size[1] * acc.size[2];
 }
 
+// A contiguous byte range [begin, end) of a buffer.
+struct region {
+    size_t begin;
+    size_t end;
+
+    size_t size() const {
+        return end - begin;
+    }
+
+    bool empty() const {
+        return begin >= end;
+    }
+};
+
+static_assert(std::is_trivially_copyable_v<region>);
+static_assert(std::is_trivially_destructible_v<region>);
+
+using region_list = std::vector<region>;
+
 struct local_accessor {
     size_t off;
     size_t size[3];
@@ -135,6 +157,11 @@ struct task {
     virtual void depends_on(event const& ev) = 0;
     virtual void depends_on(std::shared_ptr<task> const& task) = 0;
 
+    // Marks the task as a command of the in-order queue identified by the nonzero id `chain`.
+    // The caller makes the task depend on the previous command of the chain, so the buffer
+    // accesses of earlier commands of the same chain need not be tracked as dependencies.
+    virtual void set_chain(uint64_t chain) = 0;
+
     void lock() {
         begin_params();
     }
@@ -152,7 +179,7 @@ struct task {
         set_host_fn({});
     }
     virtual void set_host_fn(std::function<void()> const& f) = 0;
-    virtual void set_kernel(char const* name, uint32_t hash) = 0;
+    virtual void set_kernel(runtime::kernel_handle const& kernel) = 0;
 
     virtual void set_single() = 0;
     virtual void set_range(range const& range) = 0;
@@ -202,25 +229,42 @@ struct task {
 
     virtual void fill_zero(buffer& src, size_t len_byte) = 0;
 
+    // USM operations. They are ordered only by the events given to depends_on.
+    virtual void copy_usm(void const* src, void* dst, size_t len_byte) = 0;
+
+    virtual void fill_usm(void* dst, void const* pattern, size_t pattern_byte,
+                          size_t count) = 0;
+
     // Function descriptor operation
     virtual void set_desc(rts::func_desc const* desc) = 0;
 
-    // 3. Acquire the global lock
-    virtual void begin_params() = 0;
+    // 3. Begin the parameter phase. At most `n_params` parameters of `param_byte` bytes in
+    // total follow; the numbers are a hint to size the storage of the parameters.
+    void begin_params() {
+        begin_params(0, 0);
+    }
+    virtual void begin_params(size_t n_params, size_t param_byte) = 0;
+
+    // 3a. Declare every buffer passed to set_buffer_param. The buffers are locked together, in
+    // address order, before the first dependency is registered.
+    virtual void use_buffer(buffer& buf) = 0;
 
     // 4. Set parameters
+    // `offset` and `range` select the elements accessed by the kernel; only that part of the
+    // buffer takes part in the dependency analysis and in the data transfer.
     virtual void set_param(void const* ptr, size_t size) = 0;
     virtual void set_buffer_param(buffer& buf, memory_access acc, dep::id const& offset,
-                                  size_t offset_byte) = 0;
+                                  dep::range const& range, size_t offset_byte) = 0;
 
-    // 5. Release the global lock
+    // 5. Release the buffer locks
     virtual void end_params() = 0;
 
     // 6. Submit to the queue
     virtual std::unique_ptr<event> submit() = 0;
 };
 
-struct buffer {
+// A buffer is owned by a shared_ptr, so that a command graph can keep it alive.
+struct buffer : std::enable_shared_from_this<buffer> {
     virtual ~buffer() = default;
 
     virtual void* get_pointer() = 0;
@@ -228,15 +272,43 @@ struct buffer {
     virtual void* get_host_pointer() = 0;
 };
 
+// A sequence of tasks that is submitted many times, e.g. the command groups of a command graph.
+// The dependencies and data transfers of the tasks are analyzed like those of any other task,
+// and the following submissions reuse the result while no other task accesses their buffers.
+struct task_graph {
+    virtual ~task_graph() = default;
+
+    // Starts a submission, which sets up the same tasks with the same calls as the previous
+    // ones. The tasks without predecessors run after `after`, which may be null.
+    virtual void begin(event const* after) = 0;
+
+    // The next task of the submission, which runs after the tasks of the submission at the
+    // indices `preds`. The dependencies and transfers of its buffer accesses are found by the
+    // first submission and replayed by the following ones.
+    virtual std::shared_ptr<task> new_task(std::vector<size_t> const& preds) = 0;
+
+    // Returns an event that completes after all tasks of the submission.
+    virtual std::unique_ptr<event> finish() = 0;
+
+    // Ends a submission whose tasks could not be set up.
+    virtual void cancel() = 0;
+};
+
 struct dependency_manager {
     virtual ~dependency_manager() = default;
 
     virtual std::shared_ptr<task> new_task() = 0;
 
-    virtual std::unique_ptr<buffer> new_buffer(void* h_ptr, size_t element_size,
-                                               range size) = 0;
+    virtual std::unique_ptr<task_graph> new_task_graph() = 0;
+
+    virtual std::unique_ptr<buffer> new_buffer(void* h_ptr, size_t element_size, range size,
+                                               host_memory_policy const& policy) = 0;
 
     virtual std::vector<std::shared_ptr<platform>> get_platforms() = 0;
+
+    virtual void* usm_alloc(usm::alloc kind, size_t byte) = 0;
+
+    virtual bool usm_free(void* ptr) = 0;
 };
 
 std::shared_ptr<dependency_manager> make_dependency_manager(
@@ -1,9 +1,154 @@
 #include "dev_rts.hpp"
+#include <cstdlib>
+
+namespace {
+
+thread_local dev_rts::task_pool* current_pool = nullptr;
+thread_local unsigned current_worker = 0;
+
+}  // namespace
 
 namespace dev_rts {
 
-std::unique_ptr<BS::thread_pool> q_task;
+std::unique_ptr<task_pool> q_task;
 memory_domain_impl g_dom;
 std::chrono::high_resolution_clock::time_point t0;
 
+task_pool::task_pool(unsigned n_threads) {
+    n_threads = std::max(n_threads, 1u);
+
+    queues_.reserve(n_threads);
+    for (unsigned i = 0; i < n_threads; i++) {
+        queues_.push_back(std::make_unique<local_queue>());
+    }
+
+    threads_.reserve(n_threads);
+    for (unsigned i = 0; i < n_threads; i++) {
+        threads_.emplace_back([this, i] {
+            worker_main(i);
+        });
+    }
+}
+
+task_pool::~task_pool() {
+    wait();
+
+    {
+        std::unique_lock lk(mutex_);
+        stop_ = true;
+    }
+    cv_task_.notify_all();
+
+    for (auto& th : threads_) {
+        th.join();
+    }
+}
+
+void task_pool::detach_task(task_t&& task) {
+    auto const idx = current_pool == this
+                         ? current_worker
+                         : next_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    auto& q = *queues_[idx];
+
+    n_unfinished_.fetch_add(1, std::memory_order_relaxed);
+
+    {
+        std::unique_lock lk(q.mutex);
+        q.tasks.push_back(std::move(task));
+    }
+
+    n_queued_.fetch_add(1, std::memory_order_release);
+
+    // Taking the mutex orders this notification after a worker's predicate check.
+    { std::unique_lock lk(mutex_); }
+    cv_task_.notify_one();
+}
+
+void task_pool::wait() {
+    std::unique_lock lk(mutex_);
+
+    cv_done_.wait(lk, [this] {
+        return n_unfinished_.load(std::memory_order_acquire) == 0;
+    });
+}
+
+unsigned task_pool::threads_from_env(unsigned default_value) {
+    if (auto const* v = std::getenv("CHARM_SYCL_TASK_THREADS")) {
+        if (auto const n = std::atoi(v); n > 0) {
+            return static_cast<unsigned>(n);
+        }
+    }
+    return default_value;
+}
+
+unsigned task_pool::this_worker_index() {
+    assert(current_pool != nullptr);
+    return current_worker;
+}
+
+bool task_pool::pop(unsigned idx, task_t& task) {
+    auto& q = *queues_[idx];
+    std::unique_lock lk(q.mutex);
+
+    if (q.tasks.empty()) {
+        return false;
+    }
+
+    task = std::move(q.tasks.back());
+    q.tasks.pop_back();
+
+    return true;
+}
+
+bool task_pool::steal(unsigned idx, task_t& task) {
+    auto const n = queues_.size();
+
+    for (size_t i = 1; i < n; i++) {
+        auto& q = *queues_[(idx + i) % n];
+        std::unique_lock lk(q.mutex, std::try_to_lock);
+
+        if (!lk.owns_lock() || q.tasks.empty()) {
+            continue;
+        }
+
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+
+        return true;
+    }
+
+    return false;
+}
+
+void task_pool::worker_main(unsigned idx) {
+    current_pool = this;
+    current_worker = idx;
+
+    for (;;) {
+        task_t task;
+
+        if (pop(idx, task) || steal(idx, task)) {
+            n_queued_.fetch_sub(1, std::memory_order_relaxed);
+
+            task();
+            task = nullptr;
+
+            if (n_unfinished_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::unique_lock lk(mutex_);
+                cv_done_.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock lk(mutex_);
+        cv_task_.wait(lk, [this] {
+            return stop_ || n_queued_.load(std::memory_order_acquire) > 0;
+        });
+
+        if (stop_) {
+            break;
+        }
+    }
+}
+
 }  // namespace dev_rts
@@ -1,16 +1,20 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <chrono>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <thread>
 #include <vector>
-#include <BS_thread_pool.hpp>
+#include "dev_rts/dag_node.hpp"
+#include "dev_rts/param_storage.hpp"
 #include "kreg.hpp"
 #include "rts.hpp"
 
@@ -18,41 +22,82 @@ namespace dev_rts {
 
 namespace rts = CHARM_SYCL_NS::rts;
 
-extern std::unique_ptr<BS::thread_pool> q_task;
-extern std::chrono::high_resolution_clock::time_point t0;
+/*
+ * Work-stealing task pool that runs the event graph.
+ *
+ * Each worker owns a deque. A task submitted from a worker, typically a successor that became
+ * ready when the worker completed its last predecessor, is pushed to the bottom of the
+ * worker's own deque and is popped next by the same worker. Tasks submitted from other
+ * threads are distributed round-robin. Idle workers steal from the top of the other deques.
+ */
+struct task_pool {
+    using task_t = std::function<void()>;
 
-inline void init_time_point() {
-    t0 = std::chrono::high_resolution_clock::now();
-}
+    explicit task_pool(unsigned n_threads);
 
-template <class Derived>
-struct event_node : std::enable_shared_from_this<Derived> {
-    using event_ptr = std::shared_ptr<Derived>;
-    using weak_event_ptr = std::weak_ptr<Derived>;
+    ~task_pool();
 
-    virtual ~event_node() = default;
+    task_pool(task_pool const&) = delete;
 
-    event_node(event_node const&) = delete;
+    task_pool(task_pool&&) = delete;
 
-    event_node(event_node&&) = delete;
+    task_pool& operator=(task_pool const&) = delete;
 
-    event_node& operator=(event_node const&) = delete;
+    task_pool& operator=(task_pool&&) = delete;
 
-    event_node& operator=(event_node&&) = delete;
+    void detach_task(task_t&& task);
 
-    using fn_t = std::function<void(event_ptr)>;
+    void wait();
 
-    bool happens_before(event_ptr next) {
-        std::unique_lock lk(mutex_);
+    unsigned get_thread_count() const {
+        return static_cast<unsigned>(threads_.size());
+    }
 
-        if (!done_) {
-            nexts_.push_back(next);
+    // The number of workers given by CHARM_SYCL_TASK_THREADS, or `default_value`.
+    static unsigned threads_from_env(unsigned default_value);
 
-            std::unique_lock lk_n(next->mutex_);
-            next->n_wait_ += 1;
-        }
+    // The index of the calling worker thread. Must be called from a task.
+    static unsigned this_worker_index();
+
+private:
+    struct local_queue {
+        std::mutex mutex;
+        std::deque<task_t> tasks;
+    };
+
+    bool pop(unsigned idx, task_t& task);
+
+    bool steal(unsigned idx, task_t& task);
+
+    void worker_main(unsigned idx);
+
+    std::vector<std::unique_ptr<local_queue>> queues_;
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable cv_task_;
+    std::condition_variable cv_done_;
+    std::atomic<size_t> n_queued_ = 0;
+    std::atomic<size_t> n_unfinished_ = 0;
+    std::atomic<unsigned> next_ = 0;
+    bool stop_ = false;
+};
+
+extern std::unique_ptr<task_pool> q_task;
+extern std::chrono::high_resolution_clock::time_point t0;
 
-        return !done_;
+inline void init_time_point() {
+    t0 = std::chrono::high_resolution_clock::now();
+}
+
+template <class Derived>
+struct event_node : CHARM_SYCL_NS::dev_rts::dag_node<Derived> {
+    using event_ptr = std::shared_ptr<Derived>;
+    using weak_event_ptr = std::weak_ptr<Derived>;
+
+    using fn_t = std::function<void(event_ptr)>;
+
+    bool happens_before(event_ptr const& next) {
+        return this->precede(next);
     }
 
     void enable_profiling() {
@@ -77,83 +122,55 @@ struct event_node : std::enable_shared_from_this<Derived> {
             t_submit = std::chrono::duration_cast<std::chrono::nanoseconds>(t - t0).count();
         }
 
-        notify();
-    }
-
-    void notify() {
-        std::unique_lock lk(mutex_);
-
-        n_wake_ += 1;
-        check_to_run();
+        this->notify();
     }
 
     void complete() {
-        std::unique_lock lk(mutex_);
-        complete_no_lock();
+        if (t_enable) [[unlikely]] {
+            auto const t = std::chrono::high_resolution_clock::now();
+            t_end = std::chrono::duration_cast<std::chrono::nanoseconds>(t - t0).count();
+        }
+
+        base_t::complete();
     }
 
     void set_fn(std::function<void(event_ptr)> const& f) {
         fn_ = f;
     }
 
-    static auto create() {
-        return std::shared_ptr<Derived>(new Derived);
-    }
-
 protected:
     event_node() = default;
 
 private:
-    void complete_no_lock() {
-        done_ = true;
-
-        if (t_enable) [[unlikely]] {
-            auto const t = std::chrono::high_resolution_clock::now();
-            t_end = std::chrono::duration_cast<std::chrono::nanoseconds>(t - t0).count();
-        }
-
-        for (auto n : nexts_) {
-            n->notify();
-        }
-    }
-
-    void check_to_run() {
-        if (!run_ && n_wake_ == n_wait_) {
-            run_ = true;
+    using base_t = CHARM_SYCL_NS::dev_rts::dag_node<Derived>;
 
-            if (fn_) {
-                q_task->detach_task([ev = this->shared_from_this()] {
-                    if (ev->t_enable) [[unlikely]] {
-                        auto const t = std::chrono::high_resolution_clock::now();
-                        ev->t_start =
-                            std::chrono::duration_cast<std::chrono::nanoseconds>(t - t0)
-                                .count();
-                    }
+    friend base_t;
 
-                    ev->fn_(ev);
-                });
-            } else {
-                if (t_enable) [[unlikely]] {
+    void on_ready() {
+        if (fn_) {
+            q_task->detach_task([ev = this->shared_from_this()] {
+                if (ev->t_enable) [[unlikely]] {
                     auto const t = std::chrono::high_resolution_clock::now();
-                    t_start =
+                    ev->t_start =
                         std::chrono::duration_cast<std::chrono::nanoseconds>(t - t0).count();
                 }
 
-                complete_no_lock();
+                ev->fn_(ev);
+            });
+        } else {
+            if (t_enable) [[unlikely]] {
+                auto const t = std::chrono::high_resolution_clock::now();
+                t_start = std::chrono::duration_cast<std::chrono::nanoseconds>(t - t0).count();
             }
+
+            complete();
         }
     }
 
-    mutable std::mutex mutex_;
-    uint16_t n_wake_ = 0;
-    uint16_t n_wait_ = 1;
-    bool done_ = false;
-    bool run_ = false;
     bool t_enable = false;
     uint64_t t_submit = 0;
     uint64_t t_start = 0;
     uint64_t t_end = 0;
-    std::vector<event_ptr> nexts_;
     std::function<void(event_ptr)> fn_;
 };
 
@@ -218,6 +235,10 @@ struct event_base : rts::event {
         return ev_->get_t_end();
     }
 
+    bool is_complete() const override {
+        return ev_->is_done();
+    }
+
 protected:
     friend struct event_barrier_impl<EventNode>;
 
@@ -349,6 +370,10 @@ struct subsystem_base : rts::subsystem {
         return host_;
     }
 
+    bool has_join_task() const override {
+        return true;
+    }
+
 private:
     rts::host_memory_domain host_;
 };
@@ -385,68 +410,7 @@ private:
     rts::range size_;
 };
 
-struct task_parameter_storage {
-    static constexpr size_t MAX_N_ARGS = 64;
-    static constexpr size_t ARG_BUF_SIZE = 4096;
-
-    task_parameter_storage() {
-        clear();
-    }
-
-    void clear() {
-        args_.fill(nullptr);
-        arg_next_ = arg_data_.data();
-        arg_idx_ = 0;
-    }
-
-    void* next_param_ptr(size_t size, size_t align) {
-        if (arg_idx_ >= MAX_N_ARGS) {
-            assert(arg_idx_ < MAX_N_ARGS);
-            return nullptr;
-        }
-        assert(arg_next_ < arg_data_.data() + arg_data_.size());
-
-        auto addr = reinterpret_cast<uintptr_t>(arg_next_);
-        auto const mask = static_cast<uintptr_t>(align) - 1;
-
-        if (addr & mask) {
-            addr = (addr & ~mask) + align;
-        }
-        auto const ptr = reinterpret_cast<std::byte*>(addr);
-
-        args_.at(arg_idx_) = ptr;
-        arg_idx_++;
-        arg_next_ = ptr + size;
-
-        return ptr;
-    }
-
-    void* next_param_ptr(size_t size) {
-        return next_param_ptr(size, alignof(std::max_align_t));
-    }
-
-    template <class T>
-    T* next_param_ptr() {
-        static_assert(std::is_trivially_copyable_v<T>);
-        static_assert(std::is_trivially_destructible_v<T>);
-        return reinterpret_cast<T*>(next_param_ptr(sizeof(T), alignof(T)));
-    }
-
-    void add_param_val(void* val) {
-        args_.at(arg_idx_) = val;
-        arg_idx_++;
-    }
-
-    void** data() {
-        return args_.data();
-    }
-
-protected:
-    std::array<void*, MAX_N_ARGS> args_;
-    void* arg_next_;
-    unsigned int arg_idx_;
-    alignas(std::max_align_t) std::array<char, ARG_BUF_SIZE> arg_data_;
-};
+using task_parameter_storage = CHARM_SYCL_NS::dev_rts::task_parameter_storage;
 
 inline void* advance_ptr(void* ptr, size_t off_byte) {
     return reinterpret_cast<std::byte*>(ptr) + off_byte;
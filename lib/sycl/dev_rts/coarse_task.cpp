@@ -50,6 +50,11 @@ struct event final : rts::event {
         return -1;
     }
 
+    bool is_complete() const override {
+        auto t = weak_.lock();
+        return !t || t->is_done();
+    }
+
     task_ptr lock() const;
 
 private:
@@ -152,6 +157,35 @@ void coarse_task::commit(op_ptr&& op) {
     task->finalize();
 }
 
+void coarse_task::commit(std::vector<op_ptr>&& ops) {
+    DEBUG_FMT("this={} {}(n_ops={})", format::ptr(this), __func__, ops.size());
+
+    if (ops.empty()) {
+        commit();
+        return;
+    }
+
+    if (!kernel_) {
+        kernel_ = make_op_task(make_kernel_op());
+        DEBUG_FMT("\tkernel_={}", format::ptr(kernel_.get()));
+    }
+
+    for (auto& op : ops) {
+        auto task = make_op_task(std::move(op));
+
+        for (auto& d : depends_) {
+            DEBUG_FMT("\ttask {} runs after {}", format::ptr(task), format::ptr(d.get()));
+            task->runs_after(d);
+        }
+
+        DEBUG_FMT("\ttask {} runs after {}", format::ptr(kernel_.get()),
+                  format::ptr(task.get()));
+        kernel_->runs_after(task);
+        task->finalize();
+    }
+    depends_.clear();
+}
+
 void coarse_task::commit_as_core(op_ptr&& op) {
     DEBUG_FMT("this={} {}(op={})", format::ptr(this), __func__, format::ptr(op.get()));
 
@@ -236,11 +270,18 @@ void coarse_task::use_host() {
     k_.is_device = false;
 }
 
-void coarse_task::set_kernel(char const* name, uint32_t hash) {
+void coarse_task::set_kernel(runtime::kernel_handle const& kernel) {
     DEBUG_FMT("this={} {}()", format::ptr(this), __func__);
 
-    k_.name = name;
-    k_.hash = hash;
+    k_.kernel = &kernel;
+    k_.name = kernel.name;
+    k_.hash = kernel.hash;
+}
+
+void coarse_task::reserve_params(size_t n_params, size_t byte) {
+    DEBUG_FMT("this={} {}({}, {})", format::ptr(this), __func__, n_params, byte);
+
+    k_.params.reserve(n_params, byte);
 }
 
 void coarse_task::set_host(std::function<void()> const& f) {
@@ -387,28 +428,20 @@ void coarse_task::kernel_desc::add_param(void const* param, size_t byte) {
 }
 
 void coarse_task::kernel_desc::add_param(void const* param, size_t size_of, size_t align_of) {
-    auto addr = reinterpret_cast<uintptr_t>(this->next_param);
-    auto const mask = static_cast<uintptr_t>(align_of) - 1;
+    auto* ptr = params.next_param_ptr(size_of, align_of);
 
-    if (addr & mask) {
-        addr = (addr & ~mask) + align_of;
-    }
-    auto const ptr = reinterpret_cast<std::byte*>(addr);
-
-    DEBUG_FMT("this={} {}(param={}, size_of={}, align_of={}) => {} 0x{:x}",
+    DEBUG_FMT("this={} {}(param={}, size_of={}, align_of={}) => {} {}",
               reinterpret_cast<void const*>(
                   reinterpret_cast<uintptr_t>(this) -
                   reinterpret_cast<uintptr_t>(&reinterpret_cast<coarse_task const*>(0)->k_)),
-              __func__, format::ptr(param), size_of, align_of, this->n_args, addr);
+              __func__, format::ptr(param), size_of, align_of, params.size() - 1,
+              format::ptr(ptr));
 
     memcpy(ptr, param, size_of);
-    add_param_direct(ptr);
-
-    this->next_param = reinterpret_cast<std::byte*>(addr + size_of);
 }
 
 void coarse_task::kernel_desc::add_param_direct(void* ptr) {
-    this->args[this->n_args++] = ptr;
+    params.add_param_val(ptr);
 }
 
 }  // namespace dev_rts
@@ -4,8 +4,10 @@
 #include <cstddef>
 #include <cstdlib>
 #include <memory>
+#include <vector>
 #include <charm/sycl/config.hpp>
 #include "../rts.hpp"
+#include "param_storage.hpp"
 #include "task.hpp"
 
 CHARM_SYCL_BEGIN_NAMESPACE
@@ -30,7 +32,9 @@ struct coarse_task : std::enable_shared_from_this<coarse_task>, rts::task {
 
     void use_host() override;
 
-    void set_kernel(char const* name, uint32_t hash) override;
+    void set_kernel(runtime::kernel_handle const& kernel) override;
+
+    void reserve_params(size_t n_params, size_t byte) override;
 
     void set_host(std::function<void()> const& f) override;
 
@@ -82,25 +86,26 @@ struct coarse_task : std::enable_shared_from_this<coarse_task>, rts::task {
 
     void commit(op_ptr&& op);
 
+    // Like commit(op), but all `ops` wait for the same dependencies.
+    void commit(std::vector<op_ptr>&& ops);
+
     void commit_as_core(op_ptr&& op);
 
     std::unique_ptr<rts::event> submit() override;
 
     struct kernel_desc {
-        alignas(std::max_align_t) std::byte params[4096];
+        task_parameter_storage params;
         char const* name = nullptr;
+        runtime::kernel_handle const* kernel = nullptr;
         rts::func_desc const* desc = nullptr;
         std::array<size_t, 6> range = {{0, 0, 0, 0, 0, 0}};
         size_t lmem = 0;
-        std::array<void*, 64> args;
         rts::device* device = nullptr;
         uint32_t hash;
         bool is_single = false;
         bool is_ndr = false;
         bool is_device = true;
-        unsigned char n_args = 0;
         std::function<void()> host_fn;
-        std::byte* next_param = params;
 
         template <class T>
         void add_param(T const& val) {
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <charm/sycl/config.hpp>
+#include "pool.hpp"
+
+CHARM_SYCL_BEGIN_NAMESPACE
+namespace dev_rts {
+
+/*
+ * Lock-free node of a dependency graph.
+ *
+ * The numbers of awaited and arrived notifications are packed into one 64-bit counter (wait in
+ * the upper half, wake in the lower half). A node starts with one wait, which is released by
+ * notify() after all predecessors are registered, and Derived::on_ready() is called by the
+ * notification that makes both halves equal. Successors are pushed to an intrusive singly
+ * linked list that is closed when the node completes.
+ *
+ * Predecessors must be added with precede() before the successor's own notify().
+ */
+template <class Derived>
+struct dag_node : std::enable_shared_from_this<Derived> {
+    using node_ptr = std::shared_ptr<Derived>;
+
+    virtual ~dag_node() {
+        auto* l = nexts_.load(std::memory_order_relaxed);
+
+        if (l != closed()) {
+            free_links(l);
+        }
+    }
+
+    dag_node(dag_node const&) = delete;
+
+    dag_node(dag_node&&) = delete;
+
+    dag_node& operator=(dag_node const&) = delete;
+
+    dag_node& operator=(dag_node&&) = delete;
+
+    // Makes `next` wait for the completion of this node. Returns false if it already completed.
+    bool precede(node_ptr const& next) {
+        next->count_.fetch_add(ONE_WAIT, std::memory_order_relaxed);
+
+        auto* l = new_link(next);
+        auto* head = nexts_.load(std::memory_order_acquire);
+
+        do {
+            if (head == closed()) {
+                delete_link(l);
+                next->count_.fetch_sub(ONE_WAIT, std::memory_order_relaxed);
+                return false;
+            }
+
+            l->next = head;
+        } while (!nexts_.compare_exchange_weak(head, l, std::memory_order_release,
+                                               std::memory_order_acquire));
+
+        return true;
+    }
+
+    void notify() {
+        auto const c = count_.fetch_add(1, std::memory_order_acq_rel) + 1;
+
+        if ((c >> 32) == (c & WAKE_MASK)) {
+            static_cast<Derived*>(this)->on_ready();
+        }
+    }
+
+    void complete() {
+        free_links(nexts_.exchange(closed(), std::memory_order_acq_rel), true);
+    }
+
+    bool is_done() const {
+        return nexts_.load(std::memory_order_acquire) == closed();
+    }
+
+    template <class... Args>
+    static node_ptr create(Args&&... args) {
+        return std::allocate_shared<Derived>(pool_allocator<Derived>(),
+                                             std::forward<Args>(args)...);
+    }
+
+protected:
+    dag_node() = default;
+
+private:
+    static constexpr uint64_t ONE_WAIT = uint64_t(1) << 32;
+    static constexpr uint64_t WAKE_MASK = ONE_WAIT - 1;
+
+    struct link {
+        explicit link(node_ptr const& n) : node(n) {}
+
+        node_ptr node;
+        link* next = nullptr;
+    };
+
+    static link* closed() {
+        return reinterpret_cast<link*>(uintptr_t(1));
+    }
+
+    static link* new_link(node_ptr const& next) {
+        auto* ptr = block_pool<sizeof(link), alignof(link)>::allocate();
+        return new (ptr) link(next);
+    }
+
+    static void delete_link(link* l) {
+        l->~link();
+        block_pool<sizeof(link), alignof(link)>::deallocate(l);
+    }
+
+    static void free_links(link* l, bool notify = false) {
+        while (l) {
+            auto* next = l->next;
+
+            if (notify) {
+                l->node->notify();
+            }
+            delete_link(l);
+
+            l = next;
+        }
+    }
+
+    std::atomic<uint64_t> count_ = ONE_WAIT;
+    std::atomic<link*> nexts_ = nullptr;
+};
+
+}  // namespace dev_rts
+CHARM_SYCL_END_NAMESPACE
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <charm/sycl.hpp>
+
+CHARM_SYCL_BEGIN_NAMESPACE
+namespace dev_rts {
+
+/*
+ * Resolves kernels of a backend through the slots of runtime::kernel_handle.
+ *
+ * The first submission of a kernel calls `resolve` and stores its result into the slot of the
+ * backend; later submissions only load it. The filled slots are remembered so that clear() can
+ * reset them when the handles die, e.g., when the module of a GPU backend is unloaded.
+ */
+struct kernel_cache {
+    explicit kernel_cache(runtime::kernel_handle::backend slot) : slot_(slot) {}
+
+    kernel_cache(kernel_cache const&) = delete;
+
+    kernel_cache(kernel_cache&&) = delete;
+
+    kernel_cache& operator=(kernel_cache const&) = delete;
+
+    kernel_cache& operator=(kernel_cache&&) = delete;
+
+    // `Resolve` is called as `void*()` and must not return nullptr.
+    template <class Resolve>
+    void* get(runtime::kernel_handle const& kernel, Resolve&& resolve) {
+        auto& slot = kernel.slots[slot_];
+
+        if (auto* ptr = slot.load(std::memory_order_acquire)) {
+            return ptr;
+        }
+
+        void* ptr = resolve();
+        void* expected = nullptr;
+
+        // Another thread may have resolved the same kernel in the meantime.
+        if (slot.compare_exchange_strong(expected, ptr, std::memory_order_acq_rel)) {
+            std::unique_lock lk(mutex_);
+            filled_.push_back(&slot);
+        } else {
+            ptr = expected;
+        }
+
+        return ptr;
+    }
+
+    void clear() {
+        std::unique_lock lk(mutex_);
+
+        for (auto* slot : filled_) {
+            slot->store(nullptr, std::memory_order_release);
+        }
+        filled_.clear();
+    }
+
+private:
+    runtime::kernel_handle::backend slot_;
+    std::mutex mutex_;
+    std::vector<std::atomic<void*>*> filled_;
+};
+
+}  // namespace dev_rts
+CHARM_SYCL_END_NAMESPACE
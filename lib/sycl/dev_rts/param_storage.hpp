@@ -0,0 +1,141 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include <charm/sycl/config.hpp>
+
+CHARM_SYCL_BEGIN_NAMESPACE
+namespace dev_rts {
+
+/*
+ * Storage of the parameters of a kernel: a table of pointers to the values, which is passed to
+ * the kernel, and the values themselves.
+ *
+ * Both are inline arrays unless reserve() asks for more, in which case they are moved to the
+ * heap. The inline capacity is then kept on top of the request as headroom for the parameters
+ * that a backend adds at launch.
+ */
+struct task_parameter_storage {
+    static constexpr size_t MAX_N_ARGS = 64;
+    static constexpr size_t ARG_BUF_SIZE = 4096;
+
+    task_parameter_storage() {
+        clear();
+    }
+
+    task_parameter_storage(task_parameter_storage const&) = delete;
+
+    task_parameter_storage(task_parameter_storage&&) = delete;
+
+    task_parameter_storage& operator=(task_parameter_storage const&) = delete;
+
+    task_parameter_storage& operator=(task_parameter_storage&&) = delete;
+
+    void clear() {
+        std::fill_n(args_, args_cap_, nullptr);
+        arg_next_ = data_;
+        arg_idx_ = 0;
+    }
+
+    // Makes room for `n_args` parameters of `byte` bytes in total. Called before the first
+    // parameter is added.
+    void reserve(size_t n_args, size_t byte) {
+        assert(arg_idx_ == 0);
+
+        // The padding of each parameter is at most its alignment.
+        byte += n_args * alignof(std::max_align_t);
+
+        if (n_args > args_cap_) {
+            heap_args_.assign(n_args + MAX_N_ARGS, nullptr);
+            args_ = heap_args_.data();
+            args_cap_ = heap_args_.size();
+        }
+
+        if (byte > data_cap_) {
+            data_cap_ = byte + ARG_BUF_SIZE;
+            heap_data_.reset(new std::byte[data_cap_]);
+            data_ = heap_data_.get();
+            arg_next_ = data_;
+        }
+    }
+
+    // Throws if the storage is full. Parameters beyond the reservation fit in the headroom, so
+    // this happens only if a caller reserves too little.
+    void* next_param_ptr(size_t size, size_t align) {
+        if (arg_idx_ >= args_cap_) {
+            overflow();
+        }
+
+        auto addr = reinterpret_cast<uintptr_t>(arg_next_);
+        auto const mask = static_cast<uintptr_t>(align) - 1;
+
+        if (addr & mask) {
+            addr = (addr & ~mask) + align;
+        }
+        auto const ptr = reinterpret_cast<std::byte*>(addr);
+
+        if (ptr + size > data_ + data_cap_) {
+            overflow();
+        }
+
+        args_[arg_idx_] = ptr;
+        arg_idx_++;
+        arg_next_ = ptr + size;
+
+        return ptr;
+    }
+
+    void* next_param_ptr(size_t size) {
+        return next_param_ptr(size, alignof(std::max_align_t));
+    }
+
+    template <class T>
+    T* next_param_ptr() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        static_assert(std::is_trivially_destructible_v<T>);
+        return reinterpret_cast<T*>(next_param_ptr(sizeof(T), alignof(T)));
+    }
+
+    void add_param_val(void* val) {
+        if (arg_idx_ >= args_cap_) {
+            overflow();
+        }
+
+        args_[arg_idx_] = val;
+        arg_idx_++;
+    }
+
+    void** data() {
+        return args_;
+    }
+
+    size_t size() const {
+        return arg_idx_;
+    }
+
+private:
+    [[noreturn]] static void overflow() {
+        throw std::length_error("the parameters of the kernel exceed the reserved storage");
+    }
+
+    std::array<void*, MAX_N_ARGS> inline_args_;
+    alignas(std::max_align_t) std::array<std::byte, ARG_BUF_SIZE> inline_data_;
+    void** args_ = inline_args_.data();
+    size_t args_cap_ = MAX_N_ARGS;
+    std::byte* data_ = inline_data_.data();
+    size_t data_cap_ = ARG_BUF_SIZE;
+    std::byte* arg_next_;
+    unsigned int arg_idx_;
+    std::vector<void*> heap_args_;
+    std::unique_ptr<std::byte[]> heap_data_;
+};
+
+}  // namespace dev_rts
+CHARM_SYCL_END_NAMESPACE
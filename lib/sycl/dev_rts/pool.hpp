@@ -0,0 +1,186 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <charm/sycl/config.hpp>
+
+CHARM_SYCL_BEGIN_NAMESPACE
+namespace dev_rts {
+
+/*
+ * Free-list allocator for fixed-size blocks.
+ *
+ * Every thread keeps a private free list, so allocation and deallocation normally take no
+ * lock. Blocks are often released on a different thread than the one that allocated them
+ * (e.g. an event node freed by the worker that ran it), so a thread that collects too many
+ * blocks returns a batch to the shared list. Memory is never returned to the system.
+ */
+template <size_t Size, size_t Align>
+struct block_pool {
+    static void* allocate() {
+        auto& c = local();
+
+        if (!c.head) {
+            global().refill(c);
+        }
+
+        auto* b = c.head;
+        c.head = b->next;
+        c.n--;
+
+        return b;
+    }
+
+    static void deallocate(void* ptr) {
+        auto& c = local();
+        auto* b = static_cast<block*>(ptr);
+
+        b->next = c.head;
+        c.head = b;
+        c.n++;
+
+        if (c.n >= 2 * BATCH) {
+            global().drain(c, BATCH);
+        }
+    }
+
+private:
+    static constexpr size_t BATCH = 64;
+
+    struct block {
+        block* next;
+    };
+
+    static constexpr size_t ALIGN = Align < alignof(block) ? alignof(block) : Align;
+    static constexpr size_t BLOCK_SIZE =
+        ((Size < sizeof(block) ? sizeof(block) : Size) + ALIGN - 1) / ALIGN * ALIGN;
+
+    struct cache {
+        ~cache() {
+            global().drain(*this, n);
+        }
+
+        block* head = nullptr;
+        size_t n = 0;
+    };
+
+    struct shared {
+        void refill(cache& c) {
+            std::unique_lock lk(mutex_);
+
+            if (!head_) {
+                auto* chunk = static_cast<std::byte*>(
+                    ::operator new(BLOCK_SIZE * BATCH, std::align_val_t(ALIGN)));
+
+                for (size_t i = 0; i < BATCH; i++) {
+                    auto* b = reinterpret_cast<block*>(chunk + BLOCK_SIZE * i);
+                    b->next = head_;
+                    head_ = b;
+                }
+                n_ += BATCH;
+            }
+
+            for (size_t i = 0; i < BATCH && head_; i++) {
+                auto* b = head_;
+                head_ = b->next;
+                n_--;
+
+                b->next = c.head;
+                c.head = b;
+                c.n++;
+            }
+        }
+
+        void drain(cache& c, size_t n) {
+            std::unique_lock lk(mutex_);
+
+            for (size_t i = 0; i < n && c.head; i++) {
+                auto* b = c.head;
+                c.head = b->next;
+                c.n--;
+
+                b->next = head_;
+                head_ = b;
+                n_++;
+            }
+        }
+
+    private:
+        std::mutex mutex_;
+        block* head_ = nullptr;
+        size_t n_ = 0;
+    };
+
+    static cache& local() {
+        thread_local cache c;
+        return c;
+    }
+
+    static shared& global() {
+        // Intentionally leaked: thread-local caches return their blocks at thread exit, which
+        // may happen after static destructors have run.
+        static auto* g = new shared;
+        return *g;
+    }
+};
+
+// Allocator for std::allocate_shared that takes single objects from a block_pool.
+template <class T>
+struct pool_allocator {
+    using value_type = T;
+
+    pool_allocator() = default;
+
+    template <class U>
+    pool_allocator(pool_allocator<U> const&) noexcept {}
+
+    T* allocate(size_t n) {
+        if (n == 1) {
+            return static_cast<T*>(block_pool<sizeof(T), alignof(T)>::allocate());
+        }
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept {
+        if (n == 1) {
+            block_pool<sizeof(T), alignof(T)>::deallocate(ptr);
+        } else {
+            std::allocator<T>().deallocate(ptr, n);
+        }
+    }
+
+    template <class U>
+    bool operator==(pool_allocator<U> const&) const noexcept {
+        return true;
+    }
+
+    template <class U>
+    bool operator!=(pool_allocator<U> const&) const noexcept {
+        return false;
+    }
+};
+
+// Base class that makes `new Derived` take its memory from a block_pool. Objects of further
+// derived classes have another size and fall back to the global operator new.
+template <class Derived>
+struct pooled {
+    static void* operator new(size_t size) {
+        if (size == sizeof(Derived)) {
+            return block_pool<sizeof(Derived), alignof(Derived)>::allocate();
+        }
+        return ::operator new(size);
+    }
+
+    static void operator delete(void* ptr, size_t size) noexcept {
+        if (size == sizeof(Derived)) {
+            block_pool<sizeof(Derived), alignof(Derived)>::deallocate(ptr);
+        } else {
+            ::operator delete(ptr);
+        }
+    }
+};
+
+}  // namespace dev_rts
+CHARM_SYCL_END_NAMESPACE
@@ -4,6 +4,7 @@
 #include <mutex>
 #include <BS_thread_pool.hpp>
 #include <charm/sycl/config.hpp>
+#include "dag_node.hpp"
 
 CHARM_SYCL_BEGIN_NAMESPACE
 namespace dev_rts {
@@ -43,40 +44,25 @@ struct op_base {
 
 using op_ptr = std::unique_ptr<op_base>;
 
-struct task : std::enable_shared_from_this<task> {
-    task() : op_() {
-        init();
-    }
+struct task : dag_node<task> {
+    task() : op_() {}
 
-    explicit task(op_ptr&& op) : op_(std::move(op)) {
-        init();
-    }
+    explicit task(op_ptr&& op) : op_(std::move(op)) {}
 
     void override_op(op_ptr&& op) {
         op_ = std::move(op);
     }
 
-    virtual ~task() = default;
-
     void runs_after(task_ptr const& dependee);
 
     void finalize();
 
-    void complete();
-
 private:
     friend struct queue;
+    friend struct dag_node<task>;
     static inline queue q_;
 
-    void init();
-
-    void notify();
-
-    void prepare(std::unique_lock<std::mutex> lk);
-
-    void run(std::unique_lock<std::mutex> lk);
-
-    void complete(std::unique_lock<std::mutex> lk);
+    void on_ready();
 
     void run_op() {
         op_->call(shared_from_this());
@@ -86,21 +72,15 @@ private:
         return op_ == nullptr;
     }
 
-    std::mutex m_;
     op_ptr op_;
-    std::vector<task_ptr> nexts_;
-    uint16_t n_wake_ = 0;
-    uint16_t n_wait_ = 1;
-    bool done_ = false;
-    bool run_ = false;
 };
 
 inline task_ptr make_nop_task() {
-    return std::make_shared<task>();
+    return task::create();
 }
 
 inline task_ptr make_op_task(op_ptr&& op) {
-    return std::make_shared<task>(std::move(op));
+    return task::create(std::move(op));
 }
 
 template <class Op>
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <charm/sycl/config.hpp>
+
+CHARM_SYCL_BEGIN_NAMESPACE
+namespace dev_rts {
+
+/*
+ * Caching allocator for USM allocations.
+ *
+ * Requests are rounded up to a size class (powers of two up to 1 MiB, multiples of 1 MiB above)
+ * and served from a free list per class. A loop that allocates and frees the same sizes thus
+ * reaches the underlying allocator only once per size. Freed blocks are kept until they exceed
+ * `max_cached` bytes in total; further blocks are returned immediately.
+ *
+ * `Alloc` is called as `void*(size_t)` and `Free` as `void(void*)`.
+ */
+template <class Alloc, class Free>
+struct usm_pool {
+    explicit usm_pool(Alloc alloc, Free free, size_t max_cached)
+        : alloc_(std::move(alloc)), free_(std::move(free)), max_cached_(max_cached) {}
+
+    usm_pool(usm_pool const&) = delete;
+
+    usm_pool(usm_pool&&) = delete;
+
+    usm_pool& operator=(usm_pool const&) = delete;
+
+    usm_pool& operator=(usm_pool&&) = delete;
+
+    ~usm_pool() {
+        release();
+        for (auto const& [ptr, size] : live_) {
+            free_(ptr);
+        }
+    }
+
+    void* allocate(size_t byte) {
+        auto const size = size_class(byte);
+
+        {
+            std::unique_lock lk(mutex_);
+
+            if (auto it = cache_.find(size); it != cache_.end() && !it->second.empty()) {
+                auto* ptr = it->second.back();
+                it->second.pop_back();
+                cached_ -= size;
+                live_.emplace(ptr, size);
+                return ptr;
+            }
+        }
+
+        auto* ptr = alloc_(size);
+        if (!ptr) {
+            // Give the cached blocks back and try once more.
+            release();
+            ptr = alloc_(size);
+            if (!ptr) {
+                return nullptr;
+            }
+        }
+
+        std::unique_lock lk(mutex_);
+        live_.emplace(ptr, size);
+        return ptr;
+    }
+
+    // Returns false if `ptr` was not allocated by this pool.
+    bool deallocate(void* ptr) {
+        std::unique_lock lk(mutex_);
+
+        auto it = live_.find(ptr);
+        if (it == live_.end()) {
+            return false;
+        }
+
+        auto const size = it->second;
+        live_.erase(it);
+
+        if (cached_ + size <= max_cached_) {
+            cache_[size].push_back(ptr);
+            cached_ += size;
+            return true;
+        }
+
+        lk.unlock();
+        free_(ptr);
+        return true;
+    }
+
+    // Returns all cached blocks to the underlying allocator.
+    void release() {
+        std::unique_lock lk(mutex_);
+        auto cache = std::move(cache_);
+
+        cache_.clear();
+        cached_ = 0;
+        lk.unlock();
+
+        for (auto const& [size, ptrs] : cache) {
+            for (auto* ptr : ptrs) {
+                free_(ptr);
+            }
+        }
+    }
+
+private:
+    static constexpr size_t MIN_SIZE = 256;
+    static constexpr size_t LARGE_SIZE = 1024 * 1024;
+
+    static size_t size_class(size_t byte) {
+        if (byte > LARGE_SIZE) {
+            return (byte + LARGE_SIZE - 1) / LARGE_SIZE * LARGE_SIZE;
+        }
+
+        size_t size = MIN_SIZE;
+        while (size < byte) {
+            size *= 2;
+        }
+        return size;
+    }
+
+    Alloc alloc_;
+    Free free_;
+    size_t max_cached_;
+    std::mutex mutex_;
+    size_t cached_ = 0;
+    std::unordered_map<size_t, std::vector<void*>> cache_;
+    std::unordered_map<void*, size_t> live_;
+};
+
+}  // namespace dev_rts
+CHARM_SYCL_END_NAMESPACE
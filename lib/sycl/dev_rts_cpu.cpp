@@ -1,7 +1,12 @@
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstdlib>
 #include <cstring>
+#include <vector>
 #include "dev_rts.hpp"
+#include "dev_rts/kernel_cache.hpp"
+#include "dev_rts/usm_pool.hpp"
 #include "fiber.hpp"
 #include "format.hpp"
 #include "logging.hpp"
@@ -12,10 +17,23 @@ LOGGING_DEFINE_SCOPE(cpu)
 
 using namespace dev_rts;
 
+// buffer_impl::get() returns the host pointer, so the device memory is the host memory.
+struct cpu_memory_domain_impl final : memory_domain_impl {
+    bool aliases_host() const override {
+        return true;
+    }
+};
+
+cpu_memory_domain_impl g_cpu_dom;
+
 struct device_impl final : device_base {
     std::string info_name() const override {
         return "Dev-RTS Device [CPU]";
     }
+
+    rts::memory_domain& get_memory_domain() const override {
+        return g_cpu_dom;
+    }
 };
 
 struct platform_impl final : platform_base<device_impl> {
@@ -24,13 +42,18 @@ struct platform_impl final : platform_base<device_impl> {
     }
 };
 
-struct event_node_impl : event_node<event_node_impl> {};
+struct task_impl;
+
+struct event_node_impl : event_node<event_node_impl> {
+    // Keeps the task alive until it runs.
+    std::shared_ptr<task_impl> task;
+};
 
 using event_ptr = event_node_impl::event_ptr;
 
 using weak_event_ptr = event_node_impl::weak_event_ptr;
 
-struct event_impl final : event_base<event_node_impl> {
+struct event_impl final : event_base<event_node_impl>, sycl::dev_rts::pooled<event_impl> {
     using event_base::event_base;
 
     auto get() const {
@@ -53,6 +76,70 @@ struct buffer_impl final : buffer_base {
     }
 };
 
+// A memory operation that runs before the body of a task. A copy of up to three dimensions
+// copies `len` bytes `i_loop * j_loop` times; a pattern fill writes the `len` bytes at `src`
+// `i_loop` times.
+struct mem_op {
+    enum class kind { move, copy, fill, pattern };
+
+    void run() const {
+        switch (k) {
+            case kind::move:
+                DEBUG_FMT("memmove({}, {}, {})", format::ptr(dst), format::ptr(src), len);
+                std::memmove(dst, src, len);
+                break;
+
+            case kind::fill:
+                DEBUG_FMT("memset({}, 0, {})", format::ptr(dst), len);
+                std::memset(dst, 0x00, len);
+                break;
+
+            case kind::pattern:
+                DEBUG_FMT("fill({}, pattern={}, len={}, count={})", format::ptr(dst),
+                          format::ptr(src), len, i_loop);
+
+                if (len == 1) {
+                    std::memset(dst, *static_cast<unsigned char const*>(src), i_loop);
+                } else {
+                    for (size_t i = 0; i < i_loop; i++) {
+                        std::memcpy(dev_rts::advance_ptr(dst, i * len), src, len);
+                    }
+                }
+                break;
+
+            case kind::copy:
+                DEBUG_FMT(
+                    "copy(src={}, dst={}, loop=[{}, {}], src_stride=[{}, {}], dst_stride=[{}, "
+                    "{}], len={})",
+                    format::ptr(src), format::ptr(dst), i_loop, j_loop, i_src_stride,
+                    j_src_stride, i_dst_stride, j_dst_stride, len);
+
+                for (size_t i = 0; i < i_loop; i++) {
+                    auto const* s = dev_rts::advance_ptr(src, i * i_src_stride);
+                    auto* d = dev_rts::advance_ptr(dst, i * i_dst_stride);
+
+                    for (size_t j = 0; j < j_loop; j++) {
+                        std::memcpy(d, s, len);
+                        s = dev_rts::advance_ptr(s, j_src_stride);
+                        d = dev_rts::advance_ptr(d, j_dst_stride);
+                    }
+                }
+                break;
+        }
+    }
+
+    kind k;
+    void const* src;
+    void* dst;
+    size_t len;
+    size_t i_loop = 1;
+    size_t j_loop = 1;
+    size_t i_src_stride = 0;
+    size_t j_src_stride = 0;
+    size_t i_dst_stride = 0;
+    size_t j_dst_stride = 0;
+};
+
 struct task_impl : rts::task,
                    std::enable_shared_from_this<task_impl>,
                    private task_parameter_storage {
@@ -72,78 +159,73 @@ struct task_impl : rts::task,
     void depends_on(std::shared_ptr<rts::task> const& dep) override {
         assert(dep != nullptr);
 
-        auto dep_ = static_cast<task_impl const&>(*dep);
+        auto const& dep_ = static_cast<task_impl const&>(*dep);
 
         if (auto pre = dep_.wk_.lock()) {
             pre->happens_before(ev_);
         }
     }
 
+    bool is_complete() const override {
+        auto ev = wk_.lock();
+        return !ev || ev->is_done();
+    }
+
+    void reserve_params(size_t n_params, size_t byte) override {
+        task_parameter_storage::reserve(n_params, byte);
+    }
+
     void set_param(void const* ptr, size_t size) override {
         std::memcpy(next_param_ptr(size), ptr, size);
     }
 
     void set_buffer_param(rts::buffer& buf, void* h_ptr, rts::memory_domain const& dom,
-                          rts::memory_access ma, rts::id const& offset,
-                          size_t offset_byte) override {
+                          rts::memory_access ma, rts::id const& offset, size_t offset_byte,
+                          rts::region_list const& xfer) override {
         auto& buf_ = static_cast<buffer_impl&>(buf);
-        auto const htod =
-            (ma != rts::memory_access::write_only) && is_device_task_ && dom.is_host();
-        auto const dtoh =
-            (ma != rts::memory_access::write_only) && !is_device_task_ && !dom.is_host();
 
         (void)offset;
         DEBUG_FMT(
-            "set_buffer_param(h_ptr={}, dom={}, ma={}, off=[{}, {}, {}], off_byte={}) htod={} "
-            "dtoh={}",
+            "set_buffer_param(h_ptr={}, dom={}, ma={}, off=[{}, {}, {}], off_byte={}) "
+            "n_xfer={}",
             format::ptr(h_ptr), dom.id(), static_cast<int>(ma), offset.size[0], offset.size[1],
-            offset.size[2], offset_byte, htod, dtoh);
+            offset.size[2], offset_byte, xfer.size());
 
-        if (htod) {
-            pre_ = [h_ptr, ptr = buf_.get(), length = buf_.byte_size(),
-                    prev = std::move(pre_)] {
-                if (prev) {
-                    prev();
-                }
-
-                DEBUG_FMT("memcpy({}, {}, {}) H-to-D", format::ptr(ptr), format::ptr(h_ptr),
-                          length);
-
-                std::memcpy(ptr, h_ptr, length);
-            };
-        } else if (dtoh) {
-            pre_ = [h_ptr, ptr = buf_.get(), length = buf_.byte_size(),
-                    prev = std::move(pre_)] {
-                if (prev) {
-                    prev();
-                }
-
-                DEBUG_FMT("memcpy({}, {}, {}) D-to-H", format::ptr(h_ptr), format::ptr(ptr),
-                          length);
-
-                std::memcpy(h_ptr, ptr, length);
-            };
+        if (ma != rts::memory_access::write_only) {
+            transfer(buf, h_ptr, dom, xfer);
         }
 
         auto* ptr = next_param_ptr<void*>();
         *ptr = dev_rts::advance_ptr(buf_.get(), offset_byte);
     }
 
+    void transfer(rts::buffer& buf, void* h_ptr, rts::memory_domain const& src,
+                  rts::region_list const& xfer) override {
+        auto& buf_ = static_cast<buffer_impl&>(buf);
+        auto const htod = is_device_task_ && src.is_host();
+        auto const dtoh = !is_device_task_ && !src.is_host();
+
+        for (auto const& r : xfer) {
+            if (htod) {
+                add_op({.k = mem_op::kind::move,
+                        .src = dev_rts::advance_ptr(h_ptr, r.begin),
+                        .dst = dev_rts::advance_ptr(buf_.get(), r.begin),
+                        .len = r.size()});
+            } else if (dtoh) {
+                add_op({.k = mem_op::kind::move,
+                        .src = dev_rts::advance_ptr(buf_.get(), r.begin),
+                        .dst = dev_rts::advance_ptr(h_ptr, r.begin),
+                        .len = r.size()});
+            }
+        }
+    }
+
     static inline void* get_ptr(rts::buffer& buf, size_t off_byte) {
         return dev_rts::advance_ptr(buf.get_pointer(), off_byte);
     }
 
     void copy_1d_impl(void const* src_ptr, void* dst_ptr, size_t len_byte) {
-        pre_ = [src_ptr, dst_ptr, len_byte, prev = std::move(pre_)] {
-            if (prev) {
-                prev();
-            }
-
-            DEBUG_FMT("copy_1d(src={}, dst={}, len_byte={})", format::ptr(src_ptr),
-                      format::ptr(dst_ptr), len_byte);
-
-            std::memcpy(dst_ptr, src_ptr, len_byte);
-        };
+        add_op({.k = mem_op::kind::copy, .src = src_ptr, .dst = dst_ptr, .len = len_byte});
     }
 
     void copy_1d(rts::buffer& src, size_t src_off_byte, rts::buffer& dst, size_t dst_off_byte,
@@ -162,24 +244,13 @@ struct task_impl : rts::task,
 
     void copy_2d_impl(void const* src_ptr, size_t src_stride, void* dst_ptr, size_t dst_stride,
                       size_t loop, size_t len_byte) {
-        pre_ = [src_ptr, dst_ptr, src_stride, dst_stride, loop, len_byte,
-                prev = std::move(pre_)]() mutable {
-            if (prev) {
-                prev();
-            }
-
-            DEBUG_FMT(
-                "copy_2d(src={}, dst={}, loop={}, src_stride={}, dst_stride={}, len_byte={})",
-                format::ptr(src_ptr), format::ptr(dst_ptr), loop, src_stride, dst_stride,
-                len_byte);
-
-            for (size_t i = 0; i < loop; i++) {
-                std::memcpy(dst_ptr, src_ptr, len_byte);
-
-                src_ptr = dev_rts::advance_ptr(src_ptr, src_stride);
-                dst_ptr = dev_rts::advance_ptr(dst_ptr, dst_stride);
-            }
-        };
+        add_op({.k = mem_op::kind::copy,
+                .src = src_ptr,
+                .dst = dst_ptr,
+                .len = len_byte,
+                .j_loop = loop,
+                .j_src_stride = src_stride,
+                .j_dst_stride = dst_stride});
     }
 
     void copy_2d(rts::buffer& src, size_t src_off_byte, size_t src_stride, rts::buffer& dst,
@@ -202,32 +273,16 @@ struct task_impl : rts::task,
     void copy_3d_impl(void const* src_ptr, size_t i_src_stride, size_t j_src_stride,
                       void* dst_ptr, size_t i_dst_stride, size_t j_dst_stride, size_t i_loop,
                       size_t j_loop, size_t len_byte) {
-        pre_ = [src_ptr, dst_ptr, i_src_stride, j_src_stride, i_dst_stride, j_dst_stride,
-                i_loop, j_loop, len_byte, prev = std::move(pre_)]() mutable {
-            if (prev) {
-                prev();
-            }
-
-            DEBUG_FMT(
-                "copy_3d(src={}, dst={}, loop=[{}, {}], src_stride=[{}, {}], dst_stride=[{}, "
-                "{}], len_byte={})",
-                format::ptr(src_ptr), format::ptr(dst_ptr), i_loop, j_loop, i_src_stride,
-                j_src_stride, i_dst_stride, j_dst_stride, len_byte);
-
-            for (size_t i = 0; i < i_loop; i++) {
-                auto const src_ptr0 = src_ptr;
-                auto const dst_ptr0 = dst_ptr;
-
-                for (size_t j = 0; j < j_loop; j++) {
-                    std::memcpy(dst_ptr, src_ptr, len_byte);
-                    src_ptr = dev_rts::advance_ptr(src_ptr, j_src_stride);
-                    dst_ptr = dev_rts::advance_ptr(dst_ptr, j_dst_stride);
-                }
-
-                src_ptr = dev_rts::advance_ptr(src_ptr0, i_src_stride);
-                dst_ptr = dev_rts::advance_ptr(dst_ptr0, i_dst_stride);
-            }
-        };
+        add_op({.k = mem_op::kind::copy,
+                .src = src_ptr,
+                .dst = dst_ptr,
+                .len = len_byte,
+                .i_loop = i_loop,
+                .j_loop = j_loop,
+                .i_src_stride = i_src_stride,
+                .j_src_stride = j_src_stride,
+                .i_dst_stride = i_dst_stride,
+                .j_dst_stride = j_dst_stride});
     }
 
     void copy_3d(rts::buffer& src, size_t src_off_byte, size_t i_src_stride,
@@ -254,25 +309,50 @@ struct task_impl : rts::task,
     }
 
     void fill(rts::buffer& dst, size_t byte_len) override {
-        pre_ = [ptr = get_ptr(dst, 0), byte_len, prev = std::move(pre_)]() {
-            if (prev) {
-                prev();
-            }
-            memset(ptr, 0x00, byte_len);
-        };
+        add_op({.k = mem_op::kind::fill,
+                .src = nullptr,
+                .dst = get_ptr(dst, 0),
+                .len = byte_len});
     }
 
-    void set_kernel(char const* name, uint32_t hash) override {
-        auto& reg = kreg::get();
+    void copy_usm(void const* src, void* dst, size_t len_byte) override {
+        copy_1d_impl(src, dst, len_byte);
+    }
 
-        if (auto const* info = reg.find(name, hash, "cpu-openmp", kreg::fnv1a("cpu-openmp"))) {
-            fn_ = reinterpret_cast<dev_fn_ptr_t>(info->fn);
-        } else if (auto const* info = reg.find(name, hash, "cpu-c", kreg::fnv1a("cpu-c"))) {
-            fn_ = reinterpret_cast<dev_fn_ptr_t>(info->fn);
-        } else {
-            auto errmsg = format::format("Kernel not found: {}", name);
-            throw std::runtime_error(errmsg);
-        }
+    void fill_usm(void* dst, void const* pattern, size_t pattern_byte, size_t count) override {
+        auto const* p = static_cast<std::byte const*>(pattern);
+        auto const& copy = patterns_.emplace_back(p, p + pattern_byte);
+
+        add_op({.k = mem_op::kind::pattern,
+                .src = copy.data(),
+                .dst = dst,
+                .len = pattern_byte,
+                .i_loop = count});
+    }
+
+    void set_kernel(sycl::runtime::kernel_handle const& kernel) override {
+        // The registry is never modified after startup, so its entries can be cached forever.
+        static sycl::dev_rts::kernel_cache cache(sycl::runtime::kernel_handle::CPU);
+
+        auto const* info = static_cast<kreg::kernel_info const*>(cache.get(kernel, [&] {
+            auto& reg = kreg::get();
+            auto const* name = kernel.name;
+            auto const hash = kernel.hash;
+            auto const* info = reg.find(name, hash, "cpu-openmp", kreg::fnv1a("cpu-openmp"));
+
+            if (!info) {
+                info = reg.find(name, hash, "cpu-c", kreg::fnv1a("cpu-c"));
+            }
+            if (!info) {
+                auto errmsg = format::format("Kernel not found: {}", name);
+                throw std::runtime_error(errmsg);
+            }
+
+            return const_cast<void*>(static_cast<void const*>(info));
+        }));
+
+        fn_ = reinterpret_cast<dev_fn_ptr_t>(info->fn);
+        barrier_free_ = info->is_barrier_free();
     }
 
     void set_desc(rts::func_desc const* desc) override {
@@ -345,17 +425,20 @@ struct task_impl : rts::task,
     }
 
 private:
+    // What the task runs after its memory operations.
+    enum class body_kind { none, device, host, desc };
+
     std::unique_ptr<rts::event> submit_() {
-        if (pre_ || body_) {
-            ev_->set_fn([task = shared_from_this()](event_ptr const& ev) mutable {
+        if (n_ops_ > 0 || body_ != body_kind::none) {
+            // The function captures nothing so that it is stored without an allocation; the
+            // event node owns the task until it runs.
+            ev_->task = shared_from_this();
+            ev_->set_fn([](event_ptr const& ev) {
+                auto task = std::move(ev->task);
+
                 DEBUG_FMT("start: task [{}]", format::ptr(task.get()));
 
-                if (task->pre_) {
-                    task->pre_();
-                }
-                if (task->body_) {
-                    task->body_();
-                }
+                task->run();
 
                 DEBUG_FMT("end:   task [{}]", format::ptr(task.get()));
 
@@ -367,61 +450,94 @@ private:
         return std::make_unique<event_impl>(std::move(ev_));
     }
 
-    void prep_device() {
-        if (fn_) {
-            body_ = [this]() {
+    void add_op(mem_op const& op) {
+        if (n_ops_ < ops_.size()) {
+            ops_[n_ops_] = op;
+        } else {
+            more_ops_.push_back(op);
+        }
+        n_ops_++;
+    }
+
+    void run() {
+        for (size_t i = 0; i < std::min(n_ops_, ops_.size()); i++) {
+            ops_[i].run();
+        }
+        for (auto const& op : more_ops_) {
+            op.run();
+        }
+
+        switch (body_) {
+            case body_kind::none:
+                break;
+
+            case body_kind::device:
                 DEBUG_FMT("start: kernel function [{}]", format::ptr(this));
 
                 if (is_ndr_) {
                     sycl::runtime::impl::exec_with_fibers(par_[0], par_[1], par_[2], par_[3],
                                                           par_[4], par_[5], lmem_, fn_,
-                                                          args_.data());
+                                                          data(), barrier_free_);
                 } else {
-                    this->fn_(this->args_.data());
+                    fn_(data(), nullptr);
                 }
 
                 DEBUG_FMT("end:   kernel function [{}]", format::ptr(this));
-            };
-        }
-    }
+                break;
 
-    void prep_host() {
-        if (host_fn_) {
-            body_ = [this]() {
+            case body_kind::host:
                 DEBUG_FMT("start: host function [{}]", format::ptr(this));
 
-                this->host_fn_();
+                host_fn_();
 
                 DEBUG_FMT("end:   host function [{}]", format::ptr(this));
-            };
-        }
-    }
+                break;
 
-    void prep_desc() {
-        if (desc_) {
-            body_ = [this]() {
+            case body_kind::desc:
                 DEBUG_FMT("start: kernel descriptor {} [{}]", desc_->name, format::ptr(this));
 
-                desc_->cpu(this->args_.data());
+                desc_->cpu(data());
 
                 DEBUG_FMT("end:   kernel descriptor {} [{}]", desc_->name, format::ptr(this));
-            };
+                break;
         }
     }
 
-    using dev_fn_t = void(void**);
+    void prep_device() {
+        if (fn_) {
+            body_ = body_kind::device;
+        }
+    }
+
+    void prep_host() {
+        if (host_fn_) {
+            body_ = body_kind::host;
+        }
+    }
+
+    void prep_desc() {
+        if (desc_) {
+            body_ = body_kind::desc;
+        }
+    }
+
+    using dev_fn_t = sycl::runtime::impl::kernel_fn_t;
     using dev_fn_ptr_t = std::add_pointer_t<dev_fn_t>;
 
     bool is_device_task_ = true;
     std::function<dev_fn_t> fn_;
     std::function<void()> host_fn_;
-    std::function<void()> pre_;
-    std::function<void()> body_;
+    std::array<mem_op, 4> ops_;
+    std::vector<std::vector<std::byte>> patterns_;
+    size_t n_ops_ = 0;
+    std::vector<mem_op> more_ops_;
+    body_kind body_ = body_kind::none;
     std::array<size_t, 6> par_;
     event_ptr ev_;
     weak_event_ptr wk_;
     unsigned int lmem_ = 0;
     bool is_ndr_ = false;
+    bool barrier_free_ = false;
     rts::func_desc const* desc_ = nullptr;
 };
 
@@ -429,18 +545,45 @@ struct subsystem_impl final : subsystem_base<platform_impl, buffer_impl> {
     subsystem_impl() {
         init_logging();
 
-        q_task.reset(new BS::thread_pool(1));
+        q_task.reset(new task_pool(task_pool::threads_from_env(4)));
 
         DEBUG_LOG("initialized");
     }
 
     std::shared_ptr<rts::task> new_task() override {
-        return std::make_shared<task_impl>();
+        return std::allocate_shared<task_impl>(sycl::dev_rts::pool_allocator<task_impl>());
+    }
+
+    // The device works on the host memory, so every kind of USM is plain host memory.
+    void* usm_alloc(sycl::usm::alloc kind, size_t byte) override {
+        if (kind == sycl::usm::alloc::unknown) {
+            return nullptr;
+        }
+        return usm_.allocate(byte);
+    }
+
+    bool usm_free(void* ptr) override {
+        return usm_.deallocate(ptr);
     }
 
     void shutdown() override {
         q_task->wait();
     }
+
+private:
+    static constexpr size_t USM_ALIGN = 64;
+    static constexpr size_t USM_MAX_CACHED = size_t(1) << 30;
+
+    static void* usm_alloc_raw(size_t byte) {
+        return std::aligned_alloc(USM_ALIGN, byte);
+    }
+
+    static void usm_free_raw(void* ptr) {
+        std::free(ptr);
+    }
+
+    sycl::dev_rts::usm_pool<void* (*)(size_t), void (*)(void*)> usm_{
+        &usm_alloc_raw, &usm_free_raw, USM_MAX_CACHED};
 };
 
 }  // namespace
@@ -1,12 +1,23 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include <vector>
 #include <boost/context/fiber.hpp>
 #include <boost/context/protected_fixedsize_stack.hpp>
 #include <stdarg.h>
+#include <strings.h>
 #ifdef HAVE_GET_NPROCS
 #    include <sys/sysinfo.h>
 #endif
+#ifdef __linux__
+#    include <pthread.h>
+#    include <sched.h>
+#endif
 #include "fiber.hpp"
 #include "logging.hpp"
 
@@ -34,6 +45,8 @@ namespace {
 LOGGING_DEFINE_SCOPE(fiber)
 
 using fiber = boost::context::fiber;
+using fiber_context = sycl::runtime::impl::fiber_context;
+using kernel_fn_t = sycl::runtime::impl::kernel_fn_t;
 
 struct release_by_free {
     void operator()(void* ptr) const {
@@ -56,7 +69,7 @@ thread_local work_item* current_wi = nullptr;
 struct work_item {
     friend struct work_group;
 
-    explicit work_item(work_group* wg) : wg_(wg) {}
+    explicit work_item(work_group* wg, unsigned idx = 0) : wg_(wg), idx_(idx) {}
 
     work_item(work_item const&) = delete;
     work_item& operator=(work_item const&) = delete;
@@ -66,34 +79,27 @@ struct work_item {
     void syncthreads();
 
     size_t local_id1() const {
-        return local_id_[0];
+        return ctx_.local_id[0];
     }
 
     size_t local_id2() const {
-        return local_id_[1];
+        return ctx_.local_id[1];
     }
 
     size_t local_id3() const {
-        return local_id_[2];
+        return ctx_.local_id[2];
     }
 
     void set_id(size_t lid1, size_t lid2, size_t lid3) {
-        local_id_[0] = lid1;
-        local_id_[1] = lid2;
-        local_id_[2] = lid3;
+        ctx_.local_id[0] = lid1;
+        ctx_.local_id[1] = lid2;
+        ctx_.local_id[2] = lid3;
     }
 
 private:
-    explicit work_item(work_group* wg, fiber* prev, fiber* next, size_t local_id1,
-                       size_t local_id2, size_t local_id3)
-        : wg_(wg), prev_(prev), next_(next), local_id_{{local_id1, local_id2, local_id3}} {}
-
-    void syncthreads_not_run();
-
-    [[maybe_unused]] work_group* wg_ = nullptr;
-    fiber* prev_ = nullptr;
-    fiber* next_ = nullptr;
-    std::array<size_t, 3> local_id_{{0, 0, 0}};
+    work_group* wg_ = nullptr;
+    unsigned idx_ = 0;
+    fiber_context ctx_{};
 };
 
 struct work_group {
@@ -156,22 +162,48 @@ struct work_group {
     }
 
     void set_local_range(size_t local_range1, size_t local_range2, size_t local_range3) {
-        auto const n_items = local_range1 * local_range2 * local_range3;
+        local_range_[0] = local_range1;
+        local_range_[1] = local_range2;
+        local_range_[2] = local_range3;
+    }
+
+    // Creates a fiber for each work-item of the current local range.
+    void prepare_threads() {
+        auto const n_items = local_range_[0] * local_range_[1] * local_range_[2];
 
         alloc_threads(n_items);
         n_threads_ = n_items;
 
-        for (size_t i = 0, idx = 0; i < local_range1; i++) {
-            for (size_t j = 0; j < local_range2; j++) {
-                for (size_t k = 0; k < local_range3; k++, idx++) {
+        for (auto& slab : slab_) {
+            slab.resize(sizeof(uint64_t) * (n_items + 1));
+        }
+        arrived_ = 0;
+        parity_ = 0;
+
+        for (size_t i = 0, idx = 0; i < local_range_[0]; i++) {
+            for (size_t j = 0; j < local_range_[1]; j++) {
+                for (size_t k = 0; k < local_range_[2]; k++, idx++) {
                     work_items_[idx].set_id(i, j, k);
                 }
             }
         }
+    }
 
-        local_range_[0] = local_range1;
-        local_range_[1] = local_range2;
-        local_range_[2] = local_range3;
+    void set_group_id(size_t linear_id) {
+        group_id_[2] = linear_id % group_range_[2];
+        linear_id /= group_range_[2];
+        group_id_[1] = linear_id % group_range_[1];
+        group_id_[0] = linear_id / group_range_[1];
+    }
+
+    // Copies the ids and ranges of the group into the context of a work-item.
+    void fill_context(work_item& wi) const {
+        auto& ctx = wi.ctx_;
+
+        std::copy(group_id_.begin(), group_id_.end(), ctx.group_id);
+        std::copy(local_range_.begin(), local_range_.end(), ctx.local_range);
+        std::copy(group_range_.begin(), group_range_.end(), ctx.group_range);
+        ctx.local_memory = lmem_;
     }
 
     template <class F>
@@ -190,6 +222,42 @@ struct work_group {
         return lmem_;
     }
 
+    // The slab of the current group algorithm, one slot per work-item plus one.
+    template <class T>
+    T* slab() {
+        static_assert(sizeof(T) <= sizeof(uint64_t));
+        return reinterpret_cast<T*>(slab_[parity_].data());
+    }
+
+    // Returns true for the last of the `n` work-items that reach a group algorithm. The next
+    // algorithm uses the other slab.
+    bool arrive(size_t n) {
+        if (++arrived_ < n) {
+            return false;
+        }
+
+        arrived_ = 0;
+        parity_ ^= 1;
+        return true;
+    }
+
+    // Runs all work-items of the current group to completion, one after another, on the
+    // calling thread. Only valid for kernels that never call __charm_sycl_fiber_barrier.
+    void run_items(std::function<kernel_fn_t> const& fn, void** args) {
+        current_wg = this;
+        current_wi = &item_;
+        fill_context(item_);
+
+        for (size_t i = 0; i < local_range_[0]; i++) {
+            for (size_t j = 0; j < local_range_[1]; j++) {
+                for (size_t k = 0; k < local_range_[2]; k++) {
+                    item_.set_id(i, j, k);
+                    fn(args, &item_.ctx_);
+                }
+            }
+        }
+    }
+
 private:
     void alloc_threads(unsigned n) {
         if (threads_.size() < n) {
@@ -198,32 +266,48 @@ private:
 
             while (threads_.size() < n) {
                 add_thread(threads_.size());
-                work_items_.emplace_back(this);
+                work_items_.emplace_back(this, work_items_.size());
             }
         }
     }
 
+    // The fibers are linked into a ring through tail_. threads_ and work_items_ grow when a
+    // kernel has a larger local range than the previous ones, while the fibers of the previous
+    // kernels are suspended, so a fiber refers to its neighbours and to its work-item by index
+    // and looks them up again after each switch.
+    fiber& prev_thread(unsigned i) {
+        return i == 0 ? tail_ : threads_[i - 1];
+    }
+
+    fiber& next_thread(unsigned i) {
+        return i == n_threads_ - 1 ? tail_ : threads_[i + 1];
+    }
+
+    // Switches from the `i`-th fiber to the next one.
+    void yield(unsigned i) {
+        auto f = std::move(next_thread(i)).resume();
+        prev_thread(i) = std::move(f);
+    }
+
     void add_thread(unsigned i) {
         threads_.emplace_back(std::allocator_arg, boost::context::fixedsize_stack(1024 * 1024),
                               [i, this](fiber&& f) -> fiber {
-                                  work_item* wi = &work_items_[i];
-
-                                  wi->prev_ = i == 0 ? &tail_ : &threads_[i - 1];
-                                  *wi->prev_ = std::move(f);
+                                  prev_thread(i) = std::move(f);
 
                                   for (;;) {
-                                      wi = &work_items_[i];
-                                      wi->next_ =
-                                          i == n_threads_ - 1 ? &tail_ : &threads_[i + 1];
+                                      auto& wi = work_items_[i];
                                       current_wg = this;
-                                      current_wi = wi;
+                                      current_wi = &wi;
+                                      fill_context(wi);
 
-                                      fn_();
+                                      fn_(&wi.ctx_);
 
                                       if (i == 0) {
                                           running_ = false;
                                       }
-                                      wi->syncthreads_not_run();
+
+                                      assert(!running_);
+                                      yield(i);
                                   }
                               });
     }
@@ -236,20 +320,19 @@ private:
     std::array<size_t, 3> local_range_;
     std::vector<fiber> threads_;
     std::vector<work_item> work_items_;
-    std::function<void()> fn_;
+    work_item item_{this};
+    std::function<void(void*)> fn_;
     unsigned int n_threads_ = 0;
     bool running_ = false;
+    std::array<std::vector<std::byte>, 2> slab_;
+    size_t arrived_ = 0;
+    unsigned parity_ = 0;
     std::unique_ptr<void, release_by_free> ptr_;
 };
 
 void work_item::syncthreads() {
     assert(wg_->running_);
-    *prev_ = std::move(*next_).resume();
-}
-
-void work_item::syncthreads_not_run() {
-    assert(!wg_->running_);
-    *prev_ = std::move(*next_).resume();
+    wg_->yield(idx_);
 }
 
 std::mutex g_lock;
@@ -277,6 +360,346 @@ void release_wg(std::unique_ptr<work_group> wg) {
     g_wg_cache.push_back(std::move(wg));
 }
 
+int get_np() {
+#ifdef HAVE_GET_NPROCS
+    return get_nprocs();
+#else
+    return 1;
+#endif
+}
+
+bool env_to_bool(char const* name, bool default_value) {
+    auto const* v = std::getenv(name);
+
+    if (!v) {
+        return default_value;
+    }
+    return strcasecmp(v, "1") == 0 || strcasecmp(v, "y") == 0 || strcasecmp(v, "yes") == 0 ||
+           strcasecmp(v, "t") == 0 || strcasecmp(v, "true") == 0;
+}
+
+/*
+ * How work groups of a nd_range kernel are distributed over the worker threads.
+ *
+ *   CHARM_SYCL_FIBER_THREADS=<n>               number of workers (default: all cores)
+ *   CHARM_SYCL_FIBER_SCHEDULE=static|dynamic[,<chunk>]
+ *   CHARM_SYCL_FIBER_BIND=<bool>               pin worker i to the i-th allowed CPU
+ *
+ * The static schedule assigns a contiguous block of work groups to each worker, so a group
+ * always runs on the same core across kernels. The dynamic schedule hands out chunks of
+ * work groups on demand; the chunk size is derived from the number of groups if omitted.
+ */
+struct wg_policy {
+    enum class schedule_kind { static_, dynamic };
+
+    static wg_policy from_env() {
+        wg_policy p;
+
+        p.n_threads = std::max(get_np(), 1);
+        if (auto const* v = std::getenv("CHARM_SYCL_FIBER_THREADS")) {
+            if (auto const n = std::atoi(v); n > 0) {
+                p.n_threads = n;
+            }
+        }
+
+        if (auto const* v = std::getenv("CHARM_SYCL_FIBER_SCHEDULE")) {
+            if (strncasecmp(v, "static", 6) == 0) {
+                p.schedule = schedule_kind::static_;
+                v += 6;
+            } else if (strncasecmp(v, "dynamic", 7) == 0) {
+                p.schedule = schedule_kind::dynamic;
+                v += 7;
+            }
+
+            if (*v == ',') {
+                p.chunk = std::strtoul(v + 1, nullptr, 10);
+            }
+        }
+
+        p.bind = env_to_bool("CHARM_SYCL_FIBER_BIND", false);
+
+        return p;
+    }
+
+    unsigned n_threads = 1;
+    schedule_kind schedule = schedule_kind::dynamic;
+    size_t chunk = 0;
+    bool bind = false;
+};
+
+struct wg_job {
+    std::array<size_t, 3> group_range;
+    std::array<size_t, 3> local_range;
+    size_t lmem_byte;
+    std::function<kernel_fn_t> const* fn;
+    void** args;
+    size_t n_groups;
+    unsigned n_workers;
+    size_t chunk;
+    bool barrier_free;
+    std::atomic<size_t> next{0};
+};
+
+/*
+ * Persistent worker threads executing the work groups of nd_range kernels.
+ *
+ * Each worker takes one work_group (fibers and local memory) from g_wg_cache when it starts
+ * and keeps it for its whole lifetime. A suspended fiber never migrates between threads, so
+ * the thread_local current_wg/current_wi pointers stay valid inside the fibers.
+ *
+ * Kernels without group barriers run their work-items as a plain loop on the worker's own
+ * stack. Fibers are only created when a kernel with barriers needs them.
+ */
+struct wg_worker_pool {
+    explicit wg_worker_pool(wg_policy const& policy) : policy_(policy) {
+        DEBUG_FMT("worker pool: n_threads={} schedule={} chunk={} bind={}", policy_.n_threads,
+                  policy_.schedule == wg_policy::schedule_kind::static_ ? "static" : "dynamic",
+                  policy_.chunk, policy_.bind);
+
+        threads_.reserve(policy_.n_threads);
+        for (unsigned i = 0; i < policy_.n_threads; i++) {
+            threads_.emplace_back([this, i] {
+                worker_main(i);
+            });
+        }
+    }
+
+    ~wg_worker_pool() {
+        {
+            std::unique_lock lk(m_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+
+        for (auto& th : threads_) {
+            th.join();
+        }
+    }
+
+    void run(wg_job& job) {
+        job.n_workers = std::min<size_t>(threads_.size(), job.n_groups);
+
+        if (policy_.schedule == wg_policy::schedule_kind::dynamic) {
+            job.chunk = policy_.chunk > 0
+                            ? policy_.chunk
+                            : std::max<size_t>(job.n_groups / (job.n_workers * 4), 1);
+        }
+
+        std::unique_lock run_lk(run_lock_);
+        std::unique_lock lk(m_);
+
+        job_ = &job;
+        n_running_ = job.n_workers;
+        gen_++;
+        cv_.notify_all();
+
+        done_.wait(lk, [this] {
+            return n_running_ == 0;
+        });
+        job_ = nullptr;
+    }
+
+private:
+    void worker_main(unsigned idx) {
+        if (policy_.bind) {
+            bind_to_cpu(idx);
+        }
+
+        auto wg = acquire_wg();
+        uint64_t seen = 0;
+
+        for (;;) {
+            wg_job* job;
+
+            {
+                std::unique_lock lk(m_);
+                cv_.wait(lk, [&] {
+                    return stop_ || gen_ != seen;
+                });
+
+                if (stop_) {
+                    break;
+                }
+                seen = gen_;
+
+                if (!job_ || idx >= job_->n_workers) {
+                    continue;
+                }
+                job = job_;
+            }
+
+            execute(*wg, *job, idx);
+
+            std::unique_lock lk(m_);
+            if (--n_running_ == 0) {
+                done_.notify_all();
+            }
+        }
+
+        release_wg(std::move(wg));
+    }
+
+    void execute(work_group& wg, wg_job& job, unsigned idx) {
+        wg.set_group_range(job.group_range[0], job.group_range[1], job.group_range[2]);
+        wg.set_local_range(job.local_range[0], job.local_range[1], job.local_range[2]);
+        wg.set_lmem(job.lmem_byte);
+
+        if (!job.barrier_free) {
+            wg.prepare_threads();
+        }
+
+        auto const run_range = [&](size_t begin, size_t end) {
+            for (size_t g = begin; g < end; g++) {
+                wg.set_group_id(g);
+
+                if (job.barrier_free) {
+                    wg.run_items(*job.fn, job.args);
+                    continue;
+                }
+
+                wg.set_func([fn = job.fn, args = job.args](void* ctx) {
+                    (*fn)(args, ctx);
+                });
+
+                while (wg.resume()) {
+                }
+            }
+        };
+
+        if (policy_.schedule == wg_policy::schedule_kind::static_) {
+            auto const begin = job.n_groups * idx / job.n_workers;
+            auto const end = job.n_groups * (idx + 1) / job.n_workers;
+
+            run_range(begin, end);
+        } else {
+            for (;;) {
+                auto const begin = job.next.fetch_add(job.chunk, std::memory_order_relaxed);
+                if (begin >= job.n_groups) {
+                    break;
+                }
+
+                run_range(begin, std::min(begin + job.chunk, job.n_groups));
+            }
+        }
+    }
+
+    static void bind_to_cpu([[maybe_unused]] unsigned idx) {
+#ifdef __linux__
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0 || CPU_COUNT(&allowed) == 0) {
+            return;
+        }
+
+        auto const n = static_cast<unsigned>(CPU_COUNT(&allowed));
+        auto target = idx % n;
+
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (!CPU_ISSET(cpu, &allowed)) {
+                continue;
+            }
+
+            if (target == 0) {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(cpu, &set);
+                pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+
+                DEBUG_FMT("worker {} is bound to cpu {}", idx, cpu);
+                return;
+            }
+            target--;
+        }
+#endif
+    }
+
+    wg_policy policy_;
+    std::mutex run_lock_;
+    std::mutex m_;
+    std::condition_variable cv_;
+    std::condition_variable done_;
+    wg_job* job_ = nullptr;
+    uint64_t gen_ = 0;
+    unsigned n_running_ = 0;
+    bool stop_ = false;
+    std::vector<std::thread> threads_;
+};
+
+wg_worker_pool& get_worker_pool() {
+    static wg_worker_pool pool(wg_policy::from_env());
+    return pool;
+}
+
+/*
+ * Group algorithms. Every work-item stores its value in the slab of the work group and the last
+ * one to arrive runs `pass` over the whole slab in a single loop. The others only switch once
+ * at the following barrier, instead of once per step of a tree-shaped algorithm.
+ *
+ * Consecutive algorithms alternate between two slabs: a work-item that runs ahead into the
+ * next algorithm cannot overwrite results that the others have not read yet.
+ */
+template <class T, class Pass>
+T* group_algorithm(T x, size_t lid, size_t n, Pass&& pass) {
+    auto* const wg = current_wg;
+    auto* const slab = wg->slab<T>();
+
+    slab[lid] = x;
+
+    if (wg->arrive(n)) {
+        pass(slab, n);
+    }
+
+    __charm_sycl_fiber_barrier();
+
+    return slab;
+}
+
+template <class Op, class T>
+T group_reduce(T x, size_t lid, size_t n) {
+    auto const* slab = group_algorithm(x, lid, n, [](T* s, size_t n) {
+        T acc = s[0];
+        for (size_t i = 1; i < n; i++) {
+            acc = Op()(acc, s[i]);
+        }
+        s[n] = acc;
+    });
+
+    return slab[n];
+}
+
+template <class Op, class T>
+T group_inclusive_scan(T x, size_t lid, size_t n) {
+    auto const* slab = group_algorithm(x, lid, n, [](T* s, size_t n) {
+        for (size_t i = 1; i < n; i++) {
+            s[i] = Op()(s[i - 1], s[i]);
+        }
+    });
+
+    return slab[lid];
+}
+
+template <class Op, class T>
+T group_exclusive_scan(T x, size_t lid, size_t n) {
+    auto const* slab = group_algorithm(x, lid, n, [](T* s, size_t n) {
+        T acc = sycl::detail::known_identity<Op>::template get<T>();
+        for (size_t i = 0; i < n; i++) {
+            T const v = s[i];
+            s[i] = acc;
+            acc = Op()(acc, v);
+        }
+    });
+
+    return slab[lid];
+}
+
+template <class T>
+T group_broadcast(T x, size_t lid, size_t n, size_t from) {
+    auto const* slab = group_algorithm(x, lid, n, [](T*, size_t) {});
+
+    return slab[from];
+}
+
 }  // namespace
 
 CHARM_SYCL_BEGIN_NAMESPACE
@@ -287,18 +710,13 @@ void fiber_init() {
 
     DEBUG_LOG("init: start");
 
-#ifdef HAVE_GET_NPROCS
-    auto const np = get_nprocs();
-#else
-    auto const np = 1;
-#endif
+    auto const np = std::max<int>(get_np(), wg_policy::from_env().n_threads);
 
     DEBUG_FMT("np={}", np);
 
     std::vector<std::unique_ptr<work_group>> buff;
     for (int i = 0; i < np; i++) {
         auto wg = acquire_wg();
-        wg->set_local_range(1, 1, 512);
         wg->set_lmem(256 * 1024);
         buff.push_back(std::move(wg));
     }
@@ -307,37 +725,36 @@ void fiber_init() {
         release_wg(std::move(wg));
     }
 
+    get_worker_pool();
+
     DEBUG_LOG("init: end");
 }
 
 void exec_with_fibers(size_t group_range1, size_t group_range2, size_t group_range3,
                       size_t local_range1, size_t local_range2, size_t local_range3,
-                      size_t lmem_byte, std::function<void(void**)> const& fn, void** args) {
-    DEBUG_FMT("{}(group_range={}, {}, {}, local_range={}, {}, {}, lmem_byte={})", __func__,
-              group_range1, group_range2, group_range3, local_range1, local_range2,
-              local_range3, lmem_byte);
-
-    // #pragma omp parallel for collapse(3)
-    for (size_t i = 0; i < group_range1; i++) {
-        for (size_t j = 0; j < group_range2; j++) {
-            for (size_t k = 0; k < group_range3; k++) {
-                auto wg = acquire_wg();
-
-                wg->set_group_range(group_range1, group_range2, group_range3);
-                wg->set_group_id(i, j, k);
-                wg->set_local_range(local_range1, local_range2, local_range3);
-                wg->set_lmem(lmem_byte);
-                wg->set_func([&]() {
-                    fn(args);
-                });
-
-                while (wg->resume()) {
-                }
-
-                release_wg(std::move(wg));
-            }
-        }
+                      size_t lmem_byte, std::function<kernel_fn_t> const& fn, void** args,
+                      bool barrier_free) {
+    DEBUG_FMT(
+        "{}(group_range={}, {}, {}, local_range={}, {}, {}, lmem_byte={}, barrier_free={})",
+        __func__, group_range1, group_range2, group_range3, local_range1, local_range2,
+        local_range3, lmem_byte, barrier_free);
+
+    wg_job job;
+    job.group_range = {{group_range1, group_range2, group_range3}};
+    job.local_range = {{local_range1, local_range2, local_range3}};
+    job.lmem_byte = lmem_byte;
+    job.fn = &fn;
+    job.args = args;
+    job.n_groups = group_range1 * group_range2 * group_range3;
+    job.n_workers = 0;
+    job.chunk = 0;
+    job.barrier_free = barrier_free;
+
+    if (job.n_groups == 0) {
+        return;
     }
+
+    get_worker_pool().run(job);
 }
 
 }  // namespace runtime::impl
@@ -401,3 +818,28 @@ unsigned long __charm_sycl_fiber_local_range1() {
 unsigned long __charm_sycl_fiber_local_id1() {
     return current_wi->local_id1();
 }
+
+#define CHARM_SYCL_DEFINE_FIBER_GROUP_OP(op, t, T)                                             \
+    extern "C" T __charm_sycl_fiber_group_reduce_##op##_##t(T x, unsigned long lid,            \
+                                                            unsigned long n) {                 \
+        return group_reduce<sycl::op<T>>(x, lid, n);                                           \
+    }                                                                                          \
+                                                                                               \
+    extern "C" T __charm_sycl_fiber_group_inclusive_scan_##op##_##t(T x, unsigned long lid,    \
+                                                                    unsigned long n) {         \
+        return group_inclusive_scan<sycl::op<T>>(x, lid, n);                                   \
+    }                                                                                          \
+                                                                                               \
+    extern "C" T __charm_sycl_fiber_group_exclusive_scan_##op##_##t(T x, unsigned long lid,    \
+                                                                    unsigned long n) {         \
+        return group_exclusive_scan<sycl::op<T>>(x, lid, n);                                   \
+    }
+
+#define CHARM_SYCL_DEFINE_FIBER_GROUP_BROADCAST(t, T)                                      \
+    extern "C" T __charm_sycl_fiber_group_broadcast_##t(T x, unsigned long lid,            \
+                                                        unsigned long n, unsigned long from) { \
+        return group_broadcast(x, lid, n, from);                                           \
+    }
+
+CHARM_SYCL_FOR_EACH_BUILTIN_OP(CHARM_SYCL_DEFINE_FIBER_GROUP_OP)
+CHARM_SYCL_FOR_EACH_BUILTIN_TYPE(CHARM_SYCL_DEFINE_FIBER_GROUP_BROADCAST)
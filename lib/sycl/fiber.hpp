@@ -4,10 +4,26 @@
 CHARM_SYCL_BEGIN_NAMESPACE
 namespace runtime::impl {
 
+/*
+ * The work-item context that the kernels of the CPU targets receive as their second argument.
+ * The generated C code reads the ids directly from it; the layout must match
+ * `struct __charm_sycl_cpu_context` in src/chsy-lower/cpu-c.cpp. Range kernels receive null.
+ */
+struct fiber_context {
+    size_t local_id[3];
+    size_t group_id[3];
+    size_t local_range[3];
+    size_t group_range[3];
+    void* local_memory;
+};
+
+using kernel_fn_t = void(void**, void*);
+
 void fiber_init();
 void exec_with_fibers(size_t group_range1, size_t group_range2, size_t group_range3,
                       size_t local_range1, size_t local_range2, size_t local_range3,
-                      size_t lmem_byte, std::function<void(void**)> const& fn, void** args);
+                      size_t lmem_byte, std::function<kernel_fn_t> const& fn, void** args,
+                      bool barrier_free = false);
 
 }  // namespace runtime::impl
 CHARM_SYCL_END_NAMESPACE
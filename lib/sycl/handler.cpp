@@ -77,11 +77,19 @@ CHARM_SYCL_BEGIN_NAMESPACE
 namespace runtime::impl {
 
 handler_impl::handler_impl(queue_impl& q)
-    : q_(q), task_(impl::global_state::get_depmgr()->new_task()), lmem_(0) {
+    : q_(q),
+      graph_(q.recording()),
+      order_(graph_ ? std::unique_lock<std::recursive_mutex>() : q.lock_order()),
+      task_(graph_ ? graph_->new_task() : impl::global_state::get_depmgr()->new_task()),
+      lmem_(0) {
     if (q.profiling_enabled()) {
         task_->enable_profiling();
     }
 
+    if (order_.owns_lock()) {
+        task_->set_chain(q_.chain_id());
+    }
+
     auto d = static_pointer_cast<impl::device_impl>(q_.get_device())->to_lower();
 
     if (d->is_host()) {
@@ -92,10 +100,20 @@ handler_impl::handler_impl(queue_impl& q)
 }
 
 void handler_impl::depends_on(event_ptr const& event) {
+    if (record_dependency(*task_, event)) {
+        return;
+    }
+
+    // A command group that is not recorded cannot wait for a recorded one, which is executed
+    // only when its graph is replayed.
+    if (is_recorded_event(*event)) {
+        return;
+    }
+
     task_->depends_on(*static_pointer_cast<dep::event>(event));
 }
 
-void handler_impl::single_task(char const* name, uint32_t hash) {
+void handler_impl::single_task(runtime::kernel_handle const& kernel) {
     auto d = static_pointer_cast<impl::device_impl>(q_.get_device())->to_lower();
 
     if (d->is_host()) {
@@ -104,11 +122,12 @@ void handler_impl::single_task(char const* name, uint32_t hash) {
         abort();
     }
 
-    task_->set_kernel(name, hash);
+    task_->set_kernel(kernel);
     task_->set_single();
 }
 
-void handler_impl::parallel_for(sycl::range<3> const& range, char const* name, uint32_t hash) {
+void handler_impl::parallel_for(sycl::range<3> const& range,
+                                runtime::kernel_handle const& kernel) {
     auto d = static_pointer_cast<impl::device_impl>(q_.get_device())->to_lower();
 
     if (d->is_host()) {
@@ -117,12 +136,12 @@ void handler_impl::parallel_for(sycl::range<3> const& range, char const* name, u
         abort();
     }
 
-    task_->set_kernel(name, hash);
+    task_->set_kernel(kernel);
     task_->set_range(impl::convert(range));
 }
 
-void handler_impl::parallel_for(sycl::nd_range<3> const& range, char const* name,
-                                uint32_t hash) {
+void handler_impl::parallel_for(sycl::nd_range<3> const& range,
+                                runtime::kernel_handle const& kernel) {
     auto d = static_pointer_cast<impl::device_impl>(q_.get_device())->to_lower();
 
     if (d->is_host()) {
@@ -131,7 +150,7 @@ void handler_impl::parallel_for(sycl::nd_range<3> const& range, char const* name
         abort();
     }
 
-    task_->set_kernel(name, hash);
+    task_->set_kernel(kernel);
     task_->set_nd_range(impl::convert(range));
     task_->set_local_mem_size(lmem_);
 }
@@ -149,8 +168,21 @@ void handler_impl::set_desc(void const* desc) {
 }
 
 intrusive_ptr<runtime::event> handler_impl::finalize() {
+    // The previous command group is looked up only now, since the command-group function may
+    // have submitted to the same queue.
+    if (order_.owns_lock()) {
+        if (auto ev = q_.pending_event()) {
+            task_->depends_on(*static_pointer_cast<dep::event>(ev));
+        }
+    }
+
     auto ev = impl::make_event(task_->submit());
     q_.add(ev);
+
+    if (order_.owns_lock()) {
+        order_.unlock();
+    }
+
     return ev;
 }
 
@@ -162,8 +194,9 @@ static inline auto to_mode(std::underlying_type_t<access_mode> mode) {
     return static_cast<access_mode>(mode);
 }
 
-void handler_impl::reserve_binds(size_t n) {
+void handler_impl::reserve_binds(size_t n, size_t param_byte) {
     pairs_.resize(n, access_pair{});
+    param_byte_ = param_byte;
 }
 
 void handler_impl::pre_bind(size_t idx, runtime::accessor_ptr const& acc) {
@@ -173,6 +206,11 @@ void handler_impl::pre_bind(size_t idx, runtime::accessor_ptr const& acc) {
     pair.idx = idx;
     pair.buff = acc_->get_buffer().get();
     pair.mode = acc_->get_access_mode();
+    pair.lo = acc_->get_offset();
+    pair.hi = id<3>(pair.lo[0] + acc_->get_range()[0], pair.lo[1] + acc_->get_range()[1],
+                    pair.lo[2] + acc_->get_range()[2]);
+
+    task_->use_buffer(*acc_->get()->to_lower());
 }
 
 void handler_impl::pre_bind(size_t idx, local_accessor_ptr const&) {
@@ -184,7 +222,10 @@ void handler_impl::pre_bind(size_t idx, void const*, size_t) {
 }
 
 void handler_impl::begin_binds() {
-    task_->begin_params();
+    // A command without binds, e.g., a copy, reserves nothing.
+    auto const byte = std::exchange(param_byte_, 0);
+
+    task_->begin_params(byte > 0 ? pairs_.size() : 0, byte);
 }
 
 void handler_impl::end_pre_binds() {
@@ -203,18 +244,27 @@ void handler_impl::bind(size_t idx, intrusive_ptr<runtime::accessor> const& acc)
                                  std::make_pair(idx, acc_->get_buffer().get()));
     auto const is_first = head == pairs_.begin() || head->buff != std::prev(head)->buff;
     auto dep_mode = dep::memory_access::none;
+    auto lo = head->lo;
+    auto hi = head->hi;
 
     if (is_first) {
         access_mode mode = to_mode(0);
 
+        // The dependency of the buffer covers the union of all accessors to it.
         for (auto it = head; it != pairs_.end() && it->buff == head->buff; ++it) {
             mode = to_mode(to_int(mode) | to_int(it->mode));
+
+            for (int d = 0; d < 3; d++) {
+                lo[d] = std::min(lo[d], it->lo[d]);
+                hi[d] = std::max(hi[d], it->hi[d]);
+            }
         }
 
         dep_mode = to_dep(mode);
     }
 
-    task_->set_buffer_param(*acc_->get()->to_lower(), dep_mode, to_dep(acc->get_offset()),
+    task_->set_buffer_param(*acc_->get()->to_lower(), dep_mode, to_dep(lo),
+                            dep::range(hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2]),
                             compute_offset(acc_) * elem);
 }
 
@@ -390,9 +440,21 @@ void handler_impl::copy(void const* src, intrusive_ptr<accessor> const& dst) {
 
 void handler_impl::fill_zero(accessor_ptr const& src, size_t len_byte) {
     auto src_ = static_pointer_cast<accessor_impl>(src)->get()->to_lower();
+
+    std::scoped_lock lk(*this);
     task_->fill_zero(*src_, len_byte);
 }
 
+void handler_impl::memcpy(void* dest, void const* src, size_t len_byte) {
+    std::scoped_lock lk(*this);
+    task_->copy_usm(src, dest, len_byte);
+}
+
+void handler_impl::fill(void* dest, void const* pattern, size_t pattern_byte, size_t count) {
+    std::scoped_lock lk(*this);
+    task_->fill_usm(dest, pattern, pattern_byte, count);
+}
+
 size_t handler_impl::alloc_smem(size_t byte, size_t align, bool is_array) {
     auto off = lmem_;
 
@@ -1,7 +1,7 @@
 #pragma once
 
-#include <BS_thread_pool.hpp>
 #include "../cuda/context.hpp"
+#include "../dev_rts.hpp"
 #include "../logging.hpp"
 
 CHARM_SYCL_BEGIN_NAMESPACE
@@ -87,7 +87,7 @@ struct hip_contexts {
     inline static std::vector<std::unique_ptr<hip_context<HIP, BLAS, SOL>>> workspaces;
 
     static auto* get() {
-        auto const tid = *BS::this_thread::get_index();
+        auto const tid = ::dev_rts::task_pool::this_worker_index();
         auto& ptr = workspaces[tid];
 
         if (!ptr) {
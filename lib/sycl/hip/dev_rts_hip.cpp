@@ -4,6 +4,7 @@
 #include <blas/rocblas_interface.hpp>
 #include <blas/rocsolver_interface.hpp>
 #include "../dev_rts.hpp"
+#include "../dev_rts/kernel_cache.hpp"
 #include "../interfaces.hpp"
 #include "../logging.hpp"
 #include "context.hpp"
@@ -19,6 +20,12 @@ LOGGING_DEFINE_SCOPE(hip)
 
 using namespace dev_rts;
 
+// The functions resolved from the module. They are reset when the module is unloaded.
+sycl::dev_rts::kernel_cache& functions() {
+    static sycl::dev_rts::kernel_cache cache(sycl::runtime::kernel_handle::HIP);
+    return cache;
+}
+
 template <class HIP>
 inline void check_hip_error(typename HIP::error_t err, char const* expr) {
     if (err != HIP::k_Success) {
@@ -55,11 +62,7 @@ struct platform_impl final : platform_base<device_impl> {
     }
 };
 
-struct event_node_impl final : event_node<event_node_impl> {
-    static auto create() {
-        return std::make_shared<event_node_impl>();
-    }
-};
+struct event_node_impl final : event_node<event_node_impl> {};
 
 using event_ptr = event_node_impl::event_ptr;
 
@@ -122,41 +125,33 @@ struct task_impl final : rts::task,
     void depends_on(std::shared_ptr<rts::task> const& dep) override {
         assert(dep != nullptr);
 
-        auto dep_ = dynamic_cast<task_impl const&>(*dep);
+        auto const& dep_ = dynamic_cast<task_impl const&>(*dep);
 
         if (auto pre = dep_.wk_.lock()) {
             pre->happens_before(ev_);
         }
     }
 
+    bool is_complete() const override {
+        auto ev = wk_.lock();
+        return !ev || ev->is_done();
+    }
+
+    void reserve_params(size_t n_params, size_t byte) override {
+        task_parameter_storage::reserve(n_params, byte);
+    }
+
     void set_param(void const* ptr, size_t size) override {
         std::memcpy(next_param_ptr(size), ptr, size);
     }
 
     void set_buffer_param(rts::buffer& buf, void* h_ptr, rts::memory_domain const& dom,
-                          rts::memory_access ma, rts::id const&, size_t offset_byte) override {
+                          rts::memory_access ma, rts::id const&, size_t offset_byte,
+                          rts::region_list const& xfer) override {
         auto& buf_ = static_cast<buffer_impl<HIP>&>(buf);
-        auto const htod =
-            (ma != rts::memory_access::write_only) && is_device_task_ && dom.is_host();
-        auto const dtoh =
-            (ma != rts::memory_access::write_only) && !is_device_task_ && !dom.is_host();
-
-        if (htod) {
-            pre_ = [h_ptr, ptr = buf_.get(), length = buf_.byte_size(),
-                    next = std::move(pre_)](stream_t stream) {
-                _(HIP::hip_memcpy_htod_async(ptr, h_ptr, length, stream));
-                if (next) {
-                    next(stream);
-                }
-            };
-        } else if (dtoh) {
-            pre_ = [h_ptr, ptr = buf_.get(), length = buf_.byte_size(),
-                    next = std::move(pre_)](stream_t stream) {
-                _(HIP::hip_memcpy_dtoh_async(h_ptr, ptr, length, stream));
-                if (next) {
-                    next(stream);
-                }
-            };
+
+        if (ma != rts::memory_access::write_only) {
+            transfer(buf, h_ptr, dom, xfer);
         }
 
         auto* ptr = next_param_ptr<typename deviceptr_t::native>();
@@ -164,6 +159,34 @@ struct task_impl final : rts::task,
         *ptr = dev_rts::advance_ptr(*buf_.get(), offset_byte);
     }
 
+    void transfer(rts::buffer& buf, void* h_ptr, rts::memory_domain const& src,
+                  rts::region_list const& xfer) override {
+        auto const htod = is_device_task_ && src.is_host();
+        auto const dtoh = !is_device_task_ && !src.is_host();
+
+        for (auto const& r : xfer) {
+            if (htod) {
+                pre_ = [h_ptr = dev_rts::advance_ptr(h_ptr, r.begin),
+                        ptr = get_ptr(buf, r.begin), length = r.size(),
+                        next = std::move(pre_)](stream_t stream) {
+                    _(HIP::hip_memcpy_htod_async(ptr, h_ptr, length, stream));
+                    if (next) {
+                        next(stream);
+                    }
+                };
+            } else if (dtoh) {
+                pre_ = [h_ptr = dev_rts::advance_ptr(h_ptr, r.begin),
+                        ptr = get_ptr(buf, r.begin), length = r.size(),
+                        next = std::move(pre_)](stream_t stream) {
+                    _(HIP::hip_memcpy_dtoh_async(h_ptr, ptr, length, stream));
+                    if (next) {
+                        next(stream);
+                    }
+                };
+            }
+        }
+    }
+
     static inline deviceptr_t get_ptr(rts::buffer& buf, size_t off_byte) {
         return deviceptr_t(
             dev_rts::advance_ptr(*static_cast<buffer_impl<HIP>&>(buf).get(), off_byte));
@@ -347,9 +370,13 @@ struct task_impl final : rts::task,
         };
     }
 
-    void set_kernel(char const* name, uint32_t) override {
-        DEBUG_FMT("set_kernel({})", name);
-        _(HIP::hip_module_get_function(&fn_, mod_, name));
+    void set_kernel(sycl::runtime::kernel_handle const& kernel) override {
+        DEBUG_FMT("set_kernel({})", kernel.name);
+        fn_ = function_t(functions().get(kernel, [&] {
+            function_t fn;
+            _(HIP::hip_module_get_function(&fn, mod_, kernel.name));
+            return fn.get();
+        }));
     }
 
     void set_desc(rts::func_desc const* desc) override {
@@ -450,7 +477,7 @@ private:
                               format::ptr(*fn_), gx, gy, gz, bx, by, bz, lmem_);
 
                     _(HIP::hip_module_launch_kernel(fn_, gx, gy, gz, bx, by, bz, lmem_, stream,
-                                                    args_.data(), nullptr));
+                                                    data(), nullptr));
                 };
             } else {
                 body_ = [this](stream_t stream) {
@@ -461,7 +488,7 @@ private:
                               format::ptr(*fn_), gx, gy, gz, bx, by, bz, lmem_);
 
                     _(HIP::hip_module_launch_kernel(fn_, gx, gy, gz, bx, by, bz, lmem_, stream,
-                                                    args_.data(), nullptr));
+                                                    data(), nullptr));
                 };
             }
         }
@@ -515,7 +542,7 @@ private:
                 *next_param_ptr<stream_t>() = strm;
             }
 
-            desc_->hip(args_.data());
+            desc_->hip(data());
         };
     }
 
@@ -563,13 +590,14 @@ struct subsystem_impl final : subsystem_base<platform_impl, buffer_impl<HIP>> {
 
         int constexpr n_threads = 4;
         sycl::runtime::hip_contexts<HIP, BLAS, SOL>::workspaces.resize(n_threads);
-        q_task.reset(new BS::thread_pool(n_threads));
+        q_task.reset(new task_pool(n_threads));
     }
 
     void shutdown() override {
         q_task->wait();
         q_task.reset();
         sycl::runtime::hip_contexts<HIP, BLAS, SOL>::workspaces.clear();
+        functions().clear();
 
         if (auto const mod = std::exchange(mod_, {})) {
             _(HIP::hip_module_unload(mod));
@@ -0,0 +1,169 @@
+#include "host_memory.hpp"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+#include <strings.h>
+#ifdef __linux__
+#    include <sys/mman.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#endif
+#include "format.hpp"
+#include "logging.hpp"
+
+namespace {
+
+LOGGING_DEFINE_SCOPE(host_memory)
+
+using policy = CHARM_SYCL_NS::rts::host_memory_policy;
+
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+policy parse_env() {
+    policy p;
+
+    if (auto const* v = std::getenv("CHARM_SYCL_HOST_MEMORY_PLACEMENT")) {
+        p.requested = true;
+
+        if (strcasecmp(v, "interleave") == 0) {
+            p.place = policy::placement::interleave;
+        } else if (strncasecmp(v, "node:", 5) == 0) {
+            p.place = policy::placement::bind;
+            p.node = std::atoi(v + 5);
+        }
+    }
+
+    if (auto const* v = std::getenv("CHARM_SYCL_HOST_MEMORY_PAGES")) {
+        p.requested = true;
+
+        if (strcasecmp(v, "thp") == 0) {
+            p.page = policy::pages::transparent_huge;
+        } else if (strcasecmp(v, "huge") == 0) {
+            p.page = policy::pages::huge;
+        }
+    }
+
+    return p;
+}
+
+#ifdef __linux__
+
+// From <linux/mempolicy.h>, which is not installed everywhere.
+constexpr int MPOL_BIND_ = 2;
+constexpr int MPOL_INTERLEAVE_ = 3;
+constexpr size_t MAX_NODES = 1024;
+
+// Maps `byte` bytes aligned to a huge page. Returns nullptr on failure.
+void* map_aligned(size_t byte, bool explicit_huge) {
+    if (explicit_huge) {
+        auto* ptr = ::mmap(nullptr, byte, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (ptr != MAP_FAILED) {
+            return ptr;
+        }
+        DEBUG_LOG("no explicit huge pages available, falling back to transparent ones");
+    }
+
+    auto const len = byte + HUGE_PAGE_SIZE;
+    auto* raw =
+        ::mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        return nullptr;
+    }
+
+    auto const addr = reinterpret_cast<uintptr_t>(raw);
+    auto const aligned = (addr + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    auto const head = aligned - addr;
+    auto const tail = len - head - byte;
+
+    if (head > 0) {
+        ::munmap(raw, head);
+    }
+    if (tail > 0) {
+        ::munmap(reinterpret_cast<void*>(aligned + byte), tail);
+    }
+
+    return reinterpret_cast<void*>(aligned);
+}
+
+void apply_placement(void* ptr, size_t byte, policy const& p) {
+    constexpr size_t BITS = 8 * sizeof(unsigned long);
+    unsigned long mask[MAX_NODES / BITS] = {};
+    int mode;
+
+    if (p.place == policy::placement::interleave) {
+        // Nodes outside of the allowed set are ignored by the kernel.
+        std::memset(mask, 0xff, sizeof(mask));
+        mode = MPOL_INTERLEAVE_;
+    } else if (p.node >= 0 && static_cast<size_t>(p.node) < MAX_NODES) {
+        mask[p.node / BITS] |= 1ul << (p.node % BITS);
+        mode = MPOL_BIND_;
+    } else {
+        DEBUG_FMT("invalid NUMA node: {}", p.node);
+        return;
+    }
+
+    if (::syscall(SYS_mbind, ptr, byte, mode, mask, MAX_NODES, 0) != 0) {
+        DEBUG_FMT("mbind failed: {}", std::strerror(errno));
+    }
+}
+
+#endif
+
+}  // namespace
+
+CHARM_SYCL_BEGIN_NAMESPACE
+
+namespace rts {
+
+host_memory_policy const& host_memory_policy::from_env() {
+    static auto const p = parse_env();
+    return p;
+}
+
+void host_memory_deleter::operator()(void* ptr) const {
+#ifdef __linux__
+    if (mapped_byte > 0) {
+        ::munmap(ptr, mapped_byte);
+        return;
+    }
+#endif
+    std::free(ptr);
+}
+
+host_memory_ptr alloc_host_memory(size_t byte, host_memory_policy const& policy) {
+    init_logging();
+
+#ifdef __linux__
+    if (policy.requested && byte >= HUGE_PAGE_SIZE) {
+        auto const mapped = (byte + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+
+        if (auto* ptr = map_aligned(mapped, policy.page == host_memory_policy::pages::huge)) {
+            host_memory_ptr res(ptr, host_memory_deleter{mapped});
+
+            if (policy.page != host_memory_policy::pages::normal) {
+                ::madvise(ptr, mapped, MADV_HUGEPAGE);
+            }
+
+            if (policy.place != host_memory_policy::placement::first_touch) {
+                apply_placement(ptr, mapped, policy);
+            }
+
+            DEBUG_FMT("alloc: {} bytes at {} (placement={}, node={}, pages={})", mapped,
+                      format::ptr(ptr), static_cast<int>(policy.place), policy.node,
+                      static_cast<int>(policy.page));
+
+            return res;
+        }
+    }
+#else
+    (void)policy;
+#endif
+
+    return host_memory_ptr(std::calloc(byte, 1), host_memory_deleter{});
+}
+
+}  // namespace rts
+
+CHARM_SYCL_END_NAMESPACE
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <memory>
+#include <charm/sycl/config.hpp>
+
+CHARM_SYCL_BEGIN_NAMESPACE
+
+namespace rts {
+
+/*
+ * Placement of the host memory that the runtime allocates for buffers without host data.
+ *
+ *   CHARM_SYCL_HOST_MEMORY_PLACEMENT=first_touch|interleave|node:<n>
+ *   CHARM_SYCL_HOST_MEMORY_PAGES=normal|thp|huge
+ *
+ * first_touch leaves the pages unplaced, so that each one lands on the node of the thread
+ * that writes it first, usually in the first kernel that writes the buffer; interleave
+ * spreads the pages round-robin over all NUMA nodes; node:<n> binds them to node n. thp
+ * requests transparent huge pages, huge maps explicit 2 MiB pages and falls back to
+ * transparent ones if none are reserved.
+ *
+ * The memory comes from calloc unless the buffer property or one of the variables above asks
+ * for a policy, and always for allocations smaller than a huge page.
+ */
+struct host_memory_policy {
+    enum class placement { first_touch, interleave, bind };
+    enum class pages { normal, transparent_huge, huge };
+
+    static host_memory_policy const& from_env();
+
+    placement place = placement::first_touch;
+    int node = 0;
+    pages page = pages::normal;
+    // Whether the buffer property or the environment set the policy.
+    bool requested = false;
+};
+
+struct host_memory_deleter {
+    void operator()(void* ptr) const;
+
+    size_t mapped_byte = 0;  // 0 if the memory comes from calloc
+};
+
+using host_memory_ptr = std::unique_ptr<void, host_memory_deleter>;
+
+// Allocates `byte` bytes of zero-filled memory.
+host_memory_ptr alloc_host_memory(size_t byte, host_memory_policy const& policy);
+
+}  // namespace rts
+
+CHARM_SYCL_END_NAMESPACE
@@ -413,6 +413,10 @@ struct event_impl final : rts::event {
         return empty_;
     }
 
+    bool is_complete() const override {
+        return empty_;
+    }
+
     uint64_t profiling_command_submit() override {
         IRIS::iris_synchronize();
 
@@ -526,9 +530,9 @@ struct task_impl final : rts::task, std::enable_shared_from_this<task_impl<IRIS>
 
     /* ----------- */
 
-    void set_kernel(char const* name, uint32_t) override {
+    void set_kernel(sycl::runtime::kernel_handle const& kernel) override {
         kernel_.emplace();
-        if (IRIS::iris_kernel_create(name, &*kernel_) != IRIS::SUCCESS) {
+        if (IRIS::iris_kernel_create(kernel.name, &*kernel_) != IRIS::SUCCESS) {
             throw std::runtime_error("iris_kernel_create() failed");
         }
         empty_ = false;
@@ -598,43 +602,19 @@ struct task_impl final : rts::task, std::enable_shared_from_this<task_impl<IRIS>
     }
 
     void set_buffer_param(rts::buffer& buf, void* h_ptr, rts::memory_domain const& dom,
-                          rts::memory_access ma, rts::id const& offset,
-                          size_t offset_byte) override {
+                          rts::memory_access ma, rts::id const& offset, size_t offset_byte,
+                          rts::region_list const& xfer) override {
         auto& buf_ = static_cast<buffer_impl<IRIS>&>(buf);
-        auto const htod = (ma != rts::memory_access::write_only) && !is_host_ && dom.is_host();
-        auto const dtoh = (ma != rts::memory_access::write_only) && is_host_ && !dom.is_host();
 
         (void)offset;
         DEBUG_FMT(
-            "set_buffer_param(h_ptr={}, dom={}, ma={}, off=[{}, {}, {}], off_byte={}) htod={} "
-            "dtoh={}",
+            "set_buffer_param(h_ptr={}, dom={}, ma={}, off=[{}, {}, {}], off_byte={}) "
+            "n_xfer={}",
             format::ptr(h_ptr), dom.id(), static_cast<int>(ma), offset.size[0], offset.size[1],
-            offset.size[2], offset_byte, htod, dtoh);
+            offset.size[2], offset_byte, xfer.size());
 
-#ifdef CHARM_SYCL_USE_IRIS_DMEM
-        (void)h_ptr;
-#endif
-
-        if (htod) {
-#ifndef CHARM_SYCL_USE_IRIS_DMEM
-            if (IRIS::iris_task_h2d(*task_, buf_.get(), buf_.offset_byte(), buf_.size_byte(),
-                                    h_ptr) != IRIS::SUCCESS) {
-                throw std::runtime_error("iris_task_h2d() failed");
-            }
-#endif
-            empty_ = false;
-        } else if (dtoh) {
-#ifndef CHARM_SYCL_USE_IRIS_DMEM
-            if (IRIS::iris_task_d2h(*task_, buf_.get(), buf_.offset_byte(), buf_.size_byte(),
-                                    h_ptr) != IRIS::SUCCESS) {
-                throw std::runtime_error("iris_task_d2h() failed");
-            }
-#else
-            if (IRIS::iris_task_dmem_flush_out(*task_, buf_.get()) != IRIS::SUCCESS) {
-                throw std::runtime_error("iris_task_dmem_flush_out() failed");
-            }
-#endif
-            empty_ = false;
+        if (ma != rts::memory_access::write_only) {
+            transfer(buf, h_ptr, dom, xfer);
         }
 
         if (kernel_) {
@@ -665,6 +645,42 @@ struct task_impl final : rts::task, std::enable_shared_from_this<task_impl<IRIS>
         arg_idx_ += 1;
     }
 
+    void transfer(rts::buffer& buf, void* h_ptr, rts::memory_domain const& src,
+                  rts::region_list const& xfer) override {
+        auto& buf_ = static_cast<buffer_impl<IRIS>&>(buf);
+        auto const htod = !is_host_ && src.is_host();
+        auto const dtoh = is_host_ && !src.is_host();
+
+#ifdef CHARM_SYCL_USE_IRIS_DMEM
+        (void)h_ptr;
+
+        if ((htod || dtoh) && !xfer.empty()) {
+            if (dtoh && IRIS::iris_task_dmem_flush_out(*task_, buf_.get()) != IRIS::SUCCESS) {
+                throw std::runtime_error("iris_task_dmem_flush_out() failed");
+            }
+            empty_ = false;
+        }
+#else
+        for (auto const& r : xfer) {
+            auto* h_ptr_r = static_cast<std::byte*>(h_ptr) + r.begin;
+
+            if (htod) {
+                if (IRIS::iris_task_h2d(*task_, buf_.get(), buf_.offset_byte() + r.begin,
+                                        r.size(), h_ptr_r) != IRIS::SUCCESS) {
+                    throw std::runtime_error("iris_task_h2d() failed");
+                }
+                empty_ = false;
+            } else if (dtoh) {
+                if (IRIS::iris_task_d2h(*task_, buf_.get(), buf_.offset_byte() + r.begin,
+                                        r.size(), h_ptr_r) != IRIS::SUCCESS) {
+                    throw std::runtime_error("iris_task_d2h() failed");
+                }
+                empty_ = false;
+            }
+        }
+#endif
+    }
+
     /* ----------- */
 
     void copy_1d(rts::buffer&, size_t, rts::buffer&, size_t, size_t) override {
@@ -15,7 +15,7 @@ namespace {
 namespace rts = CHARM_SYCL_NS::rts;
 namespace impl = CHARM_SYCL_NS::runtime::impl;
 
-using dev_fn_t = void (*)(void**);
+using dev_fn_t = impl::kernel_fn_t*;
 
 static std::mutex g_mutex;
 static std::unique_lock<std::mutex> g_lock;
@@ -95,9 +95,10 @@ extern "C" int iris_openmp_launch([[maybe_unused]] int dim, [[maybe_unused]] siz
         // This will be UB if the memory layout of the struct iris::Command is changed.
         size_t const* lws = &gws[3];
         impl::exec_with_fibers(gws[0] / lws[0], gws[1] / lws[1], gws[2] / lws[2], lws[0],
-                               lws[1], lws[2], 256 * 1024, fn, g_args.data());
+                               lws[1], lws[2], 256 * 1024, fn, g_args.data(),
+                               g_kinfo->is_barrier_free());
     } else {
-        fn(g_args.data());
+        fn(g_args.data(), nullptr);
     }
 
     return SUCCESS;
@@ -15,8 +15,14 @@ struct kernel_info {
 
     explicit kernel_info(void* f, int n) : fn(f), is_ndr(n) {}
 
+    // An nd_range kernel that never reaches group_barrier. Its work-items can run one after
+    // another on the same stack.
+    bool is_barrier_free() const {
+        return is_ndr == 2;
+    }
+
     void* fn = nullptr;
-    int is_ndr = 0;
+    int is_ndr = 0;  // 0: range, 1: nd_range, 2: nd_range without group barriers
 };
 
 struct kernel_registry {
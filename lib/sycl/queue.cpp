@@ -1,13 +1,28 @@
 #include <charm/sycl.hpp>
 #include "rt.hpp"
+#include <atomic>
 
 CHARM_SYCL_BEGIN_NAMESPACE
 
 namespace runtime::impl {
 
+namespace {
+
+uint64_t next_chain_id() {
+    static std::atomic<uint64_t> next = 1;
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+}  // namespace
+
 queue_impl::queue_impl(intrusive_ptr<context> ctx, intrusive_ptr<device> dev,
-                       sycl::property::queue::enable_profiling const* enable_profiling)
-    : ctx_(ctx), dev_(dev), profiling_enabled_(enable_profiling != nullptr) {
+                       sycl::property::queue::enable_profiling const* enable_profiling,
+                       sycl::property::queue::in_order const* in_order)
+    : ctx_(ctx),
+      dev_(dev),
+      profiling_enabled_(enable_profiling != nullptr),
+      in_order_(in_order != nullptr),
+      chain_id_(next_chain_id()) {
     events_.reserve(16);
 }
 
@@ -23,13 +38,41 @@ intrusive_ptr<context> queue_impl::get_context() const {
     return ctx_;
 }
 
+bool queue_impl::is_in_order() const {
+    return in_order_;
+}
+
 void queue_impl::add(intrusive_ptr<runtime::event> const& ev) {
+    // Nothing runs while recording; the graph adds its own event on replay.
+    if (is_recorded_event(*ev)) {
+        return;
+    }
+
+    std::unique_lock lk(mutex_);
+
     events_.push_back(ev);
+    if (in_order_) {
+        last_ = ev;
+    }
+
+    if (events_.size() >= reclaim_size_) {
+        reclaim();
+    }
 }
 
 void queue_impl::wait() {
-    if (!events_.empty()) {
-        auto events = std::move(events_);
+    std::unique_lock lk(mutex_);
+    auto events = std::move(events_);
+
+    events_.clear();
+    reclaim_size_ = MIN_RECLAIM_SIZE;
+    lk.unlock();
+
+    std::erase_if(events, [](auto const& ev) {
+        return ev->is_complete();
+    });
+
+    if (!events.empty()) {
         auto barrier = events.front()->create_barrier();
 
         for (auto& ev : events) {
@@ -46,14 +89,39 @@ bool queue_impl::profiling_enabled() const {
     return profiling_enabled_;
 }
 
+std::unique_lock<std::recursive_mutex> queue_impl::lock_order() {
+    if (!in_order_) {
+        return {};
+    }
+    return std::unique_lock(order_mutex_);
+}
+
+intrusive_ptr<runtime::event> queue_impl::pending_event() {
+    std::unique_lock lk(mutex_);
+
+    if (last_ && last_->is_complete()) {
+        last_ = {};
+    }
+    return last_;
+}
+
+void queue_impl::reclaim() {
+    std::erase_if(events_, [](auto const& ev) {
+        return ev->is_complete();
+    });
+
+    reclaim_size_ = std::max(MIN_RECLAIM_SIZE, 2 * events_.size());
+}
+
 }  // namespace runtime::impl
 
 namespace runtime {
 
-intrusive_ptr<queue> make_queue(
-    intrusive_ptr<context> const& ctx, intrusive_ptr<device> const& dev,
-    sycl::property::queue::enable_profiling const* enable_profiling) {
-    return make_intrusive<impl::queue_impl>(ctx, dev, enable_profiling);
+intrusive_ptr<queue> make_queue(intrusive_ptr<context> const& ctx,
+                                intrusive_ptr<device> const& dev,
+                                sycl::property::queue::enable_profiling const* enable_profiling,
+                                sycl::property::queue::in_order const* in_order) {
+    return make_intrusive<impl::queue_impl>(ctx, dev, enable_profiling, in_order);
 }
 
 }  // namespace runtime
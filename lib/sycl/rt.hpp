@@ -1,6 +1,7 @@
 #pragma once
 #include <charm/sycl.hpp>
 #include "dep.hpp"
+#include "dev_rts/pool.hpp"
 #include "error.hpp"
 #include "rts.hpp"
 
@@ -10,6 +11,7 @@ namespace runtime::impl {
 
 struct accessor_impl;
 struct buffer_impl;
+struct command_graph_impl;
 struct device_impl;
 struct event_impl;
 struct handler_impl;
@@ -35,6 +37,9 @@ intrusive_ptr<runtime::event> make_event(std::unique_ptr<dep::event>&& ev);
 intrusive_ptr<accessor_impl> make_accessor(intrusive_ptr<buffer_impl> buf, range<3> range,
                                            id<3> offset, access_mode mode);
 
+// Whether `ev` was returned by a command group submitted while a command_graph was recording.
+bool is_recorded_event(runtime::event const& ev);
+
 struct platform_impl final : runtime::platform,
                              runtime::enable_intrsuive_from_this<platform_impl> {
     platform_impl(std::shared_ptr<dep::platform> p);
@@ -54,7 +59,8 @@ private:
 };
 
 struct buffer_impl final : runtime::buffer {
-    explicit buffer_impl(void* init_ptr, size_t elemsize, sycl::range<3> const& rng);
+    explicit buffer_impl(void* init_ptr, size_t elemsize, sycl::range<3> const& rng,
+                         sycl::property::buffer::host_memory const* host_mem);
 
     void write_back() override;
 
@@ -113,7 +119,8 @@ private:
 
 struct queue_impl final : runtime::queue, std::enable_shared_from_this<queue_impl> {
     explicit queue_impl(intrusive_ptr<runtime::context> ctx, intrusive_ptr<runtime::device> dev,
-                        sycl::property::queue::enable_profiling const* enable_profiling);
+                        sycl::property::queue::enable_profiling const* enable_profiling,
+                        sycl::property::queue::in_order const* in_order);
 
     sycl::backend get_backend() const noexcept override;
 
@@ -121,35 +128,84 @@ struct queue_impl final : runtime::queue, std::enable_shared_from_this<queue_imp
 
     runtime::context_ptr get_context() const override;
 
+    bool is_in_order() const override;
+
     void add(runtime::event_ptr const&) override;
 
     void wait() override;
 
     bool profiling_enabled() const;
 
+    // Serializes the command groups of an in-order queue from the creation of their handler to
+    // their submission. The returned lock does not own a mutex if the queue is not in order.
+    // The mutex is recursive, since a command-group function may submit to the same queue, e.g.
+    // to initialize a reduction variable; such a command group joins the enclosing one.
+    std::unique_lock<std::recursive_mutex> lock_order();
+
+    // The event of the last command group of an in-order queue, or nullptr if it has completed.
+    intrusive_ptr<runtime::event> pending_event();
+
+    // Unique among all queues ever created, unlike the address of the queue.
+    uint64_t chain_id() const {
+        return chain_id_;
+    }
+
+    // The graph that captures the command groups submitted to this queue, if any. Command
+    // groups may be submitted from other threads while a graph starts or stops recording.
+    command_graph_impl* recording() const {
+        return recording_.load(std::memory_order_acquire);
+    }
+
+    // Returns false if another graph is recording the queue.
+    bool start_recording(command_graph_impl* graph) {
+        command_graph_impl* expected = nullptr;
+        return recording_.compare_exchange_strong(expected, graph, std::memory_order_acq_rel);
+    }
+
+    void stop_recording() {
+        recording_.store(nullptr, std::memory_order_release);
+    }
+
 private:
+    static constexpr size_t MIN_RECLAIM_SIZE = 64;
+
+    void reclaim();
+
     intrusive_ptr<runtime::context> ctx_;
     intrusive_ptr<runtime::device> dev_;
+    std::mutex mutex_;
+    // The events that have not been waited for. Completed events are dropped when the vector
+    // reaches `reclaim_size_`, so it stays within twice the number of outstanding events.
     std::vector<intrusive_ptr<runtime::event>> events_;
+    size_t reclaim_size_ = MIN_RECLAIM_SIZE;
     bool profiling_enabled_;
+    bool in_order_;
+    uint64_t chain_id_;
+    std::recursive_mutex order_mutex_;
+    intrusive_ptr<runtime::event> last_;
+    std::atomic<command_graph_impl*> recording_ = nullptr;
 };
 
-struct handler_impl final : runtime::handler, std::enable_shared_from_this<handler_impl> {
+struct handler_impl final : runtime::handler,
+                            std::enable_shared_from_this<handler_impl>,
+                            dev_rts::pooled<handler_impl> {
     explicit handler_impl(queue_impl& q);
 
     void depends_on(event_ptr const&) override;
 
-    void single_task(char const* name, uint32_t hash) override;
+    void single_task(runtime::kernel_handle const& kernel) override;
 
-    void parallel_for(sycl::range<3> const& range, char const* name, uint32_t hash) override;
+    void parallel_for(sycl::range<3> const& range,
+                      runtime::kernel_handle const& kernel) override;
 
-    void parallel_for(sycl::nd_range<3> const& ndr, char const* name, uint32_t hash) override;
+    void parallel_for(sycl::nd_range<3> const& ndr,
+                      runtime::kernel_handle const& kernel) override;
 
     void set_desc(void const* desc) override;
 
     runtime::event_ptr finalize() override;
 
-    void reserve_binds(size_t n) override;
+    void reserve_binds(size_t n, size_t param_byte) override;
 
     void begin_binds() override;
 
@@ -177,6 +233,10 @@ struct handler_impl final : runtime::handler, std::enable_shared_from_this<handl
 
     void fill_zero(accessor_ptr const& src, size_t len_byte) override;
 
+    void memcpy(void* dest, void const* src, size_t len_byte) override;
+
+    void fill(void* dest, void const* pattern, size_t pattern_byte, size_t count) override;
+
     void lock() {
         begin_binds();
     }
@@ -192,6 +252,8 @@ private:
         size_t idx = 0;
         buffer* buff = nullptr;
         access_mode mode = static_cast<access_mode>(0);
+        id<3> lo;
+        id<3> hi;
 
         inline bool operator<(access_pair const& rhs) const {
             return *this < std::make_pair(rhs.idx, rhs.buff);
@@ -204,11 +266,50 @@ private:
     };
 
     queue_impl& q_;
+    // The graph that records this command group, if any.
+    command_graph_impl* graph_;
+    std::unique_lock<std::recursive_mutex> order_;
     std::shared_ptr<dep::task> task_;
     std::vector<access_pair> pairs_;
+    size_t param_byte_ = 0;
     size_t lmem_;
 };
 
+// If `task` records a command group for a command_graph, records that the command group
+// depends on `ev` and returns true.
+bool record_dependency(dep::task& task, runtime::event_ptr const& ev);
+
+struct command_graph_impl final : runtime::command_graph {
+    // A recorded command group.
+    struct node;
+
+    explicit command_graph_impl(intrusive_ptr<queue_impl> const& q);
+
+    ~command_graph_impl();
+
+    void begin_recording() override;
+
+    void end_recording() override;
+
+    size_t size() const override;
+
+    void set_arg(size_t n, size_t idx, void const* ptr, size_t size) override;
+
+    runtime::event_ptr replay() override;
+
+    // Returns a task that records the calls of a handler into a new node.
+    std::shared_ptr<dep::task> new_task();
+
+    void add(std::unique_ptr<node>&& n);
+
+private:
+    intrusive_ptr<queue_impl> q_;
+    std::vector<std::unique_ptr<node>> nodes_;
+    // The tasks of the replays, whose analysis is reused by later replays.
+    std::unique_ptr<dep::task_graph> plan_;
+    bool recording_ = false;
+};
+
 struct accessor_impl final : runtime::accessor {
     explicit accessor_impl(intrusive_ptr<handler_impl> const& handler,
                            intrusive_ptr<buffer_impl> const& buf, range<3> range, id<3> offset,
@@ -28,6 +28,8 @@ using dep::id;
 using dep::memory_access;
 using dep::nd_range;
 using dep::range;
+using dep::region;
+using dep::region_list;
 
 using memory_handle = uintptr_t;
 using dom_id = uint_fast32_t;
@@ -57,6 +59,25 @@ struct subsystem {
 
     virtual memory_domain& get_host_memory_domain() = 0;
 
+    // Whether a submitted task without any operation completes after its dependencies without
+    // blocking. Such tasks are used to join large sets of dependencies.
+    virtual bool has_join_task() const {
+        return false;
+    }
+
+    // Unified shared memory. Returns nullptr if the subsystem does not support `kind`.
+    virtual void* usm_alloc(usm::alloc kind, size_t byte) {
+        (void)kind;
+        (void)byte;
+        return nullptr;
+    }
+
+    // Returns false if `ptr` was not allocated by usm_alloc.
+    virtual bool usm_free(void* ptr) {
+        (void)ptr;
+        return false;
+    }
+
     virtual void shutdown() = 0;
 };
 
@@ -94,6 +115,12 @@ struct memory_domain {
         return id() == 0;
     }
 
+    // True if the domain works on the host memory itself. Such a domain is always coherent with
+    // the host, so no data is ever transferred between the two.
+    virtual bool aliases_host() const {
+        return is_host();
+    }
+
     virtual dom_id id() const = 0;
 };
 
@@ -121,6 +148,12 @@ struct task {
     virtual void depends_on(event const& task) = 0;
     virtual void depends_on(std::shared_ptr<task> const& task) = 0;
 
+    // Whether this task has been submitted and finished. May be called from any thread; a
+    // conservative implementation always returns false.
+    virtual bool is_complete() const {
+        return false;
+    }
+
     // 1.a. Select Device
     virtual void use_device() = 0;
     virtual void set_device(device& dev) = 0;
@@ -129,7 +162,7 @@ struct task {
     virtual void use_host() = 0;
 
     // 2.a. Select Device Kernel
-    virtual void set_kernel(char const* name, uint32_t hash) = 0;
+    virtual void set_kernel(runtime::kernel_handle const& kernel) = 0;
 
     // 2.b. Set Host Functor
     virtual void set_host(std::function<void()> const& f) = 0;
@@ -169,6 +202,24 @@ struct task {
 
     virtual void fill(buffer& dst, size_t byte_len) = 0;
 
+    // 2.c' Memory Operations on USM pointers
+    virtual void copy_usm(void const* src, void* dst, size_t len_byte) {
+        (void)src;
+        (void)dst;
+        (void)len_byte;
+        throw_error(errc::feature_not_supported, "the backend does not support USM copies");
+    }
+
+    // Writes `count` copies of the `pattern_byte` bytes at `pattern` to `dst`. The pattern is
+    // copied before this function returns.
+    virtual void fill_usm(void* dst, void const* pattern, size_t pattern_byte, size_t count) {
+        (void)dst;
+        (void)pattern;
+        (void)pattern_byte;
+        (void)count;
+        throw_error(errc::feature_not_supported, "the backend does not support USM fills");
+    }
+
     // 2.d set function descriptor
     virtual void set_desc(func_desc const* desc) {
         (void)desc;
@@ -184,10 +235,22 @@ struct task {
     virtual void set_local_mem_size(size_t byte) = 0;
 
     // 4. Set Parameters
+    // `n_params` parameters of `byte` bytes in total follow. Only a hint for the storage.
+    virtual void reserve_params(size_t n_params, size_t byte) {
+        (void)n_params;
+        (void)byte;
+    }
+
     virtual void set_param(void const* ptr, size_t size) = 0;
+    // The byte ranges in `xfer` are stale in the task's memory domain and have to be copied
+    // from `dom` before the task runs.
     virtual void set_buffer_param(buffer& buf, void* h_ptr, memory_domain const& dom,
-                                  memory_access acc, rts::id const& offset,
-                                  size_t offset_byte) = 0;
+                                  memory_access acc, rts::id const& offset, size_t offset_byte,
+                                  region_list const& xfer) = 0;
+    // Copies the byte ranges in `xfer`, which are stale in the task's memory domain, from `src`
+    // before the task runs. set_buffer_param() does the same for the ranges of its domain.
+    virtual void transfer(buffer& buf, void* h_ptr, memory_domain const& src,
+                          region_list const& xfer) = 0;
 
     // 5. Submit this task
     virtual std::unique_ptr<event> submit() = 0;
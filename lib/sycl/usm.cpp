@@ -0,0 +1,29 @@
+#include <charm/sycl.hpp>
+#include "rt.hpp"
+
+CHARM_SYCL_BEGIN_NAMESPACE
+
+namespace runtime {
+
+void* usm_alloc(queue_ptr const&, usm::alloc kind, size_t byte) {
+    if (byte == 0) {
+        return nullptr;
+    }
+
+    // All devices of a process share one subsystem, so the queue only selects the runtime.
+    return impl::global_state::get_depmgr()->usm_alloc(kind, byte);
+}
+
+void usm_free(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+
+    if (!impl::global_state::get_depmgr()->usm_free(ptr)) {
+        throw_error(errc::invalid, "the pointer was not allocated by sycl::malloc");
+    }
+}
+
+}  // namespace runtime
+
+CHARM_SYCL_END_NAMESPACE
@@ -852,6 +852,13 @@ struct decompiler : xcml::visitor<decompiler, void> {
     }
 
     void visit_compound_stmt(xcml::compound_stmt_ptr node, symbol_scope const* scope) {
+        if (node->pragma.size()) {
+            PRINT("\n");
+            for (auto const& pragma : node->pragma) {
+                FORMAT("#pragma {}\n", pragma->value);
+            }
+        }
+
         PRINT("{");
 
         symbol_scope new_scope(scope, node->symbols);
@@ -1137,6 +1144,17 @@ private:
 
 }  // namespace
 
+void cback_program(xcml::xcml_program_node_ptr const& prg, utils::target target,
+                   std::ostream& os) {
+    ::options opt;
+    opt.target = target;
+
+    decompiler dec(opt);
+    dec(prg);
+
+    os << dec.output();
+}
+
 #ifdef IMPLEMENT_MAIN
 int main(int argc, char** argv)
 #else
@@ -1165,20 +1183,14 @@ int cback_main(int argc, char** argv)
     auto doc = xcml::read_xml(input);
     auto prg = xcml::xml_to_prg(doc);
 
-    ::options opt;
-    opt.target = target;
-
-    decompiler dec(opt);
-    dec(prg);
-
     if (output == "-") {
-        std::cout << dec.output();
+        cback_program(prg, target, std::cout);
     } else {
         std::ofstream ofs;
         ofs.exceptions(ofs.failbit | ofs.badbit);
         ofs.open(output);
 
-        ofs << dec.output();
+        cback_program(prg, target, ofs);
     }
 
     return 0;
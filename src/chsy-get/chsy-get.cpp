@@ -2,6 +2,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <iterator>
+#include <string>
 #include <system_error>
 #include <vector>
 #include <cxxopts.hpp>
@@ -57,17 +58,14 @@ struct get_kernels_visitor final : xcml::recursive_visitor<get_kernels_visitor>
     }
 };
 
-void get_kernels(xcml::xcml_program_node_ptr prg) {
+}  // namespace
+
+std::vector<std::string> get_kernel_names(xcml::xcml_program_node_ptr const& prg) {
     get_kernels_visitor vis;
     vis.apply(prg);
-
-    for (auto const& name : vis.res) {
-        fmt::format_to(out, "{}\n", name);
-    }
+    return std::move(vis.res);
 }
 
-}  // namespace
-
 #ifdef IMPLEMENT_MAIN
 int main(int argc, char** argv)
 #else
@@ -91,7 +89,9 @@ int get_main(int argc, char** argv)
         auto prg = xcml::xml_to_prg(xcml::read_xml(input));
 
         if (mode_kernels) {
-            get_kernels(prg);
+            for (auto const& name : get_kernel_names(prg)) {
+                fmt::format_to(out, "{}\n", name);
+            }
         } else {
             fmt::print(stderr, "{}: No mode options are given.\n", argv[0]);
             return 1;
@@ -1,14 +1,29 @@
 #include "chsy-lower.hpp"
+#include <stdexcept>
 #include <cxxopts.hpp>
 #include <utils/target.hpp>
 #include <xcml.hpp>
 
-template <class F>
-int run_transformation(std::string const& output, F const& fn,
-                       xcml::xcml_program_node_ptr prg) {
-    prg = fn(prg);
-    xcml::write_xml(output, xcml::prg_to_xml(prg));
-    return 0;
+xcml::xcml_program_node_ptr lower_program(xcml::xcml_program_node_ptr prg,
+                                          utils::target target) {
+    switch (target) {
+        case utils::target::NONE:
+            break;
+
+        case utils::target::CPU_C:
+            return lower_cpu_c(prg);
+
+        case utils::target::CPU_OPENMP:
+            return lower_cpu_openmp(prg);
+
+        case utils::target::NVIDIA_CUDA:
+            return lower_nvidia_cuda(prg);
+
+        case utils::target::AMD_HIP:
+            return lower_amd_hip(prg);
+    }
+
+    throw std::invalid_argument(fmt::format("Unknown target: {}", utils::show(target)));
 }
 
 #ifdef IMPLEMENT_MAIN
@@ -31,25 +46,12 @@ int lower_main(int argc, char** argv)
     auto const& target_str = opts["target"].as<std::string>();
 
     auto const target = utils::from_string(target_str);
-    auto prg = xcml::xml_to_prg(xcml::read_xml(input));
-
-    switch (target) {
-        case utils::target::NONE:
-            fmt::print(stderr, "{}: Unknown target: {}\n", argv[0], target_str);
-            return 1;
-
-        case utils::target::CPU_C:
-            return run_transformation(output, lower_cpu_c, prg);
-
-        case utils::target::CPU_OPENMP:
-            return run_transformation(output, lower_cpu_openmp, prg);
-
-        case utils::target::NVIDIA_CUDA:
-            return run_transformation(output, lower_nvidia_cuda, prg);
-
-        case utils::target::AMD_HIP:
-            return run_transformation(output, lower_amd_hip, prg);
+    if (target == utils::target::NONE) {
+        fmt::print(stderr, "{}: Unknown target: {}\n", argv[0], target_str);
+        return 1;
     }
 
-    std::terminate();
+    auto prg = xcml::xml_to_prg(xcml::read_xml(input));
+    xcml::write_xml(output, xcml::prg_to_xml(lower_program(prg, target)));
+    return 0;
 }
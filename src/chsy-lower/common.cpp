@@ -154,10 +154,12 @@ struct optimize_compounds_visitor final : xcml::recursive_visitor<optimize_compo
             std::list<xcml::stmt_ptr> new_body;
 
             for (auto const& stmt : compound->body) {
+                // A block with a pragma, such as a parallel region, is kept as it is.
                 auto const child = xcml::compound_stmt::dyncast(stmt);
-                auto const collapse = child && stmt == compound->body.front();
+                auto const plain = child && child->pragma.empty();
+                auto const collapse = plain && stmt == compound->body.front();
                 auto const expand =
-                    child && child->declarations.empty() && child->symbols.empty();
+                    plain && child->declarations.empty() && child->symbols.empty();
 
                 if (collapse) {
                     append(compound->declarations, child->declarations);
@@ -1,4 +1,5 @@
 #include <queue>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
 #include <utils/hash.hpp>
@@ -6,6 +7,7 @@
 #include <xcml.hpp>
 #include <xcml_recusive_visitor.hpp>
 #include "chsy-lower.hpp"
+#include "group.hpp"
 #include "math.hpp"
 
 namespace {
@@ -15,9 +17,355 @@ namespace u = xcml::utils;
 using funcset_t = std::unordered_set<std::string>;
 using callmap_t = std::unordered_multimap<std::string, std::string>;
 
+// The parameter through which kernels and the functions they call receive the work-item
+// context from the runtime (see lib/sycl/fiber.hpp).
+constexpr char const* CONTEXT_PARAM = "__charm_sycl_ctx";
+
+bool is_context_builtin(std::string_view name) {
+    static constexpr std::string_view PREFIXES[] = {
+        "__charm_sycl_group_range", "__charm_sycl_group_id", "__charm_sycl_local_range",
+        "__charm_sycl_local_id"};
+
+    if (name == "__charm_sycl_local_memory_base") {
+        return true;
+    }
+
+    for (auto const prefix : PREFIXES) {
+        if (name.size() == prefix.size() + 1 && name.starts_with(prefix) &&
+            (name.back() == '1' || name.back() == '2' || name.back() == '3')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Collects the nd_range kernels that may reach __charm_sycl_group_barrier through a chain of
+ * calls. A call through a function pointer is assumed to reach it. Group algorithms contain a
+ * barrier.
+ */
+struct collect_barrier_kernels final : xcml::recursive_visitor<collect_barrier_kernels> {
+    explicit collect_barrier_kernels(funcset_t& kernels) : kernels_(kernels) {}
+
+    xcml::node_ptr visit_xcml_program_node(xcml::xcml_program_node_ptr const& node,
+                                           scope_ref scope) {
+        auto res = recursive_visitor::visit_xcml_program_node(node, scope);
+
+        funcset_t reached;
+        std::queue<std::string> queue;
+
+        reached.insert(BARRIER);
+        reached.insert(INDIRECT);
+        queue.push(BARRIER);
+        queue.push(INDIRECT);
+
+        while (!queue.empty()) {
+            auto const callee = std::move(queue.front());
+            queue.pop();
+
+            auto const [first, last] = callers_.equal_range(callee);
+            for (auto it = first; it != last; ++it) {
+                if (reached.insert(it->second).second) {
+                    queue.push(it->second);
+                }
+            }
+        }
+
+        for (auto const& name : ndr_kernels_) {
+            if (reached.count(name)) {
+                kernels_.insert(name);
+            }
+        }
+
+        return res;
+    }
+
+    xcml::node_ptr visit_function_definition(xcml::function_definition_ptr const& node,
+                                             scope_ref scope) {
+        current_ = node->name;
+        return recursive_visitor::visit_function_definition(node, scope);
+    }
+
+    xcml::node_ptr visit_kernel_wrapper_decl(xcml::kernel_wrapper_decl_ptr const& node,
+                                             scope_ref scope) {
+        current_ = node->name;
+        if (node->is_ndr) {
+            ndr_kernels_.push_back(node->name);
+        }
+        return recursive_visitor::visit_kernel_wrapper_decl(node, scope);
+    }
+
+    xcml::node_ptr visit_function_call(xcml::function_call_ptr const& node, scope_ref scope) {
+        if (!xcml::func_addr::is_a(node->function)) {
+            callers_.emplace(INDIRECT, current_);
+        }
+        return recursive_visitor::visit_function_call(node, scope);
+    }
+
+    xcml::node_ptr visit_func_addr(xcml::func_addr_ptr const& node, scope_ref) {
+        callers_.emplace(is_group_algorithm(node->name) ? BARRIER : node->name, current_);
+        return node;
+    }
+
+private:
+    static constexpr char const* BARRIER = "__charm_sycl_group_barrier";
+    static constexpr char const* INDIRECT = "";
+
+    funcset_t& kernels_;
+    callmap_t callers_;
+    std::vector<std::string> ndr_kernels_;
+    std::string current_;
+};
+
+/*
+ * Collects the kernels that call __charm_sycl_is_reduce_leader_N, i.e. the kernels with
+ * reductions. Their work-sharing loops are changed to orphaned `omp for` loops: the whole
+ * kernel body runs in a parallel region so that every thread accumulates into private copies
+ * of the reducers (see transform_kernel_wrapper).
+ */
+struct collect_reduction_kernels final : xcml::recursive_visitor<collect_reduction_kernels> {
+    explicit collect_reduction_kernels(funcset_t& kernels) : kernels_(kernels) {}
+
+    xcml::node_ptr visit_kernel_wrapper_decl(xcml::kernel_wrapper_decl_ptr const& node,
+                                             scope_ref scope) {
+        found_ = false;
+        loops_.clear();
+
+        auto res = recursive_visitor::visit_kernel_wrapper_decl(node, scope);
+
+        if (found_) {
+            kernels_.insert(node->name);
+
+            for (auto const& loop : loops_) {
+                for (auto& pragma : loop->pragma) {
+                    std::string_view const value = pragma->value;
+
+                    if (value.starts_with(PARALLEL_FOR)) {
+                        pragma->value = fmt::format("omp for schedule(static){}",
+                                                    value.substr(PARALLEL_FOR.size()));
+                    }
+                }
+            }
+        }
+
+        return res;
+    }
+
+    xcml::node_ptr visit_for_stmt(xcml::for_stmt_ptr const& node, scope_ref scope) {
+        if (!node->pragma.empty()) {
+            loops_.push_back(node);
+        }
+        return recursive_visitor::visit_for_stmt(node, scope);
+    }
+
+    xcml::node_ptr visit_func_addr(xcml::func_addr_ptr const& node, scope_ref) {
+        if (std::string_view(node->name).starts_with(LEADER)) {
+            found_ = true;
+        }
+        return node;
+    }
+
+private:
+    static constexpr std::string_view LEADER = "__charm_sycl_is_reduce_leader_";
+    static constexpr std::string_view PARALLEL_FOR = "omp parallel for";
+
+    funcset_t& kernels_;
+    std::vector<xcml::for_stmt_ptr> loops_;
+    bool found_ = false;
+};
+
+/*
+ * Marks the innermost loop of the range kernels with `omp simd`. The work-items of a range
+ * kernel are independent, so the C compiler may vectorize the loop without checking whether
+ * the accessors alias. The loops of the reduction kernels accumulate into the reducers and
+ * are left as they are.
+ */
+struct vectorize_range_kernels final : xcml::recursive_visitor<vectorize_range_kernels> {
+    explicit vectorize_range_kernels(funcset_t const& reduction_kernels)
+        : reduction_kernels_(reduction_kernels) {}
+
+    xcml::node_ptr visit_kernel_wrapper_decl(xcml::kernel_wrapper_decl_ptr const& node,
+                                             scope_ref scope) {
+        if (node->is_ndr || reduction_kernels_.count(node->name)) {
+            return node;
+        }
+        return recursive_visitor::visit_kernel_wrapper_decl(node, scope);
+    }
+
+    xcml::node_ptr visit_for_stmt(xcml::for_stmt_ptr const& node, scope_ref scope) {
+        if (is_innermost(node)) {
+            node->pragma.push_back(u::make_pragma("omp simd"));
+        }
+        return recursive_visitor::visit_for_stmt(node, scope);
+    }
+
+private:
+    // The innermost loop steps with __charm_sycl_parallel_iter3_step (see handler.ipp).
+    static bool is_innermost(xcml::for_stmt_ptr const& node) {
+        auto const asg = xcml::assign_expr::dyncast(node->iter);
+        if (!asg) {
+            return false;
+        }
+
+        auto const call = xcml::function_call::dyncast(asg->rhs);
+        if (!call) {
+            return false;
+        }
+
+        auto const fa = xcml::func_addr::dyncast(call->function);
+        return fa && fa->name == STEP;
+    }
+
+    static constexpr std::string_view STEP = "__charm_sycl_parallel_iter3_step";
+
+    funcset_t const& reduction_kernels_;
+};
+
+/*
+ * Collects the functions that read the work-item context through a chain of calls. The
+ * context reaches them through an extra parameter (see pass_context), so a function whose
+ * address is taken cannot be one of them. In that case nothing is collected, `direct` is set
+ * to false and the builtins fall back to the fiber runtime.
+ */
+struct collect_context_users final : xcml::recursive_visitor<collect_context_users> {
+    explicit collect_context_users(funcset_t& funcs, bool& direct)
+        : funcs_(funcs), direct_(direct) {}
+
+    xcml::node_ptr visit_xcml_program_node(xcml::xcml_program_node_ptr const& node,
+                                           scope_ref scope) {
+        auto res = recursive_visitor::visit_xcml_program_node(node, scope);
+
+        funcset_t reached;
+        std::queue<std::string> queue;
+
+        reached.insert(CONTEXT);
+        queue.push(CONTEXT);
+
+        while (!queue.empty()) {
+            auto const callee = std::move(queue.front());
+            queue.pop();
+
+            auto const [first, last] = callers_.equal_range(callee);
+            for (auto it = first; it != last; ++it) {
+                if (reached.insert(it->second).second) {
+                    queue.push(it->second);
+                }
+            }
+        }
+
+        direct_ = true;
+        for (auto const& name : reached) {
+            if (defined_.count(name)) {
+                funcs_.insert(name);
+                direct_ = direct_ && refs_[name] == calls_[name];
+            }
+        }
+
+        if (!direct_) {
+            funcs_.clear();
+        }
+
+        return res;
+    }
+
+    xcml::node_ptr visit_function_definition(xcml::function_definition_ptr const& node,
+                                             scope_ref scope) {
+        current_ = node->name;
+        defined_.insert(node->name);
+        return recursive_visitor::visit_function_definition(node, scope);
+    }
+
+    xcml::node_ptr visit_kernel_wrapper_decl(xcml::kernel_wrapper_decl_ptr const& node,
+                                             scope_ref scope) {
+        current_ = node->name;
+        return recursive_visitor::visit_kernel_wrapper_decl(node, scope);
+    }
+
+    xcml::node_ptr visit_function_call(xcml::function_call_ptr const& node, scope_ref scope) {
+        if (auto const fa = xcml::func_addr::dyncast(node->function)) {
+            callers_.emplace(is_context_builtin(fa->name) ? CONTEXT : fa->name, current_);
+            calls_[fa->name]++;
+        }
+        return recursive_visitor::visit_function_call(node, scope);
+    }
+
+    xcml::node_ptr visit_func_addr(xcml::func_addr_ptr const& node, scope_ref) {
+        refs_[node->name]++;
+        return node;
+    }
+
+private:
+    static constexpr char const* CONTEXT = "";
+
+    funcset_t& funcs_;
+    bool& direct_;
+    funcset_t defined_;
+    callmap_t callers_;
+    std::unordered_map<std::string, size_t> calls_;
+    std::unordered_map<std::string, size_t> refs_;
+    std::string current_;
+};
+
+// Adds the context parameter to the functions collected by collect_context_users and passes
+// it at every call of them.
+struct pass_context final : xcml::recursive_visitor<pass_context> {
+    explicit pass_context(funcset_t const& funcs) : funcs_(funcs) {}
+
+    xcml::node_ptr visit_function_definition(xcml::function_definition_ptr const& node,
+                                             scope_ref scope) {
+        if (funcs_.count(node->name)) {
+            add_context_param(node);
+        }
+        return recursive_visitor::visit_function_definition(node, scope);
+    }
+
+    xcml::node_ptr visit_function_call(xcml::function_call_ptr const& node, scope_ref scope) {
+        if (auto const fa = xcml::func_addr::dyncast(node->function);
+            fa && funcs_.count(fa->name)) {
+            node->arguments.push_back(u::make_var_ref(CONTEXT_PARAM));
+        }
+        return recursive_visitor::visit_function_call(node, scope);
+    }
+
+private:
+    // The function type may be shared with other functions, so a copy is extended.
+    void add_context_param(xcml::function_definition_ptr const& fd) {
+        auto const void_ptr = get_pointer_type(get_basic_type("void"));
+
+        for (auto const& sym : root()->global_symbols) {
+            if (sym->name != fd->name) {
+                continue;
+            }
+
+            auto const old_ft = xcml::function_type::dyncast(type_map_.at(sym->type));
+            if (!old_ft) {
+                continue;
+            }
+
+            auto ft = create_function_type();
+            ft->return_type = old_ft->return_type;
+            ft->params = old_ft->params;
+            ft->cuda_attrs = old_ft->cuda_attrs;
+            u::add_param(ft, void_ptr, CONTEXT_PARAM);
+
+            sym->type = ft->type;
+            fd->params = ft->params;
+        }
+
+        auto const sym = xcml::new_symbol_id();
+        sym->name = CONTEXT_PARAM;
+        sym->sclass = xcml::storage_class::param;
+        sym->type = void_ptr->type;
+        fd->symbols.push_back(sym);
+    }
+
+    funcset_t const& funcs_;
+};
+
 struct add_function_loader_visitor final
     : xcml::recursive_visitor<add_function_loader_visitor> {
-    explicit add_function_loader_visitor(utils::target t) : target_(t) {}
+    explicit add_function_loader_visitor(utils::target t, funcset_t const& barrier_kernels)
+        : target_(t), barrier_kernels_(barrier_kernels) {}
 
     xcml::node_ptr visit_kernel_wrapper_decl(xcml::kernel_wrapper_decl_ptr const& node,
                                              scope_ref) {
@@ -47,7 +395,7 @@ struct add_function_loader_visitor final
         call->arguments.push_back(lit(target_str));
         call->arguments.push_back(lit(utils::fnv1a(target_str)));
         call->arguments.push_back(make_cast(void_ptr, make_func_addr(node->name)));
-        call->arguments.push_back(lit(node->is_ndr));
+        call->arguments.push_back(lit(kernel_kind(node)));
 
         push_expr(fd->body, call);
 
@@ -55,6 +403,14 @@ struct add_function_loader_visitor final
     }
 
 private:
+    // 0: range kernel, 1: nd_range kernel, 2: nd_range kernel without group barriers.
+    int kernel_kind(xcml::kernel_wrapper_decl_ptr const& node) const {
+        if (!node->is_ndr) {
+            return 0;
+        }
+        return barrier_kernels_.count(node->name) ? 1 : 2;
+    }
+
     xcml::func_addr_ptr const& get_registry_fn() {
         using namespace xcml::utils;
 
@@ -83,10 +439,14 @@ private:
     }
 
     utils::target target_;
+    funcset_t const& barrier_kernels_;
     xcml::func_addr_ptr registry_fn_;
 };
 
 struct transform_kernel_wrapper final : xcml::recursive_visitor<transform_kernel_wrapper> {
+    explicit transform_kernel_wrapper(funcset_t const& reduction_kernels)
+        : reduction_kernels_(reduction_kernels) {}
+
     xcml::node_ptr visit_kernel_wrapper_decl(xcml::kernel_wrapper_decl_ptr const& node,
                                              scope_ref) {
         using namespace xcml::utils;
@@ -94,6 +454,7 @@ struct transform_kernel_wrapper final : xcml::recursive_visitor<transform_kernel
         auto ft = create_function_type();
         ft->return_type = "void";
         auto const args = add_param(ft, get_void_ptr_ptr(), gen_var("args"));
+        add_param(ft, get_void_ptr(), CONTEXT_PARAM);
 
         fdecl_opts opts;
         opts.is_static = true;
@@ -134,10 +495,29 @@ struct transform_kernel_wrapper final : xcml::recursive_visitor<transform_kernel
 
         fd->body->body.push_back(node->body);
 
+        if (reduction_kernels_.count(node->name)) {
+            privatize(fd);
+        }
+
         return fd;
     }
 
 private:
+    /*
+     * Moves the body into a `#pragma omp parallel` block. The local variables of the block are
+     * the private copies of the arguments, including the reducers, of each thread, and every
+     * thread combines its partial results atomically at the end (see CPU_REDUCE_UTILS).
+     */
+    static void privatize(xcml::function_definition_ptr const& fd) {
+        auto region = xcml::new_compound_stmt();
+        std::swap(region->symbols, fd->body->symbols);
+        std::swap(region->declarations, fd->body->declarations);
+        std::swap(region->body, fd->body->body);
+        region->pragma.push_back(u::make_pragma("omp parallel"));
+
+        u::push_stmt(fd->body, region);
+    }
+
     xcml::type_ptr get_void_ptr() {
         if (auto t = find_pointer_type(get_basic_type("void"))) {
             return t;
@@ -152,9 +532,11 @@ private:
         }
         return create_pointer_type(get_void_ptr());
     }
+
+    funcset_t const& reduction_kernels_;
 };
 
-void add_common_replacements(replace_builtin_map_t& replace) {
+void add_common_replacements(replace_builtin_map_t& replace, bool direct_context) {
     replace["__charm_sycl_kernel"] = [=](xcml::function_call_ptr const&) -> xcml::expr_ptr {
         return nullptr;
     };
@@ -176,36 +558,153 @@ void add_common_replacements(replace_builtin_map_t& replace) {
         };
     }
 
-    for (int dim = 0; dim < 3; ++dim) {
-        replace[fmt::format("__charm_sycl_group_range{}", dim + 1)] =
-            [=](xcml::function_call_ptr const&) -> xcml::expr_ptr {
-            return u::make_call(
-                u::make_func_addr(fmt::format("__charm_sycl_fiber_group_range{}", dim + 1)),
-                {});
-        };
+    // Reads the context passed to the kernel if every function that needs it receives it.
+    for (std::string_view name : {"group_range", "group_id", "local_range", "local_id"}) {
+        for (int dim = 1; dim <= 3; ++dim) {
+            replace[fmt::format("__charm_sycl_{}{}", name, dim)] =
+                [=](xcml::function_call_ptr const&) -> xcml::expr_ptr {
+                if (direct_context) {
+                    return u::make_call(
+                        u::make_func_addr(fmt::format("__charm_sycl_cpu_{}{}", name, dim)),
+                        {u::make_var_ref(CONTEXT_PARAM)});
+                }
+                return u::make_call(
+                    u::make_func_addr(fmt::format("__charm_sycl_fiber_{}{}", name, dim)), {});
+            };
+        }
+    }
 
-        replace[fmt::format("__charm_sycl_group_id{}", dim + 1)] =
-            [=](xcml::function_call_ptr const&) -> xcml::expr_ptr {
-            return u::make_call(
-                u::make_func_addr(fmt::format("__charm_sycl_fiber_group_id{}", dim + 1)), {});
-        };
+    replace["__charm_sycl_local_memory_base"] = [=](xcml::function_call_ptr const&) {
+        if (direct_context) {
+            return u::make_call(u::make_func_addr("__charm_sycl_cpu_local_memory"),
+                                {u::make_var_ref(CONTEXT_PARAM)});
+        }
+        return u::make_call(u::make_func_addr("__charm_sycl_fiber_memory"), {});
+    };
+}
 
-        replace[fmt::format("__charm_sycl_local_range{}", dim + 1)] =
-            [=](xcml::function_call_ptr const&) -> xcml::expr_ptr {
-            return u::make_call(
-                u::make_func_addr(fmt::format("__charm_sycl_fiber_local_range{}", dim + 1)),
-                {});
-        };
+char const* CPU_REDUCE_UTILS = R"(
+#include <stdlib.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* Returns true if the partial results must be combined in the order of the threads. */
+static inline __attribute__((unused)) int __charm_sycl_cpu_reduce_ordered(void) {
+#ifdef _OPENMP
+    static int mode = -1;
+    int m = __atomic_load_n(&mode, __ATOMIC_RELAXED);
+
+    if (m < 0) {
+        char const* env = getenv("CHARM_SYCL_DETERMINISTIC_REDUCTION");
+        m = env != NULL && env[0] == '1';
+        __atomic_store_n(&mode, m, __ATOMIC_RELAXED);
+    }
 
-        replace[fmt::format("__charm_sycl_local_id{}", dim + 1)] =
-            [=](xcml::function_call_ptr const&) -> xcml::expr_ptr {
-            return u::make_call(
-                u::make_func_addr(fmt::format("__charm_sycl_fiber_local_id{}", dim + 1)), {});
-        };
+    return m && omp_in_parallel();
+#else
+    return 0;
+#endif
+}
+
+#ifdef _OPENMP
+#define __CHARM_SYCL_CPU_REDUCE_ORDERED(stmt)              \
+    if (__charm_sycl_cpu_reduce_ordered()) {               \
+        int n_ = omp_get_num_threads();                    \
+        _Pragma("omp for ordered schedule(static, 1)")     \
+        for (int i_ = 0; i_ < n_; i_++) {                  \
+            _Pragma("omp ordered")                         \
+            { stmt; }                                      \
+        }                                                  \
+        return;                                            \
+    }
+#else
+#define __CHARM_SYCL_CPU_REDUCE_ORDERED(stmt)
+#endif
+
+#define __CHARM_SYCL_CPU_PLUS(a, b) ((a) + (b))
+#define __CHARM_SYCL_CPU_MIN(a, b) ((b) < (a) ? (b) : (a))
+#define __CHARM_SYCL_CPU_MAX(a, b) ((a) < (b) ? (b) : (a))
+
+#define __CHARM_SYCL_CPU_REDUCE_CAS(op, t, T, f)                                             \
+    static inline __attribute__((unused)) void __charm_sycl_cpu_reduce_##op##_##t(T* g, T v) { \
+        __CHARM_SYCL_CPU_REDUCE_ORDERED(*g = f(*g, v))                                       \
+        T old_, new_;                                                                        \
+        __atomic_load(g, &old_, __ATOMIC_RELAXED);                                           \
+        do {                                                                                 \
+            new_ = f(old_, v);                                                               \
+            if (new_ == old_) {                                                              \
+                return;                                                                      \
+            }                                                                                \
+        } while (!__atomic_compare_exchange(g, &old_, &new_, 0, __ATOMIC_RELAXED,            \
+                                            __ATOMIC_RELAXED));                              \
+    }
+
+#define __CHARM_SYCL_CPU_REDUCE_FETCH(op, t, T, fetch, o)                                    \
+    static inline __attribute__((unused)) void __charm_sycl_cpu_reduce_##op##_##t(T* g, T v) { \
+        __CHARM_SYCL_CPU_REDUCE_ORDERED(*g = *g o v)                                         \
+        fetch(g, v, __ATOMIC_RELAXED);                                                       \
     }
+
+#define __CHARM_SYCL_CPU_REDUCE_FLOAT(t, T)                            \
+    __CHARM_SYCL_CPU_REDUCE_CAS(plus, t, T, __CHARM_SYCL_CPU_PLUS)     \
+    __CHARM_SYCL_CPU_REDUCE_CAS(minimum, t, T, __CHARM_SYCL_CPU_MIN)   \
+    __CHARM_SYCL_CPU_REDUCE_CAS(maximum, t, T, __CHARM_SYCL_CPU_MAX)
+
+#define __CHARM_SYCL_CPU_REDUCE_INT(t, T)                                   \
+    __CHARM_SYCL_CPU_REDUCE_FETCH(plus, t, T, __atomic_fetch_add, +)        \
+    __CHARM_SYCL_CPU_REDUCE_CAS(minimum, t, T, __CHARM_SYCL_CPU_MIN)        \
+    __CHARM_SYCL_CPU_REDUCE_CAS(maximum, t, T, __CHARM_SYCL_CPU_MAX)        \
+    __CHARM_SYCL_CPU_REDUCE_FETCH(bit_and, t, T, __atomic_fetch_and, &)     \
+    __CHARM_SYCL_CPU_REDUCE_FETCH(bit_or, t, T, __atomic_fetch_or, |)       \
+    __CHARM_SYCL_CPU_REDUCE_FETCH(bit_xor, t, T, __atomic_fetch_xor, ^)
+
+__CHARM_SYCL_CPU_REDUCE_FLOAT(f, float)
+__CHARM_SYCL_CPU_REDUCE_FLOAT(d, double)
+__CHARM_SYCL_CPU_REDUCE_INT(i, int)
+__CHARM_SYCL_CPU_REDUCE_INT(j, unsigned int)
+__CHARM_SYCL_CPU_REDUCE_INT(l, long)
+__CHARM_SYCL_CPU_REDUCE_INT(m, unsigned long)
+__CHARM_SYCL_CPU_REDUCE_INT(x, long long)
+__CHARM_SYCL_CPU_REDUCE_INT(y, unsigned long long)
+)";
+
+char const* CPU_CONTEXT_UTILS = R"(
+/* The work-item context passed by the runtime. See fiber_context in lib/sycl/fiber.hpp. */
+struct __charm_sycl_cpu_context {
+    unsigned long local_id[3];
+    unsigned long group_id[3];
+    unsigned long local_range[3];
+    unsigned long group_range[3];
+    void* local_memory;
+};
+
+#define __CHARM_SYCL_CPU_CONTEXT_GET(name, dim)                                               \
+    static inline __attribute__((unused)) unsigned long __charm_sycl_cpu_##name##dim(void* c) { \
+        return ((struct __charm_sycl_cpu_context const*)c)->name[dim - 1];                    \
+    }
+
+#define __CHARM_SYCL_CPU_CONTEXT_GET_ALL(name) \
+    __CHARM_SYCL_CPU_CONTEXT_GET(name, 1)      \
+    __CHARM_SYCL_CPU_CONTEXT_GET(name, 2)      \
+    __CHARM_SYCL_CPU_CONTEXT_GET(name, 3)
+
+__CHARM_SYCL_CPU_CONTEXT_GET_ALL(local_id)
+__CHARM_SYCL_CPU_CONTEXT_GET_ALL(group_id)
+__CHARM_SYCL_CPU_CONTEXT_GET_ALL(local_range)
+__CHARM_SYCL_CPU_CONTEXT_GET_ALL(group_range)
+
+static inline __attribute__((unused)) void* __charm_sycl_cpu_local_memory(void* c) {
+    return ((struct __charm_sycl_cpu_context const*)c)->local_memory;
 }
+)";
+
+void add_reduction_funcs(xcml::xcml_program_node_ptr const& prg,
+                         implement_builtin_map_t& implement_map) {
+    auto utils = u::new_code();
+    utils->value = CPU_REDUCE_UTILS;
+    prg->preamble.push_back(utils);
 
-void add_reduction_funcs(implement_builtin_map_t& implement_map) {
     for (auto dim : {1, 2, 3}) {
         implement_map[fmt::format("__charm_sycl_is_reduce_leader_{}", dim)] =
             [](xcml::xcml_program_node_ptr const&, xcml::function_decl_ptr const&,
@@ -214,57 +713,37 @@ void add_reduction_funcs(implement_builtin_map_t& implement_map) {
             };
     }
 
-    struct type_pair {
-        char const* t;
-        char const* ty;
-    };
-
-    for (type_pair const& x : (type_pair[]){
-             {"f", "float"},
-             {"d", "double"},
-         }) {
-        auto const init_fn = fmt::format("__charm_sycl_reduce_initialize_{}", x.t);
-        auto const comb_fn = fmt::format("__charm_sycl_reduce_combine_{}", x.t);
-        auto const fini_fn = fmt::format("__charm_sycl_reduce_finalize_{}", x.t);
-
-        implement_map[init_fn] =
-            [](xcml::xcml_program_node_ptr const&, xcml::function_decl_ptr const&,
-               xcml::function_type_ptr const&, xcml::function_definition_ptr const& fd) {
-                auto val = u::make_var_ref(xcml::param_node::dyncast(fd->params.at(0))->name);
-
-                /*
-                 * *val = 0;
-                 */
-                u::push_expr(fd->body, u::assign_expr(u::make_deref(val), u::lit(0)));
-            };
-
-        implement_map[comb_fn] = [](xcml::xcml_program_node_ptr const&,
-                                    xcml::function_decl_ptr const&,
-                                    xcml::function_type_ptr const&,
-                                    xcml::function_definition_ptr const& fd) {
-            auto val = u::make_var_ref(xcml::param_node::dyncast(fd->params.at(0))->name);
-            auto partial = u::make_var_ref(xcml::param_node::dyncast(fd->params.at(1))->name);
-
-            /*
-             * *val += partial;
-             */
-            u::push_expr(fd->body, u::asg_plus_expr(u::make_deref(val), partial));
-        };
+    // Every thread is a leader on the CPU, so the partial result is always combined.
+    for_each_builtin_op([&](std::string_view op, builtin_type const& ty) {
+        auto const fini_fn = fmt::format("__charm_sycl_reduce_finalize_{}_{}", op, ty.sig);
+        auto const impl_fn = fmt::format("__charm_sycl_cpu_reduce_{}_{}", op, ty.sig);
 
         implement_map[fini_fn] =
-            [](xcml::xcml_program_node_ptr const&, xcml::function_decl_ptr const&,
-               xcml::function_type_ptr const&, xcml::function_definition_ptr const& fd) {
+            [=](xcml::xcml_program_node_ptr const&, xcml::function_decl_ptr const&,
+                xcml::function_type_ptr const&, xcml::function_definition_ptr const& fd) {
                 auto g_ptr = u::make_var_ref(xcml::param_node::dyncast(fd->params.at(0))->name);
                 auto val = u::make_var_ref(xcml::param_node::dyncast(fd->params.at(1))->name);
 
                 /*
-                 * __atomic_add_fetch(g_ptr, val, __ATOMIC_SEQ_CST);
+                 * __charm_sycl_cpu_reduce_<op>_<t>(g_ptr, val);
                  */
-                u::push_expr(fd->body,
-                             u::make_call(u::make_func_addr("__atomic_fetch_add"),
-                                          {g_ptr, val, u::make_var_ref("__ATOMIC_SEQ_CST")}));
+                u::push_expr(fd->body, u::make_call(u::make_func_addr(impl_fn), {g_ptr, val}));
             };
-    }
+    });
+}
+
+/*
+ * The group algorithms are implemented by the fiber runtime: the last work-item that reaches
+ * the algorithm combines the values of the whole group in a single loop.
+ */
+void add_group_funcs(xcml::xcml_program_node_ptr const& prg, replace_builtin_map_t& replace) {
+    static constexpr char const* PREFIX = "__charm_sycl_fiber_group_";
+
+    auto decls = u::new_code();
+    decls->value = group_algorithm_prototypes(PREFIX);
+    prg->preamble.push_back(decls);
+
+    add_group_algorithm_replacements(replace, PREFIX);
 }
 
 struct add_fiber_funcs final : xcml::recursive_visitor<add_fiber_funcs> {
@@ -364,17 +843,25 @@ xcml::xcml_program_node_ptr lower_cpu(xcml::xcml_program_node_ptr prg, utils::ta
 
     prg = array_as_vec(prg);
 
-    prg = apply_visitor<add_function_loader_visitor>(prg, target);
-    prg = apply_visitor<transform_kernel_wrapper>(prg);
+    funcset_t barrier_kernels;
+    prg = apply_visitor<collect_barrier_kernels>(prg, barrier_kernels);
+
+    funcset_t reduction_kernels;
+    prg = apply_visitor<collect_reduction_kernels>(prg, reduction_kernels);
+    prg = apply_visitor<vectorize_range_kernels>(prg, reduction_kernels);
+
+    funcset_t context_users;
+    bool direct_context = false;
+    prg = apply_visitor<collect_context_users>(prg, context_users, direct_context);
+    prg = apply_visitor<pass_context>(prg, context_users);
+
+    prg = apply_visitor<add_function_loader_visitor>(prg, target, barrier_kernels);
+    prg = apply_visitor<transform_kernel_wrapper>(prg, reduction_kernels);
 
     replace_builtin_map_t replace_map;
     implement_builtin_map_t implement_map;
 
-    add_common_replacements(replace_map);
-
-    replace_map["__charm_sycl_local_memory_base"] = [&](xcml::function_call_ptr const&) {
-        return u::make_call(u::make_func_addr("__charm_sycl_fiber_memory"), {});
-    };
+    add_common_replacements(replace_map, direct_context);
 
     replace_map["__charm_sycl_assume"] = [](xcml::function_call_ptr const& node) {
         node->function = u::make_func_addr("__builtin_assume");
@@ -391,7 +878,12 @@ xcml::xcml_program_node_ptr lower_cpu(xcml::xcml_program_node_ptr prg, utils::ta
                          u::make_call(u::make_func_addr("__charm_sycl_fiber_barrier"), {}));
         };
 
-    add_reduction_funcs(implement_map);
+    auto context_utils = u::new_code();
+    context_utils->value = CPU_CONTEXT_UTILS;
+    prg->preamble.push_back(context_utils);
+
+    add_reduction_funcs(prg, implement_map);
+    add_group_funcs(prg, replace_map);
     add_common_replace_math_funcs(replace_map, implement_map);
     prg = replace_builtin_function_calls(prg, replace_map);
     prg = implement_builtin_function_calls(prg, implement_map);
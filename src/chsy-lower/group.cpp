@@ -0,0 +1,65 @@
+#include "group.hpp"
+#include <fmt/format.h>
+#include <xcml_utils.hpp>
+
+namespace {
+
+constexpr std::string_view BUILTIN_PREFIX = "__charm_sycl_group_";
+
+constexpr std::string_view ALGORITHMS[] = {"reduce", "inclusive_scan", "exclusive_scan"};
+
+void add_replacement(replace_builtin_map_t& map, std::string_view prefix,
+                     std::string const& suffix) {
+    map[fmt::format("{}{}", BUILTIN_PREFIX, suffix)] =
+        [name = fmt::format("{}{}", prefix, suffix)](xcml::function_call_ptr const& node) {
+            node->function = xcml::utils::make_func_addr(name);
+            return node;
+        };
+}
+
+}  // namespace
+
+void add_group_algorithm_replacements(replace_builtin_map_t& map, std::string_view prefix) {
+    for_each_builtin_op([&](std::string_view op, builtin_type const& ty) {
+        for (auto alg : ALGORITHMS) {
+            add_replacement(map, prefix, fmt::format("{}_{}_{}", alg, op, ty.sig));
+        }
+    });
+
+    for (auto const& ty : BUILTIN_TYPES) {
+        add_replacement(map, prefix, fmt::format("broadcast_{}", ty.sig));
+    }
+}
+
+std::string group_algorithm_prototypes(std::string_view prefix) {
+    std::string res;
+
+    for_each_builtin_op([&](std::string_view op, builtin_type const& ty) {
+        for (auto alg : ALGORITHMS) {
+            res += fmt::format("{0} {1}{2}_{3}_{4}({0}, unsigned long, unsigned long);\n",
+                               ty.name, prefix, alg, op, ty.sig);
+        }
+    });
+
+    for (auto const& ty : BUILTIN_TYPES) {
+        res += fmt::format(
+            "{0} {1}broadcast_{2}({0}, unsigned long, unsigned long, unsigned long);\n",
+            ty.name, prefix, ty.sig);
+    }
+
+    return res;
+}
+
+bool is_group_algorithm(std::string_view name) {
+    if (!name.starts_with(BUILTIN_PREFIX)) {
+        return false;
+    }
+    name.remove_prefix(BUILTIN_PREFIX.size());
+
+    for (auto alg : ALGORITHMS) {
+        if (name.starts_with(alg) && name.size() > alg.size() && name[alg.size()] == '_') {
+            return true;
+        }
+    }
+    return name.starts_with("broadcast_");
+}
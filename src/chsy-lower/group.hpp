@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include "chsy-lower.hpp"
+
+// The types of the builtin reductions and group algorithms (CHARM_SYCL_FOR_EACH_BUILTIN_TYPE).
+struct builtin_type {
+    char const* sig;
+    char const* name;
+    bool is_integral;
+};
+
+inline constexpr builtin_type BUILTIN_TYPES[] = {
+    {"f", "float", false},        {"d", "double", false},
+    {"i", "int", true},           {"j", "unsigned int", true},
+    {"l", "long", true},          {"m", "unsigned long", true},
+    {"x", "long long", true},     {"y", "unsigned long long", true},
+};
+
+// Calls f(op, type) for each operation and type of CHARM_SYCL_FOR_EACH_BUILTIN_OP.
+template <class F>
+void for_each_builtin_op(F&& f) {
+    for (auto const& ty : BUILTIN_TYPES) {
+        for (std::string_view op : {"plus", "minimum", "maximum"}) {
+            f(op, ty);
+        }
+
+        if (ty.is_integral) {
+            for (std::string_view op : {"bit_and", "bit_or", "bit_xor"}) {
+                f(op, ty);
+            }
+        }
+    }
+}
+
+// Replaces the calls of __charm_sycl_group_<algorithm>_<op>_<sig> and
+// __charm_sycl_group_broadcast_<sig> with calls of `<prefix><algorithm>_<op>_<sig>` and
+// `<prefix>broadcast_<sig>`.
+void add_group_algorithm_replacements(replace_builtin_map_t& map, std::string_view prefix);
+
+// C prototypes of the functions that add_group_algorithm_replacements calls.
+std::string group_algorithm_prototypes(std::string_view prefix);
+
+// True if `name` is the builtin of a group algorithm.
+bool is_group_algorithm(std::string_view name);
@@ -5,6 +5,7 @@
 #include <xcml_recusive_visitor.hpp>
 #include <xcml_utils.hpp>
 #include "chsy-lower.hpp"
+#include "group.hpp"
 #include "math.hpp"
 
 namespace {
@@ -14,39 +15,286 @@ namespace u = xcml::utils;
 char const* CUDA_UTILS = R"(
 #include <stdint.h>
 
-[[maybe_unused]] inline __device__ bool __charm_sycl_is_leader_lane() {
-    uint32_t v;
-    asm volatile("mov.u32 %0, %laneid;" : "=r"(v));
-    return v == 0;
-}
-
-template <class T>
-[[maybe_unused]] inline __device__ T __charm_sycl_sum_in_warp(T local_val) {
-#pragma unroll
-    for (unsigned delta = warpSize / 2; delta > 0; delta /= 2) {
-        local_val += __shfl_down_sync(0xffffffff, local_val, delta);
-    }
-    return local_val;
-};
+#define __CHARM_SYCL_SHFL_UP(width, v, d) \
+    __shfl_up_sync((width) >= 32 ? 0xffffffffu : (1u << (width)) - 1, v, d)
+#define __CHARM_SYCL_SHFL_DOWN(width, v, d) \
+    __shfl_down_sync((width) >= 32 ? 0xffffffffu : (1u << (width)) - 1, v, d)
 )";
 
 char const* HIP_UTILS = R"(
 #include <hip/device_functions.h>
 #include <stdint.h>
 
-[[maybe_unused]] inline __device__ bool __charm_sycl_is_leader_lane() {
-    return __lane_id() == 0;
+#define __CHARM_SYCL_SHFL_UP(width, v, d) __shfl_up(v, d)
+#define __CHARM_SYCL_SHFL_DOWN(width, v, d) __shfl_down(v, d)
+)";
+
+/*
+ * Group algorithms. The values are scanned in the order of the local linear ids, which is not
+ * the order of the hardware threads in 2D and 3D groups: each thread stores its value at its
+ * local linear id, then the hardware thread `hw` scans the value at `hw` with warp shuffles and
+ * the totals of the warps are scanned by the first warp.
+ */
+char const* GPU_GROUP_UTILS = R"(
+#define __CHARM_SYCL_GROUP_MAX 1024
+
+template <class T>
+struct __charm_sycl_limits;
+
+#define __CHARM_SYCL_LIMITS(T, lo, hi)             \
+    template <>                                    \
+    struct __charm_sycl_limits<T> {                \
+        static inline __device__ T lowest() {      \
+            return lo;                             \
+        }                                          \
+        static inline __device__ T max() {         \
+            return hi;                             \
+        }                                          \
+    };
+
+__CHARM_SYCL_LIMITS(float, -__builtin_huge_valf(), __builtin_huge_valf())
+__CHARM_SYCL_LIMITS(double, -__builtin_huge_val(), __builtin_huge_val())
+__CHARM_SYCL_LIMITS(int, -__INT_MAX__ - 1, __INT_MAX__)
+__CHARM_SYCL_LIMITS(unsigned int, 0, ~0u)
+__CHARM_SYCL_LIMITS(long, -__LONG_MAX__ - 1, __LONG_MAX__)
+__CHARM_SYCL_LIMITS(unsigned long, 0, ~0ul)
+__CHARM_SYCL_LIMITS(long long, -__LONG_LONG_MAX__ - 1, __LONG_LONG_MAX__)
+__CHARM_SYCL_LIMITS(unsigned long long, 0, ~0ull)
+
+#define __CHARM_SYCL_OP(op, expr, id)                                 \
+    struct __charm_sycl_op_##op {                                     \
+        template <class T>                                            \
+        inline __device__ T operator()(T const& a, T const& b) const { \
+            return expr;                                              \
+        }                                                             \
+        template <class T>                                            \
+        static inline __device__ T identity() {                       \
+            return id;                                                \
+        }                                                             \
+    };
+
+__CHARM_SYCL_OP(plus, a + b, T(0))
+__CHARM_SYCL_OP(minimum, b < a ? b : a, __charm_sycl_limits<T>::max())
+__CHARM_SYCL_OP(maximum, a < b ? b : a, __charm_sycl_limits<T>::lowest())
+__CHARM_SYCL_OP(bit_and, a & b, T(~T(0)))
+__CHARM_SYCL_OP(bit_or, a | b, T(0))
+__CHARM_SYCL_OP(bit_xor, a ^ b, T(0))
+
+// kind: 0 = reduce, 1 = inclusive scan, 2 = exclusive scan.
+template <class Op, class T>
+[[maybe_unused]] inline __device__ T __charm_sycl_group_scan(T x, unsigned long lid,
+                                                             unsigned long n, int kind) {
+    __shared__ T slab[__CHARM_SYCL_GROUP_MAX];
+    __shared__ T partial[__CHARM_SYCL_GROUP_MAX / 32];
+
+    Op op;
+    unsigned const hw = threadIdx.x + blockDim.x * (threadIdx.y + blockDim.y * threadIdx.z);
+    unsigned const lane = hw % warpSize;
+    unsigned const warp = hw / warpSize;
+    unsigned const n_warps = (n + warpSize - 1) / warpSize;
+    unsigned const width = min(unsigned(n) - warp * warpSize, unsigned(warpSize));
+
+    slab[lid] = x;
+    __syncthreads();
+
+    T v = slab[hw];
+    for (unsigned d = 1; d < width; d *= 2) {
+        T const y = __CHARM_SYCL_SHFL_UP(width, v, d);
+        if (lane >= d) {
+            v = op(y, v);
+        }
+    }
+    if (lane == width - 1) {
+        partial[warp] = v;
+    }
+    __syncthreads();
+
+    if (warp == 0 && lane < n_warps) {
+        T p = partial[lane];
+        for (unsigned d = 1; d < n_warps; d *= 2) {
+            T const y = __CHARM_SYCL_SHFL_UP(n_warps, p, d);
+            if (lane >= d) {
+                p = op(y, p);
+            }
+        }
+        partial[lane] = p;
+    }
+    __syncthreads();
+
+    if (warp > 0) {
+        v = op(partial[warp - 1], v);
+    }
+    slab[hw] = v;
+    __syncthreads();
+
+    T res;
+    if (kind == 0) {
+        res = slab[n - 1];
+    } else if (kind == 1) {
+        res = slab[lid];
+    } else {
+        res = lid == 0 ? Op::template identity<T>() : slab[lid - 1];
+    }
+    __syncthreads();
+
+    return res;
 }
 
 template <class T>
-[[maybe_unused]] inline __device__ T __charm_sycl_sum_in_warp(T local_val) {
-#pragma unroll
-    for (unsigned delta = warpSize / 2; delta > 0; delta /= 2) {
-        local_val += __shfl_down(local_val, delta);
-        __syncthreads();
+[[maybe_unused]] inline __device__ T __charm_sycl_group_broadcast(T x, unsigned long lid,
+                                                                  unsigned long from) {
+    __shared__ T slot;
+
+    if (lid == from) {
+        slot = x;
     }
-    return local_val;
+    __syncthreads();
+
+    T const res = slot;
+    __syncthreads();
+
+    return res;
+}
+
+#define __CHARM_SYCL_GPU_GROUP_OP(op, t, T)                                                \
+    [[maybe_unused]] inline __device__ T __charm_sycl_gpu_group_reduce_##op##_##t(         \
+        T x, unsigned long lid, unsigned long n) {                                         \
+        return __charm_sycl_group_scan<__charm_sycl_op_##op>(x, lid, n, 0);                \
+    }                                                                                      \
+    [[maybe_unused]] inline __device__ T __charm_sycl_gpu_group_inclusive_scan_##op##_##t( \
+        T x, unsigned long lid, unsigned long n) {                                         \
+        return __charm_sycl_group_scan<__charm_sycl_op_##op>(x, lid, n, 1);                \
+    }                                                                                      \
+    [[maybe_unused]] inline __device__ T __charm_sycl_gpu_group_exclusive_scan_##op##_##t( \
+        T x, unsigned long lid, unsigned long n) {                                         \
+        return __charm_sycl_group_scan<__charm_sycl_op_##op>(x, lid, n, 2);                \
+    }
+
+#define __CHARM_SYCL_GPU_GROUP_TYPE(t, T)                                                  \
+    __CHARM_SYCL_GPU_GROUP_OP(plus, t, T)                                                  \
+    __CHARM_SYCL_GPU_GROUP_OP(minimum, t, T)                                               \
+    __CHARM_SYCL_GPU_GROUP_OP(maximum, t, T)                                               \
+    [[maybe_unused]] inline __device__ T __charm_sycl_gpu_group_broadcast_##t(             \
+        T x, unsigned long lid, unsigned long, unsigned long from) {                       \
+        return __charm_sycl_group_broadcast(x, lid, from);                                 \
+    }
+
+#define __CHARM_SYCL_GPU_GROUP_INT_TYPE(t, T) \
+    __CHARM_SYCL_GPU_GROUP_TYPE(t, T)         \
+    __CHARM_SYCL_GPU_GROUP_OP(bit_and, t, T)  \
+    __CHARM_SYCL_GPU_GROUP_OP(bit_or, t, T)   \
+    __CHARM_SYCL_GPU_GROUP_OP(bit_xor, t, T)
+
+__CHARM_SYCL_GPU_GROUP_TYPE(f, float)
+__CHARM_SYCL_GPU_GROUP_TYPE(d, double)
+__CHARM_SYCL_GPU_GROUP_INT_TYPE(i, int)
+__CHARM_SYCL_GPU_GROUP_INT_TYPE(j, unsigned int)
+__CHARM_SYCL_GPU_GROUP_INT_TYPE(l, long)
+__CHARM_SYCL_GPU_GROUP_INT_TYPE(m, unsigned long)
+__CHARM_SYCL_GPU_GROUP_INT_TYPE(x, long long)
+__CHARM_SYCL_GPU_GROUP_INT_TYPE(y, unsigned long long)
+)";
+
+/*
+ * Reductions. Each warp reduces its values with shuffles, the first lane of each warp combines
+ * the result of the warp into a shared value, and the leader combines that into the global
+ * value. The values are combined with a compare-and-swap loop on their bits, which works for
+ * every operation and type.
+ */
+char const* GPU_REDUCE_UTILS = R"(
+template <int Size>
+struct __charm_sycl_bits;
+
+template <>
+struct __charm_sycl_bits<4> {
+    using type = unsigned int;
+};
+
+template <>
+struct __charm_sycl_bits<8> {
+    using type = unsigned long long;
 };
+
+template <class Op, class T>
+[[maybe_unused]] inline __device__ void __charm_sycl_atomic_combine(T* ptr, T val) {
+    using U = typename __charm_sycl_bits<sizeof(T)>::type;
+
+    U* const p = reinterpret_cast<U*>(ptr);
+    U old = *p;
+    U assumed;
+
+    do {
+        assumed = old;
+
+        T cur;
+        __builtin_memcpy(&cur, &assumed, sizeof(T));
+        T const res = Op()(cur, val);
+
+        U desired;
+        __builtin_memcpy(&desired, &res, sizeof(T));
+        old = atomicCAS(p, assumed, desired);
+    } while (old != assumed);
+}
+
+// The leader is the thread (0, 0, 0), which is the first lane of the first warp.
+template <class Op, class T>
+[[maybe_unused]] inline __device__ void __charm_sycl_reduce_finalize(T* g_ptr, T val,
+                                                                     bool is_leader) {
+    __shared__ T red;
+
+    Op op;
+    unsigned const hw = threadIdx.x + blockDim.x * (threadIdx.y + blockDim.y * threadIdx.z);
+    unsigned const n = blockDim.x * blockDim.y * blockDim.z;
+    unsigned const lane = hw % warpSize;
+    unsigned const width = min(n - (hw - lane), unsigned(warpSize));
+
+    for (unsigned d = warpSize / 2; d > 0; d /= 2) {
+        T const y = __CHARM_SYCL_SHFL_DOWN(width, val, d);
+        if (lane + d < width) {
+            val = op(val, y);
+        }
+    }
+
+    if (is_leader) {
+        red = val;
+    }
+    __syncthreads();
+
+    if (lane == 0 && !is_leader) {
+        __charm_sycl_atomic_combine<Op>(&red, val);
+    }
+    __syncthreads();
+
+    if (is_leader) {
+        __charm_sycl_atomic_combine<Op>(g_ptr, red);
+    }
+}
+
+#define __CHARM_SYCL_GPU_REDUCE_OP(op, t, T)                                             \
+    [[maybe_unused]] inline __device__ void __charm_sycl_gpu_reduce_finalize_##op##_##t( \
+        T* g_ptr, T val, bool is_leader) {                                               \
+        __charm_sycl_reduce_finalize<__charm_sycl_op_##op>(g_ptr, val, is_leader);       \
+    }
+
+#define __CHARM_SYCL_GPU_REDUCE_TYPE(t, T)    \
+    __CHARM_SYCL_GPU_REDUCE_OP(plus, t, T)    \
+    __CHARM_SYCL_GPU_REDUCE_OP(minimum, t, T) \
+    __CHARM_SYCL_GPU_REDUCE_OP(maximum, t, T)
+
+#define __CHARM_SYCL_GPU_REDUCE_INT_TYPE(t, T) \
+    __CHARM_SYCL_GPU_REDUCE_TYPE(t, T)         \
+    __CHARM_SYCL_GPU_REDUCE_OP(bit_and, t, T)  \
+    __CHARM_SYCL_GPU_REDUCE_OP(bit_or, t, T)   \
+    __CHARM_SYCL_GPU_REDUCE_OP(bit_xor, t, T)
+
+__CHARM_SYCL_GPU_REDUCE_TYPE(f, float)
+__CHARM_SYCL_GPU_REDUCE_TYPE(d, double)
+__CHARM_SYCL_GPU_REDUCE_INT_TYPE(i, int)
+__CHARM_SYCL_GPU_REDUCE_INT_TYPE(j, unsigned int)
+__CHARM_SYCL_GPU_REDUCE_INT_TYPE(l, long)
+__CHARM_SYCL_GPU_REDUCE_INT_TYPE(m, unsigned long)
+__CHARM_SYCL_GPU_REDUCE_INT_TYPE(x, long long)
+__CHARM_SYCL_GPU_REDUCE_INT_TYPE(y, unsigned long long)
 )";
 
 inline xcml::cuda_attribute_ptr cuda_device() {
@@ -232,115 +480,28 @@ private:
                                  u::log_eq_expr(u::make_var_ref("threadIdx.z"), u::lit(0)))));
             };
 
-        struct type_pair {
-            char const* t;
-            char const* ty;
-        };
-
-        for (type_pair const& x : (type_pair[]){
-                 {"f", "float"},
-                 {"d", "double"},
-             }) {
-            auto const init_fn = fmt::format("__charm_sycl_reduce_initialize_{}", x.t);
-            auto const comb_fn = fmt::format("__charm_sycl_reduce_combine_{}", x.t);
-            auto const fini_fn = fmt::format("__charm_sycl_reduce_finalize_{}", x.t);
-
-            handlers_[init_fn] = [](xcml::function_decl_ptr const&,
-                                    xcml::function_type_ptr const&,
-                                    xcml::function_definition_ptr const& fd) {
-                auto val = u::make_var_ref(xcml::param_node::dyncast(fd->params.at(0))->name);
-
-                /*
-                 * *val = 0;
-                 */
-                u::push_expr(fd->body, u::assign_expr(u::make_deref(val), u::lit(0)));
-            };
-
-            handlers_[comb_fn] = [](xcml::function_decl_ptr const&,
-                                    xcml::function_type_ptr const&,
-                                    xcml::function_definition_ptr const& fd) {
-                /*
-                 * *val += partial;
-                 */
-                auto val = u::make_var_ref(xcml::param_node::dyncast(fd->params.at(0))->name);
-                auto partial =
-                    u::make_var_ref(xcml::param_node::dyncast(fd->params.at(1))->name);
-
-                u::push_expr(fd->body, u::asg_plus_expr(u::make_deref(val), partial));
-            };
-
-            handlers_[fini_fn] = [](xcml::function_decl_ptr const&,
-                                    xcml::function_type_ptr const&,
-                                    xcml::function_definition_ptr const& fd) {
-                auto g_ptr = u::make_var_ref(xcml::param_node::dyncast(fd->params.at(0))->name);
-                auto param1 = xcml::param_node::dyncast(fd->params.at(1));
-                auto val = u::make_var_ref(param1->name);
-                auto value_type = param1->type;
-                auto is_leader =
-                    u::make_var_ref(xcml::param_node::dyncast(fd->params.at(2))->name);
-
-                /*
-                 * __shared__ ${value_type} red;
-                 */
-                auto red = u::add_local_var(fd->body, value_type, "_s__red");
-                auto red_ptr = u::make_addr_of(red);
-                fd->body->symbols.back()->cudaAttributes.push_back(cuda_shared());
-
-                auto red_init = u::new_if_stmt();
-                red_init->condition = is_leader;
-                u::push_expr(red_init->then, u::assign_expr(red, u::lit(0)));
-
-                /*
-                 * if (is_leader) {
-                 *     red = 0;
-                 * }
-                 */
-                u::push_stmt(fd->body, red_init);
-                /*
-                 * __syncthreads();
-                 */
-                u::push_expr(fd->body, u::make_call(u::make_func_addr("__syncthreads")));
-
-                /*
-                 * val = __charm_sycl_sum_in_warp(val);
-                 */
-                u::push_expr(
-                    fd->body,
-                    u::assign_expr(
-                        val,
-                        u::make_call(u::make_func_addr("__charm_sycl_sum_in_warp"), {val})));
+        for_each_builtin_op([&](std::string_view op, builtin_type const& ty) {
+            auto const fini_fn = fmt::format("__charm_sycl_reduce_finalize_{}_{}", op, ty.sig);
+            auto const gpu_fn =
+                fmt::format("__charm_sycl_gpu_reduce_finalize_{}_{}", op, ty.sig);
 
-                auto if_is_leader_lane = u::new_if_stmt();
-                if_is_leader_lane->condition =
-                    u::make_call(u::make_func_addr("__charm_sycl_is_leader_lane"), {});
+            handlers_[fini_fn] = [gpu_fn](xcml::function_decl_ptr const&,
+                                          xcml::function_type_ptr const&,
+                                          xcml::function_definition_ptr const& fd) {
+                std::vector<xcml::expr_ptr> args;
 
-                u::push_expr(if_is_leader_lane->then,
-                             u::make_call(u::make_func_addr("atomicAdd"), {red_ptr, val}));
+                for (size_t i = 0; i < 3; i++) {
+                    auto param = xcml::param_node::dyncast(fd->params.at(i));
+                    args.push_back(u::make_var_ref(param->name));
+                }
 
                 /*
-                 * if (__charm_sycl_is_leader_lane()) {
-                 *     atomicAdd(&red, val);
-                 * }
-                 */
-                u::push_stmt(fd->body, if_is_leader_lane);
-                /*
-                 * __syncthreads();
+                 * __charm_sycl_gpu_reduce_finalize_${op}_${t}(g_ptr, val, is_leader);
                  */
-                u::push_expr(fd->body, u::make_call(u::make_func_addr("__syncthreads")));
-
-                auto if_leader = u::new_if_stmt();
-                if_leader->condition = is_leader;
-
-                u::push_expr(if_leader->then,
-                             u::make_call(u::make_func_addr("atomicAdd"), {g_ptr, red}));
-                /*
-                 * if (is_leader) {
-                 *     atomicAdd(g_ptr, red);
-                 * }
-                 */
-                u::push_stmt(fd->body, if_leader);
+                u::push_expr(fd->body,
+                             u::make_call(u::make_func_addr(gpu_fn), args.begin(), args.end()));
             };
-        }
+        });
     }
 
     std::unordered_map<std::string, std::function<void(xcml::function_decl_ptr const&,
@@ -434,6 +595,8 @@ xcml::xcml_program_node_ptr do_lower(utils::target target, xcml::xcml_program_no
         prg = array_as_vec(prg);
         utils->value = CUDA_UTILS;
     }
+    utils->value += GPU_GROUP_UTILS;
+    utils->value += GPU_REDUCE_UTILS;
     prg->preamble.push_back(utils);
 
     prg = apply_visitor<transform_kernel_wrapper>(prg);
@@ -442,6 +605,7 @@ xcml::xcml_program_node_ptr do_lower(utils::target target, xcml::xcml_program_no
     implement_builtin_map_t implement_map;
     add_common_replacements(replace_map);
     add_common_replace_math_funcs(replace_map, implement_map);
+    add_group_algorithm_replacements(replace_map, "__charm_sycl_gpu_group_");
     prg = replace_builtin_function_calls(prg, replace_map);
     prg = implement_builtin_function_calls(prg, implement_map);
 
@@ -0,0 +1,315 @@
+#include "cache.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <fmt/format.h>
+#include <unistd.h>
+#include <utils/hash.hpp>
+#include <charm/sycl/config.hpp>
+
+namespace fs = std::filesystem;
+namespace io = utils::io;
+using boost::leaf::result;
+
+namespace {
+
+// Each value is preceded by its length, so that ("ab", "c") and ("a", "bc") differ.
+void add(utils::fnv1a_128& h, std::string_view val) {
+    h.update(fmt::format("{}:", val.size()));
+    h.update(val);
+}
+
+std::string file_id(std::string const& path) {
+    std::error_code ec;
+
+    auto const size = fs::file_size(path, ec);
+    if (ec) {
+        return path;
+    }
+
+    auto const mtime = fs::last_write_time(path, ec);
+    if (ec) {
+        return path;
+    }
+
+    return fmt::format("{}:{}:{}", path, size, mtime.time_since_epoch().count());
+}
+
+// The share of the size limit of each of the 16 directories is reduced to this ratio, so that
+// eviction does not run at every store.
+constexpr uint64_t EVICT_TO_PERCENT = 90;
+
+// Temporary directories older than this are left by killed processes.
+constexpr auto STALE_TEMP_AGE = std::chrono::hours(1);
+
+}  // namespace
+
+kernel_cache::kernel_cache(config const& cfg) : cfg_(cfg), dir_(cfg.cache_dir) {}
+
+bool kernel_cache::enabled() const {
+    return !dir_.empty();
+}
+
+result<std::string> kernel_cache::common_key() {
+    std::lock_guard lock(mtx_);
+
+    if (cscc_id_.empty()) {
+        // cscc runs kext, lowering and the C back-end, and it is clang in the portable mode.
+        cscc_id_ = file_id(BOOST_LEAF_CHECK(io::read_proc_self_exe()));
+    }
+
+    utils::fnv1a_128 h;
+    add(h, CHARM_SYCL_VERSION);
+    add(h, cscc_id_);
+    return h.hex();
+}
+
+result<std::string> kernel_cache::kext_key(io::file const& dev_cpp) {
+    auto const common = BOOST_LEAF_CHECK(common_key());
+    auto const src = BOOST_LEAF_CHECK(dev_cpp.read_all_str());
+
+    // The names of the kernels are collected only for the CPU targets.
+    auto const has_cpu = std::any_of(cfg_.targets.begin(), cfg_.targets.end(),
+                                     [](auto t) { return is_cpu(t); });
+
+    utils::fnv1a_128 h;
+    add(h, "kext");
+    add(h, common);
+    add(h, has_cpu ? "cpu" : "");
+    add(h, src);
+    return h.hex();
+}
+
+std::string kernel_cache::source_key(std::string_view kext_key, utils::target target) const {
+    utils::fnv1a_128 h;
+    add(h, "source");
+    add(h, kext_key);
+    add(h, show(target));
+    return h.hex();
+}
+
+result<std::string> kernel_cache::object_key(io::file const& source, std::string_view input,
+                                             utils::target target, cudafmt fmt) {
+    auto const common = BOOST_LEAF_CHECK(common_key());
+    auto const src = BOOST_LEAF_CHECK(source.read_all_str());
+
+    std::string compiler;
+    switch (target) {
+        case utils::target::NONE:
+            break;
+
+        case utils::target::CPU_C:
+        case utils::target::CPU_OPENMP:
+            compiler = BOOST_LEAF_CHECK(cfg_.cc_for_kernel());
+            break;
+
+        case utils::target::NVIDIA_CUDA:
+            compiler = BOOST_LEAF_CHECK(cfg_.nvcc());
+            break;
+
+        case utils::target::AMD_HIP:
+            compiler = BOOST_LEAF_CHECK(cfg_.hipcc());
+            break;
+    }
+
+    utils::fnv1a_128 h;
+    add(h, "object");
+    add(h, common);
+    add(h, fs::absolute(input).string());
+    add(h, show(target));
+    add(h, std::to_string(static_cast<int>(fmt)));
+    add(h, src);
+
+    // The device compiler and the host compiler, which compiles the loaders of the binaries.
+    add(h, command_id(compiler));
+    add(h, command_id(cfg_.cxx));
+
+    add(h, std::string(1, cfg_.opt_level));
+    add(h, cfg_.debug ? "g" : "");
+    add(h, cfg_.device_debug ? "G" : "");
+    add(h, cfg_.host_openmp ? "fopenmp" : "");
+    add(h, cfg_.fsanitize);
+    add(h, cfg_.cuda_arch);
+
+    for (auto const& dir : cfg_.include_dirs) {
+        add(h, dir);
+    }
+
+    std::vector<std::pair<std::string, std::string>> defines(cfg_.defines.begin(),
+                                                             cfg_.defines.end());
+    std::sort(defines.begin(), defines.end());
+    for (auto const& [k, v] : defines) {
+        add(h, k);
+        add(h, v);
+    }
+
+    return h.hex();
+}
+
+result<bool> kernel_cache::load(std::string const& key, size_t n,
+                                std::vector<io::file>& files) {
+    auto const path = entry_path(key);
+    std::vector<std::pair<size_t, fs::path>> names;
+    std::error_code ec;
+
+    for (auto it = fs::directory_iterator(path, ec); !ec && it != fs::directory_iterator();
+         it.increment(ec)) {
+        auto const name = it->path().filename().string();
+
+        size_t idx = 0;
+        auto const [ptr, ec2] = std::from_chars(name.data(), name.data() + name.size(), idx);
+        if (ec2 == std::errc()) {
+            names.emplace_back(idx, it->path());
+        }
+    }
+    std::sort(names.begin(), names.end());
+
+    // The entry may be partially removed by another process.
+    bool found = !ec && names.size() == n;
+    for (size_t i = 0; found && i < n; i++) {
+        found = names[i].first == i;
+    }
+
+    std::vector<io::file> out;
+    for (size_t i = 0; found && i < n; i++) {
+        auto f = BOOST_LEAF_CHECK(io::file::mktemp(names[i].second.extension().string()));
+
+        found = fs::copy_file(names[i].second, f.filename(),
+                              fs::copy_options::overwrite_existing, ec);
+        out.push_back(std::move(f));
+    }
+
+    if (!found) {
+        n_misses_++;
+        cfg_.task_msg(fmt::format("Kernel cache miss: {}", key));
+        return false;
+    }
+
+    // The modification time of an entry is the time when it is last used.
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+
+    n_hits_++;
+    cfg_.task_msg(fmt::format("Kernel cache hit: {}", key));
+
+    files = std::move(out);
+    return true;
+}
+
+void kernel_cache::store(std::string const& key, std::vector<io::file const*> const& files) {
+    auto const path = entry_path(key);
+    auto const dir = path.parent_path();
+    std::error_code ec;
+
+    fs::create_directories(dir, ec);
+    if (ec) {
+        return;
+    }
+
+    auto const tmp = dir / fmt::format(".{}.{}.{}", key, ::getpid(), n_stores_++);
+
+    fs::create_directory(tmp, ec);
+    for (size_t i = 0; !ec && i < files.size(); i++) {
+        fs::copy_file(files[i]->filename(), tmp / fmt::format("{}{}", i, files[i]->ext()), ec);
+    }
+
+    // The rename fails if another job or process has added the same entry.
+    if (!ec) {
+        fs::rename(tmp, path, ec);
+    }
+
+    if (ec) {
+        fs::remove_all(tmp, ec);
+        return;
+    }
+
+    cfg_.task_msg(fmt::format("Stored in the kernel cache: {}", key));
+
+    evict(dir);
+}
+
+void kernel_cache::report() const {
+    if (cfg_.verbose && enabled()) {
+        fmt::print(stderr, "  KERNEL CACHE: {} hits, {} misses ({})\n", n_hits_.load(),
+                   n_misses_.load(), dir_.string());
+    }
+}
+
+fs::path kernel_cache::entry_path(std::string_view key) const {
+    return dir_ / key.substr(0, 1) / key;
+}
+
+std::string kernel_cache::command_id(std::string const& command) {
+    std::lock_guard lock(mtx_);
+
+    if (auto const it = command_ids_.find(command); it != command_ids_.end()) {
+        return it->second;
+    }
+
+    // The commands that cscc runs itself, such as __clang__, are not found.
+    auto const path = find_command(command);
+    auto id = path.empty() ? command : file_id(path);
+
+    return command_ids_.emplace(command, std::move(id)).first->second;
+}
+
+void kernel_cache::evict(fs::path const& dir) const {
+    struct entry {
+        fs::path path;
+        fs::file_time_type time;
+        uintmax_t size;
+    };
+
+    std::vector<entry> entries;
+    uintmax_t total = 0;
+    auto const now = fs::file_time_type::clock::now();
+    std::error_code ec;
+
+    for (auto it = fs::directory_iterator(dir, ec); !ec && it != fs::directory_iterator();
+         it.increment(ec)) {
+        std::error_code ec2;
+        auto const time = fs::last_write_time(it->path(), ec2);
+
+        if (ec2) {
+            continue;
+        }
+
+        if (it->path().filename().string().starts_with(".")) {
+            if (now - time > STALE_TEMP_AGE) {
+                fs::remove_all(it->path(), ec2);
+            }
+            continue;
+        }
+
+        uintmax_t size = 0;
+        for (auto f = fs::directory_iterator(it->path(), ec2);
+             !ec2 && f != fs::directory_iterator(); f.increment(ec2)) {
+            std::error_code ec3;
+            auto const n = f->file_size(ec3);
+            size += ec3 ? 0 : n;
+        }
+
+        entries.push_back({it->path(), time, size});
+        total += size;
+    }
+
+    auto const limit = cfg_.cache_size / 16;
+    if (total <= limit) {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(),
+              [](entry const& a, entry const& b) { return a.time < b.time; });
+
+    auto const target = limit / 100 * EVICT_TO_PERCENT;
+    for (auto const& e : entries) {
+        if (total <= target) {
+            break;
+        }
+
+        fs::remove_all(e.path, ec);
+        total -= e.size;
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <boost/leaf/result.hpp>
+#include <utils/io.hpp>
+#include <utils/target.hpp>
+#include "config.hpp"
+#include "task.hpp"
+
+/*
+ * A persistent cache of the kernels that cscc compiles. An entry is a set of files, and its key
+ * is a hash of everything that the files are made from, so entries are never invalidated but
+ * only evicted.
+ *
+ * The entries are split into 16 directories by the first digit of the key, and each directory
+ * keeps its share of the size limit by evicting its least recently used entries. The cache may
+ * be shared by several cscc processes, so an entry is written to a temporary directory and then
+ * renamed, and an entry that is removed while it is loaded is a miss.
+ *
+ * The cache is only an optimization, so it does not fail because of its own I/O errors.
+ */
+struct kernel_cache {
+    explicit kernel_cache(config const& cfg);
+
+    kernel_cache(kernel_cache const&) = delete;
+
+    kernel_cache(kernel_cache&&) = delete;
+
+    kernel_cache& operator=(kernel_cache const&) = delete;
+
+    kernel_cache& operator=(kernel_cache&&) = delete;
+
+    bool enabled() const;
+
+    // The key of the entry made by kext from `dev_cpp`, which is the preprocessed source.
+    [[nodiscard]] boost::leaf::result<std::string> kext_key(utils::io::file const& dev_cpp);
+
+    // The key of the entry of the kernel source of `target`.
+    std::string source_key(std::string_view kext_key, utils::target target) const;
+
+    // The key of the entry of the objects that are compiled from a kernel source. The key
+    // depends on the content of the source rather than on the key of the source, so a change
+    // to the host code of `input` does not make the device compiler run again. `input` is part
+    // of the key, since the objects define symbols that are unique to each input.
+    [[nodiscard]] boost::leaf::result<std::string> object_key(utils::io::file const& source,
+                                                             std::string_view input,
+                                                             utils::target target,
+                                                             cudafmt fmt);
+
+    // Copies the `n` files of an entry to temporary files. Returns false on a miss.
+    [[nodiscard]] boost::leaf::result<bool> load(std::string const& key, size_t n,
+                                                 std::vector<utils::io::file>& files);
+
+    // Adds an entry, unless another process has just added it.
+    void store(std::string const& key, std::vector<utils::io::file const*> const& files);
+
+    // Prints the number of hits and misses under --verbose.
+    void report() const;
+
+private:
+    // A hash of the version and the executable of cscc, which every key depends on.
+    [[nodiscard]] boost::leaf::result<std::string> common_key();
+
+    std::filesystem::path entry_path(std::string_view key) const;
+
+    // The path, size and modification time of a command, so that an upgraded compiler makes
+    // new keys.
+    std::string command_id(std::string const& command);
+
+    void evict(std::filesystem::path const& dir) const;
+
+    config const& cfg_;
+    std::filesystem::path dir_;
+
+    std::mutex mtx_;
+    std::string cscc_id_;
+    detail::str_map<std::string> command_ids_;
+
+    std::atomic<unsigned> n_hits_ = 0;
+    std::atomic<unsigned> n_misses_ = 0;
+    std::atomic<unsigned> n_stores_ = 0;
+};
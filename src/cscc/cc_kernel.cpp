@@ -53,6 +53,9 @@ result<io::file> compile_kernel_cc(config const& cfg, io::file const& input,
                 cmd.push_back("-fopenmp=libgomp");
                 break;
         }
+    } else {
+        // Enables the `omp simd` loops without the OpenMP runtime.
+        cmd.push_back("-fopenmp-simd");
     }
 
     cmd.push_back(std::string("-O") + cfg.opt_level);
@@ -62,6 +65,18 @@ result<io::file> compile_kernel_cc(config const& cfg, io::file const& input,
     if (!cfg.fsanitize.empty()) {
         cmd.push_back("-fsanitize=" + cfg.fsanitize);
     }
+    if (cfg.vec_report) {
+        switch (cc_vendor) {
+            case cc_vendor::gcc:
+                cmd.push_back("-fopt-info-vec-optimized");
+                break;
+
+            case cc_vendor::clang:
+            case cc_vendor::internal_clang:
+                cmd.push_back("-Rpass=loop-vectorize");
+                break;
+        }
+    }
 
     if (cmd.front() == "__clang__") {
         cmd.push_back("--driver-mode=gcc");
@@ -7,8 +7,56 @@
 namespace io = utils::io;
 using boost::leaf::result;
 
-result<utils::io::file> compile_host(config const& cfg, io::file const& input, bool cc_mode,
-                                     bool pic) {
+namespace {
+
+// The paths of the headers of the runtime, which a preprocessed input does not need. They are
+// system paths, so that the warnings of the runtime and the generated headers are not
+// reported to the user.
+void add_runtime_include_paths([[maybe_unused]] config const& cfg,
+                               std::vector<std::string>& cmd) {
+#ifdef CSCC_PORTABLE_MODE
+    cmd.push_back("-isystem/__runtime__");
+    cmd.push_back("-isystem/__clang__");
+#else
+    if (auto const inc = cfg.include_path_src(); !inc.empty()) {
+        cmd.push_back("-isystem" + inc);
+    }
+    if (auto const inc = cfg.include_path_bin(); !inc.empty()) {
+        cmd.push_back("-isystem" + inc);
+    }
+    if (auto const inc = cfg.include_path_gen(); !inc.empty()) {
+        cmd.push_back("-isystem" + inc);
+    }
+#endif
+}
+
+void add_dependency_options(config const& cfg, std::vector<std::string>& cmd) {
+    if (cfg.md) {
+        cmd.push_back("-MD");
+    }
+    if (cfg.mmd) {
+        cmd.push_back("-MMD");
+    }
+    if (cfg.mm) {
+        cmd.push_back("-MM");
+    }
+    if (cfg.m) {
+        cmd.push_back("-M");
+    }
+    if (!cfg.mf.empty()) {
+        cmd.push_back("-MF");
+        cmd.push_back(cfg.mf);
+    }
+    if (!cfg.mt.empty()) {
+        cmd.push_back("-MT");
+        cmd.push_back(cfg.mt);
+    }
+}
+
+// If `desc_file` is not null, `input` is a SYCL source that has not been preprocessed, and
+// `desc_file` is the descriptor of its kernels.
+result<utils::io::file> compile_host_impl(config const& cfg, io::file const& input,
+                                          bool cc_mode, bool pic, io::file const* desc_file) {
     cfg.begin_task("Compiling Host Code");
 
     auto out = BOOST_LEAF_CHECK(utils::io::file::mktemp(".o"));
@@ -32,6 +80,11 @@ result<utils::io::file> compile_host(config const& cfg, io::file const& input, b
         switch (BOOST_LEAF_CHECK(check_cc_vendor(cfg))) {
             case cc_vendor::gcc:
                 cmd.push_back("-lgomp");
+
+                // run_cpp() defines it for a preprocessed input.
+                if (desc_file) {
+                    cmd.push_back("-D_OPENMP");
+                }
                 break;
 
             case cc_vendor::clang:
@@ -44,9 +97,19 @@ result<utils::io::file> compile_host(config const& cfg, io::file const& input, b
 #ifdef CSCC_USE_LIBCXX
     cmd.push_back(fmt::format("-stdlib=libc++"));
 #endif
+
+    if (desc_file) {
+        // Like run_cpp(), which the host code of a SYCL source went through before.
+        cmd.push_back("-include");
+        cmd.push_back(desc_file->filename());
+
+        add_runtime_include_paths(cfg, cmd);
+        add_dependency_options(cfg, cmd);
+    } else {
 #ifdef CSCC_PORTABLE_MODE
-    cmd.push_back("-I/__clang__");
+        cmd.push_back("-I/__clang__");
 #endif
+    }
 
     cmd.push_back(std::string("-O") + cfg.opt_level);
     if (cfg.debug) {
@@ -80,6 +143,24 @@ result<utils::io::file> compile_host(config const& cfg, io::file const& input, b
     return out;
 }
 
+}  // namespace
+
+result<utils::io::file> compile_host(config const& cfg, io::file const& input, bool cc_mode,
+                                     bool pic) {
+    return compile_host_impl(cfg, input, cc_mode, pic, nullptr);
+}
+
+result<utils::io::file> compile_sycl_host(config const& cfg, io::file const& input,
+                                          io::file const& desc_file) {
+    // The preprocessed source is kept only if it is saved.
+    if (is_saved(cfg, filetype::other)) {
+        auto host_cpp = BOOST_LEAF_CHECK(run_cpp(cfg, input, &desc_file, true));
+        return compile_host(cfg, host_cpp, false, false);
+    }
+
+    return compile_host_impl(cfg, input, false, false, &desc_file);
+}
+
 [[nodiscard]] result<io::file> run_cpp(config const& cfg, io::file const& input,
                                        io::file const* desc_file, bool for_host) {
     cfg.begin_task("Running Preprocessor");
@@ -101,20 +182,7 @@ result<utils::io::file> compile_host(config const& cfg, io::file const& input, b
     cmd.push_back(fmt::format("-stdlib=libc++"));
 #endif
 
-#ifdef CSCC_PORTABLE_MODE
-    cmd.push_back("-I/__runtime__");
-    cmd.push_back("-isystem/__clang__");
-#else
-    if (auto const inc = cfg.include_path_src(); !inc.empty()) {
-        cmd.push_back("-I" + inc);
-    }
-    if (auto const inc = cfg.include_path_bin(); !inc.empty()) {
-        cmd.push_back("-I" + inc);
-    }
-    if (auto const inc = cfg.include_path_gen(); !inc.empty()) {
-        cmd.push_back("-I" + inc);
-    }
-#endif
+    add_runtime_include_paths(cfg, cmd);
 
     if (cfg.host_openmp) {
         cmd.push_back("-D_OPENMP");
@@ -131,26 +199,7 @@ result<utils::io::file> compile_host(config const& cfg, io::file const& input, b
         }
     }
     if (for_host) {
-        if (cfg.md) {
-            cmd.push_back("-MD");
-        }
-        if (cfg.mmd) {
-            cmd.push_back("-MMD");
-        }
-        if (cfg.mm) {
-            cmd.push_back("-MM");
-        }
-        if (cfg.m) {
-            cmd.push_back("-M");
-        }
-        if (!cfg.mf.empty()) {
-            cmd.push_back("-MF");
-            cmd.push_back(cfg.mf);
-        }
-        if (!cfg.mt.empty()) {
-            cmd.push_back("-MT");
-            cmd.push_back(cfg.mt);
-        }
+        add_dependency_options(cfg, cmd);
     }
 
     if (cmd.front() == "__clang__") {
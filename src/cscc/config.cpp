@@ -1,6 +1,10 @@
 #include "config.h"
 #include <chrono>
+#include <cstdlib>
 #include <filesystem>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 #include <boost/assert.hpp>
 #include <fmt/format.h>
@@ -48,8 +52,16 @@ struct config::impl {
         std::chrono::high_resolution_clock::time_point start;
     };
 
-    std::vector<state> tasks_;
+    // Jobs run on several threads, so each thread has its own stack of tasks.
+    std::vector<state>& tasks() {
+        return tasks_[std::this_thread::get_id()];
+    }
+
+    std::mutex mtx_;
+    std::unordered_map<std::thread::id, std::vector<state>> tasks_;
     unsigned task_id_ = 0;
+
+    std::mutex commands_mtx_;
 };
 
 #ifdef CSCC_PORTABLE_MODE
@@ -84,14 +96,17 @@ config::config() : pimpl_(std::make_unique<impl>()) {
 config::~config() = default;
 
 void config::begin_task(std::string_view msg) const {
+    std::lock_guard lock(pimpl_->mtx_);
+
+    auto& tasks = pimpl_->tasks();
     auto const tid = ++pimpl_->task_id_;
     auto const time = std::chrono::high_resolution_clock::now();
 
-    pimpl_->tasks_.push_back({tid, time});
+    tasks.push_back({tid, time});
 
     if (this->verbose) {
         std::string spc;
-        for (size_t i = 1; i < pimpl_->tasks_.size(); i++) {
+        for (size_t i = 1; i < tasks.size(); i++) {
             spc += "  ";
         }
         fmt::print(stderr, "{}{:4d}: Start {}\n", spc, tid, msg);
@@ -100,37 +115,46 @@ void config::begin_task(std::string_view msg) const {
 
 void config::task_msg(std::string_view msg) const {
     if (this->verbose) {
+        std::lock_guard lock(pimpl_->mtx_);
+
+        auto const& tasks = pimpl_->tasks();
         std::string spc;
-        for (size_t i = 0; i < pimpl_->tasks_.size(); i++) {
+        for (size_t i = 0; i < tasks.size(); i++) {
             spc += "  ";
         }
-        fmt::print(stderr, "{}{:4d}:   {}\n", spc, task_id(), msg);
+        fmt::print(stderr, "{}{:4d}:   {}\n", spc, tasks.empty() ? 0 : tasks.back().id, msg);
     }
 }
 
 void config::end_task() const {
-    BOOST_ASSERT(!pimpl_->tasks_.empty());
+    std::lock_guard lock(pimpl_->mtx_);
+
+    auto& tasks = pimpl_->tasks();
+    BOOST_ASSERT(!tasks.empty());
 
     auto const t_end = std::chrono::high_resolution_clock::now();
-    auto const t_start = pimpl_->tasks_.back().start;
+    auto const [tid, t_start] = tasks.back();
 
     if (this->verbose) {
         std::string spc;
-        for (size_t i = 1; i < pimpl_->tasks_.size(); i++) {
+        for (size_t i = 1; i < tasks.size(); i++) {
             spc += "  ";
         }
-        fmt::print(stderr, "{}{:4d}: Finished in {:.2f} sec\n", spc, task_id(),
+        fmt::print(stderr, "{}{:4d}: Finished in {:.2f} sec\n", spc, tid,
                    delta_sec(t_start, t_end));
     }
 
-    pimpl_->tasks_.pop_back();
+    tasks.pop_back();
 }
 
 unsigned config::task_id() const {
-    if (pimpl_->tasks_.empty()) {
+    std::lock_guard lock(pimpl_->mtx_);
+
+    auto const& tasks = pimpl_->tasks();
+    if (tasks.empty()) {
         return 0;
     }
-    return pimpl_->tasks_.back().id;
+    return tasks.back().id;
 }
 
 boost::leaf::result<void> config::validate() {
@@ -167,10 +191,35 @@ boost::leaf::result<void> config::validate() {
         set_default_targets();
     }
 
+    set_default_cache();
+
     return {};
 }
 
+void config::set_default_cache() {
+    // The temporary files must be made every time, and vectorization reports are only printed
+    // by the compiler.
+    if (no_cache || save_temps || save_kernels || save_xmls || vec_report) {
+        cache_dir.clear();
+        return;
+    }
+
+    if (cache_dir.empty()) {
+        if (auto const* xdg = getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+            cache_dir = (std::filesystem::path(xdg) / "cscc").string();
+        } else if (auto const* home = getenv("HOME"); home && *home) {
+            cache_dir = (std::filesystem::path(home) / ".cache" / "cscc").string();
+        }
+    }
+
+    if (cache_size == 0) {
+        cache_size = UINT64_C(1) << 30;
+    }
+}
+
 boost::leaf::result<std::string const&> config::cc_for_kernel() const {
+    std::lock_guard lock(pimpl_->commands_mtx_);
+
     if (k_cc.empty()) {
         k_cc = IF_PORTABLE("__clang__", CMAKE_C_COMPILER);
     }
@@ -213,16 +262,22 @@ boost::leaf::result<std::string const&> config::cc_for_kernel() const {
 }
 
 boost::leaf::result<std::string const&> config::nvcc() const {
+    std::lock_guard lock(pimpl_->commands_mtx_);
+
     BOOST_LEAF_CHECK(ensure_executable(nvcc_, "/usr/local/cuda/bin"));
     return nvcc_;
 }
 
 boost::leaf::result<std::string const&> config::hipcc() const {
+    std::lock_guard lock(pimpl_->commands_mtx_);
+
     BOOST_LEAF_CHECK(ensure_executable(hipcc_, "/opt/rocm/bin"));
     return hipcc_;
 }
 
 boost::leaf::result<std::string const&> config::clang_format() const {
+    std::lock_guard lock(pimpl_->commands_mtx_);
+
     BOOST_LEAF_CHECK(ensure_executable(clang_format_));
     return clang_format_;
 }
@@ -239,12 +294,12 @@ boost::leaf::result<void> config::ensure_executable(std::string& command,
         return BOOST_LEAF_NEW_ERROR(config_error("command not found: {}", command));
     }
 
+    // Another job may be reading `command`, so it is only written when it changes.
     if (command != resolved) {
         task_msg(fmt::format("{} found: {}", command, resolved));
+        command = std::move(resolved);
     }
 
-    command = std::move(resolved);
-
     return {};
 }
 
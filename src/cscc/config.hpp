@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
 #include <string>
 #include <string_view>
@@ -89,6 +90,16 @@ struct config {
     bool save_xmls = false;
     bool make_executable = true;
 
+    // The number of jobs that run at the same time. 0 means that the jobserver of make decides,
+    // or 1 if there is none.
+    unsigned jobs = 0;
+
+    // The directory of the kernel cache, which is disabled if it is empty after validate(), and
+    // its size limit in bytes.
+    std::string cache_dir;
+    uint64_t cache_size = 0;
+    bool no_cache = false;
+
 #ifndef CSCC_PORTABLE_MODE
     std::string include_path_gen() const {
         return cscc_include_path_gen();
@@ -127,6 +138,7 @@ struct config {
     std::vector<std::string> libraries;
     std::vector<std::string> library_dirs;
     bool host_openmp = false;
+    bool vec_report = false;
 
     /* preprocessor options */
     bool md, mmd, mm, m;
@@ -160,6 +172,8 @@ private:
     std::unique_ptr<impl> pimpl_;
 
     void set_default_targets();
+
+    void set_default_cache();
 };
 
 std::string find_command(std::string_view cmd, std::string_view path = {});
@@ -7,23 +7,6 @@
 #include <utils/errors.hpp>
 #include <utils/io.hpp>
 
-namespace {
-
-template <class F>
-int try_handle_all(char const* argv0, F&& f) {
-    return boost::leaf::try_handle_all(
-        [&]() -> boost::leaf::result<int> {
-            return utils::io::try_handle_some(argv0, [&]() -> boost::leaf::result<int> {
-                return utils::errors::try_handle_some(argv0, f);
-            });
-        },
-        [&](boost::leaf::verbose_diagnostic_info const& diag) -> int {
-            utils::errors::report_and_exit(argv0, diag);
-        });
-}
-
-}  // namespace
-
 namespace boost {
 void assertion_failed(char const* expr, char const* function, char const* file, long line) {
     fmt::print(stderr, fg(fmt::color::red), "Assersion failed: {} at {}:{} in function '{}'\n",
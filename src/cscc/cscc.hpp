@@ -1,6 +1,27 @@
 #pragma once
 
+#include <ostream>
+#include <string>
+#include <vector>
 #include <boost/leaf.hpp>
+#include <utils/errors.hpp>
+#include <utils/io.hpp>
+#include <utils/target.hpp>
+#include <xcml_type.hpp>
+
+// Runs `f` and reports its error, if any, before exiting with 1.
+template <class F>
+int try_handle_all(char const* argv0, F&& f) {
+    return boost::leaf::try_handle_all(
+        [&]() -> boost::leaf::result<int> {
+            return utils::io::try_handle_some(argv0, [&]() -> boost::leaf::result<int> {
+                return utils::errors::try_handle_some(argv0, f);
+            });
+        },
+        [&](boost::leaf::verbose_diagnostic_info const& diag) -> int {
+            utils::errors::report_and_exit(argv0, diag);
+        });
+}
 
 boost::leaf::result<int> cscc_main(int argc, char** argv);
 int lower_main(int argc, char** argv);
@@ -9,6 +30,15 @@ int get_main(int argc, char** argv);
 int cback_main(int argc, char** argv);
 int bin2asm_main(int argc, char** argv);
 
+// In-process entry points of the stages, which pass programs without writing XML.
+int kext_program(std::string const& input, std::vector<std::string> const& args,
+                 std::ostream& desc, xcml::xcml_program_node_ptr& prg);
+std::vector<std::string> get_kernel_names(xcml::xcml_program_node_ptr const& prg);
+xcml::xcml_program_node_ptr lower_program(xcml::xcml_program_node_ptr prg,
+                                          utils::target target);
+void cback_program(xcml::xcml_program_node_ptr const& prg, utils::target target,
+                   std::ostream& os);
+
 #ifdef CSCC_PORTABLE_MODE
 
 #    if defined(__GNUC__) && !defined(__clang__)
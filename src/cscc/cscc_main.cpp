@@ -1,7 +1,12 @@
+#include <algorithm>
+#include <memory>
+#include <optional>
 #include <utils/errors.hpp>
 #include <charm/sycl/config.hpp>
+#include "cache.hpp"
 #include "config.hpp"
 #include "cscc.hpp"
+#include "jobs.hpp"
 #include "parse_args.hpp"
 #include "task.hpp"
 
@@ -29,27 +34,76 @@ namespace {
 // }
 
 struct workflow {
-    explicit workflow(config const& cfg) : cfg_(cfg) {}
+    explicit workflow(config const& cfg) : cfg_(cfg), cache_(cfg) {}
 
     [[nodiscard]] result<void> run() {
-        std::vector<io::file> objects;
+        job_graph graph;
+        std::vector<std::vector<io::file>> objects(cfg_.inputs.size());
 
-        for (auto const& input : cfg_.inputs) {
-            auto input_file = BOOST_LEAF_CHECK(io::file::readonly(input));
+        for (size_t i = 0; i < cfg_.inputs.size(); i++) {
+            auto input_file = BOOST_LEAF_CHECK(io::file::readonly(cfg_.inputs[i]));
 
-            BOOST_LEAF_CHECK(process_input(objects, std::move(input_file)));
+            BOOST_LEAF_CHECK(process_input(graph, objects[i], std::move(input_file)));
         }
 
-        BOOST_LEAF_CHECK(link_objects(objects));
+        job_slots slots(cfg_.jobs);
+        graph.run(slots);
+        cache_.report();
+
+        for (auto const& in : sycl_inputs_) {
+            in->objs->push_back(std::move(*in->host_obj));
+            for (auto& branch_objs : in->kernel_objs) {
+                for (auto& obj : branch_objs) {
+                    in->objs->push_back(std::move(obj));
+                }
+            }
+
+            cpu_symbols_.insert(cpu_symbols_.end(), in->symbols.begin(), in->symbols.end());
+        }
+
+        // The objects are linked in the order of the inputs, whichever job finished first.
+        std::vector<io::file> objs;
+        for (auto& input_objs : objects) {
+            for (auto& obj : input_objs) {
+                objs.push_back(std::move(obj));
+            }
+        }
+
+        BOOST_LEAF_CHECK(link_objects(objs));
 
         return {};
     }
 
 private:
-    [[nodiscard]] result<void> process_input(std::vector<io::file>& objs,
+    // The state of a SYCL source shared by the jobs that compile it.
+    struct sycl_input {
+        sycl_input(io::file&& f, std::vector<io::file>& o) : input(std::move(f)), objs(&o) {}
+
+        io::file input;
+        std::vector<io::file>* objs;
+        std::optional<io::file> dev_cpp;
+        std::string kext_key;
+        program_map prgs;
+        std::optional<io::file> desc;
+        std::vector<std::string> symbols;
+        std::optional<io::file> host_obj;
+
+        // The generated source of each target and the objects of each kernel branch.
+        std::vector<std::optional<io::file>> kernel_srcs;
+        std::vector<std::vector<io::file>> kernel_objs;
+    };
+
+    // A target may be compiled by several independent jobs, each of which is a branch.
+    struct kernel_branch {
+        u::target target;
+        size_t src_index;
+        cudafmt fmt;
+    };
+
+    [[nodiscard]] result<void> process_input(job_graph& graph, std::vector<io::file>& objs,
                                              io::file&& input_file) {
         if (input_file.ext() == ".cpp" || input_file.ext() == ".cc") {
-            BOOST_LEAF_CHECK(process_sycl_input(objs, input_file));
+            add_sycl_input(graph, objs, std::move(input_file));
             return {};
         }
 
@@ -72,26 +126,172 @@ private:
             option_error("Not supported input file: {}", input_file.filename()));
     }
 
-    [[nodiscard]] result<void> process_sycl_input(std::vector<io::file>& objs,
-                                                  io::file const& input_file) {
-        auto const dev_cpp = BOOST_LEAF_CHECK(run_cpp(cfg_, input_file, nullptr, false));
+    // Adds the jobs that compile a SYCL source. The host code and each target are independent
+    // branches after kext, and CUDA kernels are compiled to the two formats in parallel.
+    void add_sycl_input(job_graph& graph, std::vector<io::file>& objs, io::file&& input_file) {
+        auto& in = *sycl_inputs_.emplace_back(
+            std::make_unique<sycl_input>(std::move(input_file), objs));
+
+        std::vector<u::target> targets;
+        for (auto const t : cfg_.targets) {
+            if (std::find(targets.begin(), targets.end(), t) == targets.end()) {
+                targets.push_back(t);
+            }
+        }
+
+        std::vector<kernel_branch> branches;
+        for (size_t i = 0; i < targets.size(); i++) {
+            if (is_cuda(targets[i])) {
+                auto const fmt = cfg_.cuda_arch.empty() ? cudafmt::PTX : cudafmt::CUBIN;
+                branches.push_back({targets[i], i, cudafmt::FATBIN});
+                branches.push_back({targets[i], i, fmt});
+            } else {
+                branches.push_back({targets[i], i, cudafmt::OBJECT});
+            }
+        }
+
+        in.kernel_srcs.resize(targets.size());
+        in.kernel_objs.resize(branches.size());
+
+        auto const cpp = graph.add([&]() -> result<void> {
+            in.dev_cpp = BOOST_LEAF_CHECK(run_cpp(cfg_, in.input, nullptr, false));
+            return {};
+        });
 
-        auto const [kernel_xmls, kernel_desc] =
-            BOOST_LEAF_CHECK(run_kext(cfg_, dev_cpp, cpu_symbols_));
-        auto const lower_xmls = BOOST_LEAF_CHECK(run_lower(cfg_, kernel_xmls));
+        auto const kext = graph.add(
+            [&, targets]() -> result<void> {
+                if (cache_.enabled()) {
+                    in.kext_key = BOOST_LEAF_CHECK(cache_.kext_key(*in.dev_cpp));
 
-        auto const kernel_srcs = BOOST_LEAF_CHECK(run_cback(cfg_, lower_xmls));
+                    if (BOOST_LEAF_CHECK(load_cached_kernels(in, targets))) {
+                        return {};
+                    }
+                }
 
-        auto kernel_objs = BOOST_LEAF_CHECK(compile_kernel(kernel_srcs));
+                auto [prgs, desc] = BOOST_LEAF_CHECK(run_kext(cfg_, *in.dev_cpp, in.symbols));
+                in.prgs = std::move(prgs);
+                in.desc = std::move(desc);
 
-        auto host_cpp = BOOST_LEAF_CHECK(run_cpp(cfg_, input_file, &kernel_desc, true));
-        auto host_obj = BOOST_LEAF_CHECK(compile_host(cfg_, host_cpp, false, false));
+                if (cache_.enabled()) {
+                    BOOST_LEAF_CHECK(store_kext(in));
+                }
+                return {};
+            },
+            {cpp});
+
+        graph.add(
+            [&]() -> result<void> {
+                in.host_obj = BOOST_LEAF_CHECK(compile_sycl_host(cfg_, in.input, *in.desc));
+                return {};
+            },
+            {kext});
+
+        std::vector<job_graph::job_id> gens;
+        for (size_t i = 0; i < targets.size(); i++) {
+            gens.push_back(graph.add(
+                [&, i, target = targets[i]]() -> result<void> {
+                    auto const it = in.prgs.find(target);
+                    if (in.kernel_srcs[i] || it == in.prgs.end()) {
+                        return {};
+                    }
+
+                    auto const prg = BOOST_LEAF_CHECK(run_lower(cfg_, target, it->second));
+                    in.kernel_srcs[i] = BOOST_LEAF_CHECK(run_cback(cfg_, target, prg));
+
+                    if (cache_.enabled()) {
+                        cache_.store(cache_.source_key(in.kext_key, target),
+                                     {&*in.kernel_srcs[i]});
+                    }
+                    return {};
+                },
+                {kext}));
+        }
 
-        objs.push_back(std::move(host_obj));
-        for (auto& pair : kernel_objs) {
-            objs.push_back(std::move(pair.second));
+        for (size_t i = 0; i < branches.size(); i++) {
+            graph.add(
+                [&, i, branch = branches[i]]() -> result<void> {
+                    auto const& src = in.kernel_srcs[branch.src_index];
+                    if (!src) {
+                        return {};
+                    }
+
+                    std::string key;
+                    if (cache_.enabled()) {
+                        key = BOOST_LEAF_CHECK(cache_.object_key(*src, in.input.filename(),
+                                                                 branch.target, branch.fmt));
+
+                        auto const n = is_cpu(branch.target) ? 1 : 2;
+                        if (BOOST_LEAF_CHECK(cache_.load(key, n, in.kernel_objs[i]))) {
+                            return {};
+                        }
+                    }
+
+                    in.kernel_objs[i] = BOOST_LEAF_CHECK(compile_kernel(branch, *src));
+
+                    if (cache_.enabled()) {
+                        std::vector<io::file const*> objs;
+                        for (auto const& obj : in.kernel_objs[i]) {
+                            objs.push_back(&obj);
+                        }
+                        cache_.store(key, objs);
+                    }
+                    return {};
+                },
+                {gens[branches[i].src_index]});
         }
+    }
 
+    // Takes the output of kext and the kernel sources of all the targets from the cache.
+    // Nothing is taken unless all of them are found, since the sources are generated from the
+    // output of kext that is not cached.
+    [[nodiscard]] result<bool> load_cached_kernels(sycl_input& in,
+                                                   std::vector<u::target> const& targets) {
+        std::vector<io::file> files;
+        if (!BOOST_LEAF_CHECK(cache_.load(in.kext_key, 3, files))) {
+            return false;
+        }
+
+        auto const symbols = BOOST_LEAF_CHECK(files[1].read_all_str());
+        auto const has_kernels = BOOST_LEAF_CHECK(files[2].read_all_str()) == "1";
+
+        std::vector<std::optional<io::file>> srcs(targets.size());
+        for (size_t i = 0; has_kernels && i < targets.size(); i++) {
+            auto const key = cache_.source_key(in.kext_key, targets[i]);
+
+            std::vector<io::file> src;
+            if (!BOOST_LEAF_CHECK(cache_.load(key, 1, src))) {
+                return false;
+            }
+            srcs[i] = std::move(src.front());
+        }
+
+        in.desc = std::move(files[0]);
+        in.kernel_srcs = std::move(srcs);
+
+        for (size_t pos = 0; pos < symbols.size();) {
+            auto const end = std::min(symbols.find('\n', pos), symbols.size());
+            in.symbols.push_back(symbols.substr(pos, end - pos));
+            pos = end + 1;
+        }
+
+        return true;
+    }
+
+    // Stores the descriptor header, the names of the kernels, and whether there are kernels.
+    [[nodiscard]] result<void> store_kext(sycl_input const& in) {
+        std::string symbols;
+        for (auto const& sym : in.symbols) {
+            symbols += sym;
+            symbols += '\n';
+        }
+
+        auto symbols_file = BOOST_LEAF_CHECK(io::file::mktemp(".txt"));
+        BOOST_LEAF_CHECK(symbols_file.write_str(0, symbols));
+
+        auto kernels_file = BOOST_LEAF_CHECK(io::file::mktemp(".txt"));
+        BOOST_LEAF_CHECK(kernels_file.write_str(0, in.prgs.empty() ? "0" : "1"));
+
+        cache_.store(in.kext_key, {&*in.desc, &symbols_file, &kernels_file});
         return {};
     }
 
@@ -110,63 +310,51 @@ private:
         return obj_file;
     }
 
-    [[nodiscard]] result<file_map> compile_kernel(file_map const& input_files) const {
-        file_map outs;
+    [[nodiscard]] result<std::vector<io::file>> compile_kernel(kernel_branch const& branch,
+                                                               io::file const& input) const {
+        std::vector<io::file> outs;
 
-        for (auto const& [target, input] : input_files) {
-            switch (target) {
-                case u::target::NONE:
-                    break;
+        switch (branch.target) {
+            case u::target::NONE:
+                break;
 
-                case u::target::CPU_C:
-                case u::target::CPU_OPENMP: {
-                    auto obj = BOOST_LEAF_CHECK(compile_kernel_cc(cfg_, input, target));
-                    auto marked = BOOST_LEAF_CHECK(make_marked_object(cfg_, obj, {target}));
-                    outs.emplace(target, std::move(marked));
-                    continue;
-                }
+            case u::target::CPU_C:
+            case u::target::CPU_OPENMP: {
+                auto obj = BOOST_LEAF_CHECK(compile_kernel_cc(cfg_, input, branch.target));
+                auto marked = BOOST_LEAF_CHECK(make_marked_object(cfg_, obj, {branch.target}));
+                outs.push_back(std::move(marked));
+                return outs;
+            }
 
-                case u::target::NVIDIA_CUDA: {
-                    std::string prefix;
-
-                    auto fatbin =
-                        BOOST_LEAF_CHECK(compile_kernel_cuda(cfg_, input, cudafmt::FATBIN));
-                    auto fatbin_obj = BOOST_LEAF_CHECK(embed_file(fatbin, prefix));
-                    fatbin_obj =
-                        BOOST_LEAF_CHECK(make_marked_object(cfg_, fatbin_obj, {target}));
-                    auto fatbin_c =
-                        BOOST_LEAF_CHECK(make_binary_loader(fatbin_obj, prefix, "_FATBIN_"));
-                    outs.emplace(target, std::move(fatbin_obj));
-                    outs.emplace(target, std::move(fatbin_c));
-
-                    auto const fmt = cfg_.cuda_arch.empty() ? cudafmt::PTX : cudafmt::CUBIN;
-
-                    auto ptx = BOOST_LEAF_CHECK(compile_kernel_cuda(cfg_, input, fmt));
-                    auto ptx_obj = BOOST_LEAF_CHECK(embed_file(ptx, prefix));
-                    ptx_obj = BOOST_LEAF_CHECK(make_marked_object(cfg_, ptx_obj, {target}));
-                    auto ptx_c = BOOST_LEAF_CHECK(make_binary_loader(ptx_obj, prefix, "_PTX_"));
-                    outs.emplace(target, std::move(ptx_obj));
-                    outs.emplace(target, std::move(ptx_c));
-                    continue;
-                }
+            case u::target::NVIDIA_CUDA: {
+                std::string prefix;
 
-                case u::target::AMD_HIP: {
-                    std::string prefix;
-
-                    auto hsaco = BOOST_LEAF_CHECK(compile_kernel_hipcc(cfg_, input));
-                    auto hsaco_obj = BOOST_LEAF_CHECK(embed_file(hsaco, prefix));
-                    hsaco_obj = BOOST_LEAF_CHECK(make_marked_object(cfg_, hsaco_obj, {target}));
-                    auto hsaco_c =
-                        BOOST_LEAF_CHECK(make_binary_loader(hsaco_obj, prefix, "_HSACO_"));
-                    outs.emplace(target, std::move(hsaco_obj));
-                    outs.emplace(target, std::move(hsaco_c));
-                    continue;
-                }
+                auto const kind = branch.fmt == cudafmt::FATBIN ? "_FATBIN_" : "_PTX_";
+
+                auto bin = BOOST_LEAF_CHECK(compile_kernel_cuda(cfg_, input, branch.fmt));
+                auto bin_obj = BOOST_LEAF_CHECK(embed_file(bin, prefix));
+                bin_obj = BOOST_LEAF_CHECK(make_marked_object(cfg_, bin_obj, {branch.target}));
+                auto bin_c = BOOST_LEAF_CHECK(make_binary_loader(bin_obj, prefix, kind));
+                outs.push_back(std::move(bin_obj));
+                outs.push_back(std::move(bin_c));
+                return outs;
             }
-            std::terminate();
-        }
 
-        return outs;
+            case u::target::AMD_HIP: {
+                std::string prefix;
+
+                auto hsaco = BOOST_LEAF_CHECK(compile_kernel_hipcc(cfg_, input));
+                auto hsaco_obj = BOOST_LEAF_CHECK(embed_file(hsaco, prefix));
+                hsaco_obj =
+                    BOOST_LEAF_CHECK(make_marked_object(cfg_, hsaco_obj, {branch.target}));
+                auto hsaco_c =
+                    BOOST_LEAF_CHECK(make_binary_loader(hsaco_obj, prefix, "_HSACO_"));
+                outs.push_back(std::move(hsaco_obj));
+                outs.push_back(std::move(hsaco_c));
+                return outs;
+            }
+        }
+        std::terminate();
     }
 
     [[nodiscard]] result<void> link_objects(std::vector<io::file>& objs) const {
@@ -183,6 +371,8 @@ private:
         return {};
     }
 
+    kernel_cache cache_;
+    std::vector<std::unique_ptr<sycl_input>> sycl_inputs_;
     std::vector<std::string> cpu_symbols_;
 
     bool targets_openmp() const {
@@ -0,0 +1,338 @@
+#include "jobs.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <boost/assert.hpp>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include "cscc.hpp"
+
+namespace {
+
+bool parse_fd(std::string_view str, int& fd) {
+    auto const [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), fd);
+    return ec == std::errc() && ptr == str.data() + str.size() && fd >= 0;
+}
+
+bool is_open(int fd) {
+    return ::fcntl(fd, F_GETFD) != -1;
+}
+
+}  // namespace
+
+job_slots::job_slots(unsigned n) {
+    if (n > 0) {
+        n_ = n;
+        free_ = n;
+        return;
+    }
+
+    // There is always one slot, which make gives to cscc itself when it runs it.
+    n_ = 1;
+    free_ = 1;
+
+    if (open_jobserver()) {
+        n_ = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+job_slots::~job_slots() {
+    if (wake_[0] != -1) {
+        ::close(wake_[0]);
+        ::close(wake_[1]);
+    }
+    if (close_fds_) {
+        ::close(rfd_);
+    }
+}
+
+bool job_slots::open_jobserver() {
+    auto const* flags = getenv("MAKEFLAGS");
+    if (!flags) {
+        return false;
+    }
+
+    // The last --jobserver-auth=R,W (or --jobserver-fds=R,W before make 4.2), or
+    // --jobserver-auth=fifo:PATH since make 4.4.
+    std::string_view auth;
+    for (auto rest = std::string_view(flags); !rest.empty();) {
+        auto const sp = rest.find(' ');
+        auto const word = rest.substr(0, sp);
+        rest = sp == std::string_view::npos ? std::string_view() : rest.substr(sp + 1);
+
+        for (std::string_view prefix : {"--jobserver-auth=", "--jobserver-fds="}) {
+            if (word.starts_with(prefix)) {
+                auth = word.substr(prefix.size());
+            }
+        }
+    }
+
+    if (auth.empty()) {
+        return false;
+    }
+
+    if (auth.starts_with("fifo:")) {
+        auto const path = std::string(auth.substr(5));
+
+        // The FIFO is opened by cscc itself, so it can be made non-blocking.
+        rfd_ = ::open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (rfd_ == -1) {
+            return false;
+        }
+        wfd_ = rfd_;
+        close_fds_ = true;
+    } else {
+        auto const comma = auth.find(',');
+        if (comma == std::string_view::npos) {
+            return false;
+        }
+
+        int rfd, wfd;
+        if (!parse_fd(auth.substr(0, comma), rfd) || !parse_fd(auth.substr(comma + 1), wfd)) {
+            return false;
+        }
+
+        // make closes the pipe for the commands that it does not consider recursive.
+        if (!is_open(rfd) || !is_open(wfd)) {
+            return false;
+        }
+        rfd_ = rfd;
+        wfd_ = wfd;
+    }
+
+    if (::pipe2(wake_, O_NONBLOCK | O_CLOEXEC) == -1) {
+        if (close_fds_) {
+            ::close(rfd_);
+            close_fds_ = false;
+        }
+        rfd_ = wfd_ = -1;
+        return false;
+    }
+
+    return true;
+}
+
+unsigned job_slots::size() const {
+    return n_;
+}
+
+job_slots::token job_slots::acquire() {
+    std::unique_lock lock(mtx_);
+
+    if (rfd_ == -1 || free_ > 0) {
+        cv_.wait(lock, [&] {
+            return free_ > 0;
+        });
+        free_--;
+        return {true, 0};
+    }
+
+    // Waits for a token from make or for the implicit slot, whichever comes first. release()
+    // writes to wake_ when the implicit slot becomes free.
+    waiting_++;
+    lock.unlock();
+
+    for (;;) {
+        pollfd fds[2] = {{rfd_, POLLIN, 0}, {wake_[0], POLLIN, 0}};
+
+        if (::poll(fds, 2, -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            char c;
+            [[maybe_unused]] auto const n = ::read(wake_[0], &c, 1);
+
+            lock.lock();
+            if (free_ > 0) {
+                free_--;
+                waiting_--;
+                return {true, 0};
+            }
+            lock.unlock();
+        }
+
+        if (fds[0].revents & (POLLERR | POLLNVAL)) {
+            break;
+        }
+
+        if (fds[0].revents & (POLLIN | POLLHUP)) {
+            // With a pipe shared with other processes, another process may take the token
+            // first, and then this blocks until the next one.
+            char c;
+            auto const n = ::read(rfd_, &c, 1);
+
+            if (n == 1) {
+                lock.lock();
+                waiting_--;
+                return {false, c};
+            }
+
+            if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
+                break;
+            }
+        }
+    }
+
+    // The jobserver is gone. Only the implicit slot is left.
+    lock.lock();
+    waiting_--;
+    cv_.wait(lock, [&] {
+        return free_ > 0;
+    });
+    free_--;
+    return {true, 0};
+}
+
+void job_slots::release(token t) {
+    if (t.implicit) {
+        std::lock_guard lock(mtx_);
+
+        free_++;
+        if (waiting_ > 0) {
+            char const c = 0;
+            [[maybe_unused]] auto const n = ::write(wake_[1], &c, 1);
+        }
+        cv_.notify_one();
+        return;
+    }
+
+    for (;;) {
+        auto const n = ::write(wfd_, &t.value, 1);
+
+        if (n == 1) {
+            return;
+        }
+
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+
+        if (n == -1 && errno == EAGAIN) {
+            pollfd fd = {wfd_, POLLOUT, 0};
+            ::poll(&fd, 1, -1);
+            continue;
+        }
+
+        return;
+    }
+}
+
+job_graph::job_id job_graph::add(job_fn fn, std::vector<job_id> const& deps) {
+    auto const id = jobs_.size();
+
+    for (auto const dep : deps) {
+        BOOST_ASSERT(dep < id);
+        jobs_[dep].succs.push_back(id);
+    }
+
+    jobs_.push_back({std::move(fn), {}, deps.size()});
+
+    return id;
+}
+
+void job_graph::run_job(job_id id) {
+    try_handle_all("cscc", [&]() -> boost::leaf::result<int> {
+        auto res = jobs_[id].fn();
+
+        if (!res) {
+            // The first failure is reported and exits. The other failures wait for it, since
+            // the reports would be mixed up and exit() is not thread-safe.
+            static auto* const failure = new std::mutex;
+            failure->lock();
+
+            return res.error();
+        }
+
+        return 0;
+    });
+}
+
+void job_graph::run(job_slots& slots) {
+    std::deque<job_id> ready;
+
+    for (job_id id = 0; id < jobs_.size(); id++) {
+        if (jobs_[id].n_deps == 0) {
+            ready.push_back(id);
+        }
+    }
+
+    auto const n_threads = std::min<size_t>(slots.size(), jobs_.size());
+
+    if (n_threads <= 1) {
+        while (!ready.empty()) {
+            auto const id = ready.front();
+            ready.pop_front();
+
+            auto const t = slots.acquire();
+            run_job(id);
+            slots.release(t);
+
+            for (auto const succ : jobs_[id].succs) {
+                if (--jobs_[succ].n_deps == 0) {
+                    ready.push_back(succ);
+                }
+            }
+        }
+
+        return;
+    }
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    size_t n_finished = 0;
+
+    auto const worker = [&] {
+        std::unique_lock lock(mtx);
+
+        for (;;) {
+            cv.wait(lock, [&] {
+                return !ready.empty() || n_finished == jobs_.size();
+            });
+
+            if (ready.empty()) {
+                return;
+            }
+
+            auto const id = ready.front();
+            ready.pop_front();
+
+            lock.unlock();
+
+            auto const t = slots.acquire();
+            run_job(id);
+            slots.release(t);
+
+            lock.lock();
+
+            n_finished++;
+            for (auto const succ : jobs_[id].succs) {
+                if (--jobs_[succ].n_deps == 0) {
+                    ready.push_back(succ);
+                }
+            }
+
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < n_threads; i++) {
+        threads.emplace_back(worker);
+    }
+
+    worker();
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include <boost/leaf/result.hpp>
+
+// Limits the number of jobs that run at the same time. Under `make -jN`, the slots are the
+// tokens of the jobserver of make, so that cscc and make together run at most N jobs.
+struct job_slots {
+    struct token {
+        bool implicit;
+        char value;
+    };
+
+    // `n` is the number of slots. If it is 0, the slots are taken from the jobserver given by
+    // MAKEFLAGS, or there is a single slot if there is no jobserver.
+    explicit job_slots(unsigned n);
+
+    job_slots(job_slots const&) = delete;
+
+    job_slots(job_slots&&) = delete;
+
+    job_slots& operator=(job_slots const&) = delete;
+
+    job_slots& operator=(job_slots&&) = delete;
+
+    ~job_slots();
+
+    // The number of threads that are worth running.
+    unsigned size() const;
+
+    // Blocks until a slot is free.
+    token acquire();
+
+    void release(token t);
+
+private:
+    bool open_jobserver();
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    unsigned n_ = 1;
+    unsigned free_ = 1;
+    unsigned waiting_ = 0;
+    int rfd_ = -1;
+    int wfd_ = -1;
+    bool close_fds_ = false;
+    int wake_[2] = {-1, -1};
+};
+
+// A set of jobs and their dependencies. A job starts after all the jobs that it depends on
+// have finished.
+struct job_graph {
+    using job_id = size_t;
+    using job_fn = std::function<boost::leaf::result<void>()>;
+
+    // `deps` must be jobs that have already been added.
+    job_id add(job_fn fn, std::vector<job_id> const& deps = {});
+
+    // Runs all the jobs. If a job fails, its error is reported and cscc exits.
+    void run(job_slots& slots);
+
+private:
+    struct job {
+        job_fn fn;
+        std::vector<job_id> succs;
+        size_t n_deps;
+    };
+
+    void run_job(job_id id);
+
+    std::vector<job> jobs_;
+};
@@ -1,4 +1,10 @@
 #include "parse_args.hpp"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
 #include <utils/io.hpp>
 #include <utils/target.hpp>
 #include "config.hpp"
@@ -22,6 +28,49 @@ bool has_next_arg(int i, int argc) {
     return argv[i];
 }
 
+[[nodiscard]] boost::leaf::result<unsigned> parse_jobs(std::string_view val) {
+    if (val.empty()) {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    unsigned n = 0;
+    auto const [ptr, ec] = std::from_chars(val.data(), val.data() + val.size(), n);
+
+    if (ec != std::errc() || ptr != val.data() + val.size() || n == 0) {
+        return BOOST_LEAF_NEW_ERROR(option_error("invalid -j value: {}", val));
+    }
+    return n;
+}
+
+// A number of bytes with an optional suffix K, M or G.
+[[nodiscard]] boost::leaf::result<uint64_t> parse_size(std::string_view val) {
+    uint64_t n = 0;
+    auto const [ptr, ec] = std::from_chars(val.data(), val.data() + val.size(), n);
+    auto const suffix = val.substr(ptr - val.data());
+    int shift = -1;
+
+    if (suffix.empty()) {
+        shift = 0;
+    } else if (suffix.size() == 1) {
+        switch (std::toupper(static_cast<unsigned char>(suffix.front()))) {
+            case 'K':
+                shift = 10;
+                break;
+            case 'M':
+                shift = 20;
+                break;
+            case 'G':
+                shift = 30;
+                break;
+        }
+    }
+
+    if (ec != std::errc() || shift < 0 || n == 0 || n > (UINT64_MAX >> shift)) {
+        return BOOST_LEAF_NEW_ERROR(option_error("invalid cache size: {}", val));
+    }
+    return n << shift;
+}
+
 }  // namespace
 
 #define SHORT_OPT(name)              \
@@ -57,6 +106,14 @@ bool has_next_arg(int i, int argc) {
             (matched = true))
 
 boost::leaf::result<void> parse_args(int argc, char** argv, config& cfg) {
+    if (auto const* val = getenv("CSCC_CACHE_DIR"); val && *val) {
+        cfg.cache_dir = val;
+    }
+
+    if (auto const* val = getenv("CSCC_CACHE_SIZE"); val && *val) {
+        cfg.cache_size = BOOST_LEAF_CHECK(parse_size(val));
+    }
+
     for (int i = 1; i < argc; i++) {
         auto const arg = sv(argv[i]);
         bool matched = false;
@@ -185,6 +242,36 @@ boost::leaf::result<void> parse_args(int argc, char** argv, config& cfg) {
         SHORT_OPT("fopenmp") {
             cfg.host_openmp = true;
         }
+        LONG_OPT("vec-report") {
+            cfg.vec_report = true;
+        }
+        LONG_OPT_VAL("jobs") {
+            cfg.jobs = BOOST_LEAF_CHECK(parse_jobs(optval));
+        }
+        SHORT_OPT("j") {
+            // Like make, -j takes the next argument only if it is a number.
+            auto const next = has_next_arg(i, argc) ? sv(argv[i + 1]) : std::string_view();
+
+            if (!next.empty() && std::all_of(next.begin(), next.end(), ::isdigit)) {
+                i++;
+                cfg.jobs = BOOST_LEAF_CHECK(parse_jobs(next));
+            } else {
+                cfg.jobs = BOOST_LEAF_CHECK(parse_jobs({}));
+            }
+        }
+        LONG_OPT_VAL("cache-dir") {
+            cfg.cache_dir = optval;
+        }
+        LONG_OPT_VAL("cache-size") {
+            cfg.cache_size = BOOST_LEAF_CHECK(parse_size(optval));
+        }
+        LONG_OPT("no-cache") {
+            cfg.no_cache = true;
+        }
+        if (!matched && arg.starts_with("-j")) {
+            cfg.jobs = BOOST_LEAF_CHECK(parse_jobs(arg.substr(2)));
+            matched = true;
+        }
 
         if (matched) {
             continue;
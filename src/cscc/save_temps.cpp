@@ -1,18 +1,21 @@
 #include <fmt/format.h>
 #include <utils/io.hpp>
 #include <utils/target.hpp>
+#include <xcml_utils.hpp>
 #include "config.hpp"
 #include "task.hpp"
 
 namespace io = utils::io;
 using boost::leaf::result;
 
+bool is_saved(config const& cfg, filetype type) {
+    return cfg.save_temps || (cfg.save_kernels && type == filetype::kernel) ||
+           (cfg.save_xmls && type == filetype::xml);
+}
+
 result<void> save_temps_impl(config const& cfg, io::file& f, std::string const& outfile,
                              filetype type) {
-    auto const do_save = cfg.save_temps || (cfg.save_kernels && type == filetype::kernel) ||
-                         (cfg.save_xmls && type == filetype::xml);
-
-    if (!do_save) {
+    if (!is_saved(cfg, type)) {
         return {};
     }
 
@@ -46,3 +49,31 @@ result<void> save_temps(config const& cfg, io::file& f, std::string_view ext, ut
         fmt::format("{}.{}.{}{}", trim_ext(cfg.output), cfg.task_id(), utils::show(t), ext),
         type);
 }
+
+// The stages pass programs in memory, so a program is written only when it is to be kept.
+result<void> save_xml_impl(config const& cfg, xcml::xcml_program_node_ptr const& prg,
+                           std::string const& outfile) {
+    if (!prg || !is_saved(cfg, filetype::xml)) {
+        return {};
+    }
+
+    cfg.task_msg(fmt::format("save_temps: write to {}", outfile));
+
+    // Creates the file first so that an error is reported the same way as save_temps().
+    BOOST_LEAF_CHECK(io::file::create(outfile));
+    xcml::write_xml(outfile, xcml::prg_to_xml(prg));
+
+    return {};
+}
+
+result<void> save_xml(config const& cfg, xcml::xcml_program_node_ptr const& prg) {
+    return save_xml_impl(cfg, prg,
+                         fmt::format("{}.{}.xml", trim_ext(cfg.output), cfg.task_id()));
+}
+
+result<void> save_xml(config const& cfg, xcml::xcml_program_node_ptr const& prg,
+                      utils::target t) {
+    return save_xml_impl(
+        cfg, prg,
+        fmt::format("{}.{}.{}.xml", trim_ext(cfg.output), cfg.task_id(), utils::show(t)));
+}
@@ -8,6 +8,7 @@
 #include <boost/leaf/result.hpp>
 #include <utils/io.hpp>
 #include <utils/target.hpp>
+#include <xcml_type.hpp>
 
 struct config;
 
@@ -33,6 +34,8 @@ double delta_sec(Timepoint const& begin, Timepoint const& end) {
 
 enum class filetype { kernel, xml, other };
 
+bool is_saved(config const& cfg, filetype type);
+
 [[nodiscard]] boost::leaf::result<void> save_temps(config const& cfg, utils::io::file& f,
                                                    filetype type);
 
@@ -46,6 +49,13 @@ enum class filetype { kernel, xml, other };
                                                    std::string_view ext, utils::target t,
                                                    filetype type);
 
+[[nodiscard]] boost::leaf::result<void> save_xml(config const& cfg,
+                                                 xcml::xcml_program_node_ptr const& prg);
+
+[[nodiscard]] boost::leaf::result<void> save_xml(config const& cfg,
+                                                 xcml::xcml_program_node_ptr const& prg,
+                                                 utils::target t);
+
 [[nodiscard]] boost::leaf::result<bool> is_marked_object(utils::io::file const& file);
 
 [[nodiscard]] boost::leaf::result<std::vector<utils::target>> targets_from_object(
@@ -74,6 +84,11 @@ enum class filetype { kernel, xml, other };
                                                                 utils::io::file const& input,
                                                                 bool cc_mode, bool pic);
 
+// Compiles the host code of a SYCL source, which is not preprocessed, with the descriptor of
+// its kernels.
+[[nodiscard]] boost::leaf::result<utils::io::file> compile_sycl_host(
+    config const& cfg, utils::io::file const& input, utils::io::file const& desc_file);
+
 [[nodiscard]] boost::leaf::result<utils::io::file> compile_kernel_cc(
     config const& cfg, utils::io::file const& input, utils::target target);
 
@@ -102,13 +117,14 @@ enum class cudafmt { OBJECT, FATBIN, PTX, CUBIN };
 [[nodiscard]] boost::leaf::result<utils::io::file> run_clang_format(
     utils::io::file const& input);
 
-using file_map = std::unordered_multimap<utils::target, utils::io::file>;
 
-[[nodiscard]] boost::leaf::result<std::pair<file_map, utils::io::file>> run_kext(
+using program_map = std::unordered_multimap<utils::target, xcml::xcml_program_node_ptr>;
+
+[[nodiscard]] boost::leaf::result<std::pair<program_map, utils::io::file>> run_kext(
     config const& cfg, utils::io::file const& input_file, std::vector<std::string>& symbols);
 
-[[nodiscard]] boost::leaf::result<file_map> run_lower(config const& cfg,
-                                                      file_map const& input_files);
+[[nodiscard]] boost::leaf::result<xcml::xcml_program_node_ptr> run_lower(
+    config const& cfg, utils::target target, xcml::xcml_program_node_ptr const& input);
 
-[[nodiscard]] boost::leaf::result<file_map> run_cback(config const& cfg,
-                                                      file_map const& input_files);
+[[nodiscard]] boost::leaf::result<utils::io::file> run_cback(
+    config const& cfg, utils::target target, xcml::xcml_program_node_ptr const& input);
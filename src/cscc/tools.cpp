@@ -1,6 +1,13 @@
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <mutex>
 #include <boost/assert.hpp>
+#include <fmt/format.h>
 #include <utils/io.hpp>
+#include <xcml_utils.hpp>
 #include "config.hpp"
+#include "cscc.hpp"
 #include "task.hpp"
 
 namespace io = utils::io;
@@ -26,33 +33,57 @@ std::string kernel_ext(utils::target t) {
     std::terminate();
 }
 
-[[nodiscard]] result<void> collect_symbols(config const& cfg, io::file const& input,
-                                           std::vector<std::string>& symbols) {
-    cfg.begin_task("Collect Kernel Symbols");
+// Runs a stage of the kernel compiler in this process. `fn` returns false or throws on failure,
+// which is reported as if the stage had been run by run_self() and exited with 1.
+template <class F>
+[[nodiscard]] result<void> run_stage(config const& cfg, char const* name, F&& fn) {
+    if (cfg.verbose) {
+        cfg.task_msg(fmt::format("$ {} (in-process)", name));
+    }
 
-    auto out = BOOST_LEAF_CHECK(io::file::mktemp(".txt"));
+    try {
+        if (fn()) {
+            return {};
+        }
+    } catch (std::exception const& e) {
+        fmt::print(stderr, "{}: {}\n", name, e.what());
+    }
 
-    BOOST_LEAF_CHECK(run_self(
-        cfg, {"__chsy_get__", "--kernels", "--output", out.filename(), input.filename()}));
-    BOOST_LEAF_CHECK(save_temps(cfg, out, filetype::other));
+    return io::make_io_error(io::subprocess_error::make_exited(1), name);
+}
 
-    auto const list = BOOST_LEAF_CHECK(out.read_all_str());
+// kext keeps global state, such as the program being built and the options registered with
+// LLVM, so only one job runs it at a time. The other stages work on the program of their own
+// target and run concurrently.
+std::mutex kext_mtx;
 
-    if (list.empty()) {
-        return {};
-    }
+[[nodiscard]] result<void> collect_symbols(config const& cfg,
+                                           xcml::xcml_program_node_ptr const& prg,
+                                           std::vector<std::string>& symbols) {
+    cfg.begin_task("Collect Kernel Symbols");
 
-    for (size_t pos = 0; pos < list.size();) {
-        auto const nl = list.find("\n", pos);
+    std::vector<std::string> names;
+    BOOST_LEAF_CHECK(run_stage(cfg, "__chsy_get__", [&] {
+        names = get_kernel_names(prg);
+        return true;
+    }));
+
+    if (is_saved(cfg, filetype::other)) {
+        std::string list;
+        for (auto const& name : names) {
+            list += name;
+            list += '\n';
+        }
 
-        auto const end = nl == std::string::npos ? list.size() : nl;
-        auto const name = list.substr(pos, end - pos);
+        auto out = BOOST_LEAF_CHECK(io::file::mktemp(".txt"));
+        BOOST_LEAF_CHECK(out.write_str(0, list));
+        BOOST_LEAF_CHECK(save_temps(cfg, out, filetype::other));
+    }
 
+    for (auto& name : names) {
         if (!name.empty()) {
-            symbols.push_back(name);
+            symbols.push_back(std::move(name));
         }
-
-        pos = end + 1;
     }
 
     cfg.end_task();
@@ -82,92 +113,83 @@ result<io::file> run_clang_format(config const& cfg, io::file const& input) {
     return out;
 }
 
-[[nodiscard]] result<std::pair<file_map, io::file>> run_kext(
+[[nodiscard]] result<std::pair<program_map, io::file>> run_kext(
     config const& cfg, io::file const& input,
     [[maybe_unused]] std::vector<std::string>& symbols) {
-    file_map outs;
+    program_map outs;
 
     cfg.begin_task("Extract Kernels");
 
-    auto out = BOOST_LEAF_CHECK(io::file::mktemp(".xml"));
     auto desc = BOOST_LEAF_CHECK(io::file::mktemp(".hpp"));
+    xcml::xcml_program_node_ptr prg;
 
-    BOOST_LEAF_CHECK(
-        run_self(cfg, {"__chsy_kext__", "--output", out.filename(), "--desc", desc.filename(),
-                       input.filename(), "--", "-Xclang", "-fsycl-is-device", "-std=c++20"}));
-    BOOST_LEAF_CHECK(save_temps(cfg, out, filetype::xml));
-
-    cfg.end_task();
+    BOOST_LEAF_CHECK(run_stage(cfg, "__chsy_kext__", [&] {
+        std::lock_guard lock(kext_mtx);
 
-    auto const st = BOOST_LEAF_CHECK(out.stat());
-    if (st.st_size > 0) {
-        bool symbols_collected = false;
+        std::ofstream os(desc.filename());
+        return kext_program(input.filename(), {"-Xclang", "-fsycl-is-device", "-std=c++20"},
+                            os, prg) == 0;
+    }));
+    BOOST_LEAF_CHECK(save_xml(cfg, prg));
 
-        for (auto const t : cfg.targets) {
-            auto out2 = BOOST_LEAF_CHECK(io::file::mktemp(".xml"));
-            BOOST_LEAF_CHECK(out2.copy_from(out));
+    cfg.end_task();
 
-            if (!symbols_collected && is_cpu(t)) {
-                BOOST_LEAF_CHECK(collect_symbols(cfg, out2, symbols));
-                symbols_collected = true;
-            }
+    if (prg) {
+        bool const has_cpu = std::any_of(cfg.targets.begin(), cfg.targets.end(),
+                                         [](auto t) { return is_cpu(t); });
+        if (has_cpu) {
+            BOOST_LEAF_CHECK(collect_symbols(cfg, prg, symbols));
+        }
 
-            outs.emplace(t, std::move(out2));
+        // Lowering rewrites the program in place, so each target but the first gets a copy.
+        for (auto it = cfg.targets.begin(); it != cfg.targets.end(); ++it) {
+            outs.emplace(*it, it == cfg.targets.begin() ? prg : xcml::clone_program(prg));
         }
     }
 
     return std::make_pair(std::move(outs), std::move(desc));
 }
 
-result<file_map> run_lower(config const& cfg, file_map const& input_files) {
-    cfg.begin_task("Lowering Kernels");
-
-    file_map outs;
-
-    for (auto const& [target, input] : input_files) {
-        cfg.begin_task(fmt::format("for {}", show(target)));
+result<xcml::xcml_program_node_ptr> run_lower(config const& cfg, utils::target target,
+                                              xcml::xcml_program_node_ptr const& input) {
+    cfg.begin_task(fmt::format("Lowering Kernels for {}", show(target)));
 
-        auto out = BOOST_LEAF_CHECK(io::file::mktemp(".xml"));
+    xcml::xcml_program_node_ptr out;
 
-        BOOST_LEAF_CHECK(run_self(cfg, {"__chsy_lower__", "--output", out.filename(),
-                                        "--target", show(target), input.filename()}));
-
-        BOOST_LEAF_CHECK(save_temps(cfg, out, target, filetype::xml));
-
-        cfg.end_task();
+    BOOST_LEAF_CHECK(run_stage(cfg, "__chsy_lower__", [&] {
+        out = lower_program(input, target);
+        return true;
+    }));
 
-        outs.emplace(target, std::move(out));
-    }
+    BOOST_LEAF_CHECK(save_xml(cfg, out, target));
 
     cfg.end_task();
 
-    return outs;
+    return out;
 }
 
-result<file_map> run_cback(config const& cfg, file_map const& input_files) {
-    cfg.begin_task("Generating Kernel Code");
-    file_map outs;
+result<io::file> run_cback(config const& cfg, utils::target target,
+                           xcml::xcml_program_node_ptr const& input) {
+    cfg.begin_task(fmt::format("Generating Kernel Code for {}", show(target)));
 
-    for (auto const& [target, input] : input_files) {
-        cfg.begin_task(fmt::format("for {}", show(target)));
+    auto out = BOOST_LEAF_CHECK(io::file::mktemp(kernel_ext(target).c_str()));
 
-        auto out = BOOST_LEAF_CHECK(io::file::mktemp(kernel_ext(target).c_str()));
+    BOOST_LEAF_CHECK(run_stage(cfg, "__chsy_cback__", [&] {
+        std::ofstream os;
+        os.exceptions(os.failbit | os.badbit);
+        os.open(out.filename());
 
-        BOOST_LEAF_CHECK(run_self(cfg, {"__chsy_cback__", "--output", out.filename(),
-                                        "--target", show(target), input.filename()}));
+        cback_program(input, target, os);
+        return true;
+    }));
 
-        out = BOOST_LEAF_CHECK(run_clang_format(cfg, out));
+    out = BOOST_LEAF_CHECK(run_clang_format(cfg, out));
 
-        BOOST_LEAF_CHECK(save_temps(cfg, out, target, filetype::kernel));
-
-        cfg.end_task();
-
-        outs.emplace(target, std::move(out));
-    }
+    BOOST_LEAF_CHECK(save_temps(cfg, out, target, filetype::kernel));
 
     cfg.end_task();
 
-    return outs;
+    return out;
 }
 
 result<io::file> bin2asm(config const& cfg, io::file const& input, std::string& prefix) {
@@ -181,7 +181,13 @@ std::unique_ptr<clang::tooling::FrontendActionFactory> ast_consume_frontend_acti
 
 int run_action(clang::tooling::CommonOptionsParser& op,
                std::unique_ptr<clang::tooling::FrontendActionFactory>&& factory) {
-    clang::tooling::ClangTool tool(op.getCompilations(), op.getSourcePathList());
+    return run_action(op.getCompilations(), op.getSourcePathList(), std::move(factory));
+}
+
+int run_action(clang::tooling::CompilationDatabase const& db,
+               std::vector<std::string> const& sources,
+               std::unique_ptr<clang::tooling::FrontendActionFactory>&& factory) {
+    clang::tooling::ClangTool tool(db, sources);
 
     tool.appendArgumentsAdjuster(clang::tooling::getClangSyntaxOnlyAdjuster());
     tool.appendArgumentsAdjuster(clang::tooling::getClangStripOutputAdjuster());
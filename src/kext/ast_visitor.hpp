@@ -2,6 +2,8 @@
 
 #include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 
 #if defined(__GNUC__) && !defined(__clang__)
 #    pragma GCC diagnostic push
@@ -36,3 +38,7 @@ std::unique_ptr<clang::tooling::FrontendActionFactory> ast_consume_frontend_acti
 
 int run_action(clang::tooling::CommonOptionsParser& op,
                std::unique_ptr<clang::tooling::FrontendActionFactory>&& factory);
+
+int run_action(clang::tooling::CompilationDatabase const& db,
+               std::vector<std::string> const& sources,
+               std::unique_ptr<clang::tooling::FrontendActionFactory>&& factory);
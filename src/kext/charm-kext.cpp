@@ -1,4 +1,7 @@
 #include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
 #include "ast_visitor.hpp"
 #include "transform.hpp"
 
@@ -14,6 +17,7 @@
 #endif
 
 #include <clang/Tooling/CommonOptionsParser.h>
+#include <clang/Tooling/CompilationDatabase.h>
 #include <clang/Tooling/Tooling.h>
 
 #if defined(__GNUC__) && !defined(__clang__)
@@ -23,6 +27,40 @@
 #    pragma clang diagnostic pop
 #endif
 
+namespace {
+
+int run_kext(clang::tooling::CompilationDatabase const& db,
+             std::vector<std::string> const& sources, std::ostream& desc) {
+    auto action = ast_consume_frontend_action([&](clang::ASTContext& ctx) {
+        visit_kernel_functions(
+            ctx,
+            [&](llvm::StringRef name, clang::CXXMemberCallExpr*, clang::Expr* range,
+                clang::Expr const* offset, clang::Expr* fn) {
+                Transform(name, ctx, range, offset, fn, desc);
+            },
+            false);
+    });
+
+    return run_action(db, sources, std::move(action));
+}
+
+}  // namespace
+
+#ifndef IMPLEMENT_MAIN
+int kext_program(std::string const& input, std::vector<std::string> const& args,
+                 std::ostream& desc, xcml::xcml_program_node_ptr& prg) {
+    clang::tooling::FixedCompilationDatabase db(".", args);
+
+    auto const status = run_kext(db, {input}, desc);
+
+    // The transformer is taken even on failure so that the next input starts from scratch.
+    auto taken = TransformTake();
+    prg = status == 0 ? std::move(taken) : nullptr;
+
+    return status;
+}
+#endif
+
 #ifdef IMPLEMENT_MAIN
 int main(int argc, char** argv)
 #else
@@ -58,17 +96,7 @@ int kext_main(int argc, char** argv)
 
     std::ofstream desc(optDesc);
 
-    auto action = ast_consume_frontend_action([&](clang::ASTContext& ctx) {
-        visit_kernel_functions(
-            ctx,
-            [&](llvm::StringRef name, clang::CXXMemberCallExpr*, clang::Expr* range,
-                clang::Expr const* offset, clang::Expr* fn) {
-                Transform(name, ctx, range, offset, fn, desc);
-            },
-            false);
-    });
-
-    auto status = run_action(op.get(), std::move(action));
+    auto status = run_kext(op->getCompilations(), op->getSourcePathList(), desc);
 
     if (status == 0) {
         TransformSave(os ? *os : llvm::outs());
@@ -211,6 +211,10 @@ struct transformer final {
         sort_decls(prg);
     }
 
+    xcml::xcml_program_node_ptr program() {
+        return info_.prg();
+    }
+
     template <class Output>
     void dump_xml(Output& out) {
         struct writer : pugi::xml_writer {
@@ -262,6 +266,8 @@ private:
         add_param(wrapper, info_.define_type(fn_record), args);
 
         auto const l = layout(ctx, fn_record, true);
+        // The kernel takes a copy of the function object and the pointer of each accessor.
+        auto params_size = ctx.getTypeSizeInChars(fn_record).getQuantity();
 
         for (auto it = l.begin(); it != l.end(); ++it) {
             auto const type = it->decl()->getType();
@@ -279,6 +285,7 @@ private:
 
                 auto const& ptr_param = info_.nm().gen_var("ptr");
                 add_param(wrapper, info_.define_type(ctx.VoidPtrTy), ptr_param);
+                params_size += ctx.getTypeSizeInChars(ctx.VoidPtrTy).getQuantity();
 
                 auto ptr_ref = make_member_ref(acc_ptr, "ptr");
                 push_expr(wrapper->body, assign_expr(ptr_ref, make_var_ref(ptr_param)));
@@ -290,6 +297,9 @@ private:
         auto const kernel_name = std::string(cxx_name.data(), cxx_name.size());
 
         desc_buffer_ += fmt::format("struct {} {{\n", desc_name);
+        desc_buffer_ += fmt::format("constexpr size_t params_size() const {{\n");
+        desc_buffer_ += fmt::format("return {};\n", params_size);
+        desc_buffer_ += fmt::format("}}\n");
         desc_buffer_ += fmt::format("constexpr auto accessors() const {{\n");
         desc_buffer_ += fmt::format("return list<\n");
         unsigned int n_acc = 0;
@@ -378,3 +388,12 @@ void TransformSave(llvm::raw_ostream& out) {
         p->dump_xml(out);
     }
 }
+
+xcml::xcml_program_node_ptr TransformTake() {
+    auto p = std::move(g_transformer);
+    if (p) {
+        p->finalize();
+        return p->program();
+    }
+    return nullptr;
+}
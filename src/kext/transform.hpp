@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <xcml_type.hpp>
 
 #if defined(__GNUC__) && !defined(__clang__)
 #    pragma GCC diagnostic push
@@ -28,3 +29,6 @@
 void Transform(llvm::StringRef name, clang::ASTContext& ctx, clang::Expr const* range,
                clang::Expr const* offset, clang::Expr const* lambda, std::ostream&);
 void TransformSave(llvm::raw_ostream& out);
+// Same as TransformSave() but returns the program instead of writing it. Returns nullptr if no
+// kernels are transformed.
+xcml::xcml_program_node_ptr TransformTake();
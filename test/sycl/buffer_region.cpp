@@ -0,0 +1,97 @@
+#include "ut_common.hpp"
+
+namespace {
+
+// Sets `y` to ten times `x`, which reads each part of `x` from the domain that wrote it last.
+void scale(sycl::queue& q, sycl::buffer<int, 1>& x, sycl::buffer<int, 1>& y, size_t n) {
+    q.submit([&](sycl::handler& h) {
+        sycl::accessor<int, 1, sycl::access_mode::read> xx(x, h);
+        sycl::accessor<int, 1, sycl::access_mode::discard_write> yy(y, h);
+
+        h.parallel_for(sycl::range(n), [=](sycl::id<1> const& i) {
+            yy[i] = xx[i] * 10;
+        });
+    });
+}
+
+}  // namespace
+
+int main() {
+    sycl::queue q;
+
+    "buffer_region"_test = [&]() {
+        constexpr size_t n = 1000;
+        constexpr size_t half = n / 2;
+
+        "buffer_region host and device halves"_test = [&]() {
+            std::vector<int> h_x(n, 2);
+            std::vector<int> h_y(n, -1);
+
+            {
+                sycl::buffer x(h_x.data(), sycl::range(n));
+                sycl::buffer y(h_y.data(), sycl::range(n));
+
+                // The device writes the first half, and the host holds the second one.
+                q.submit([&](sycl::handler& h) {
+                    sycl::accessor<int, 1, sycl::access_mode::write> xx(x, h,
+                                                                         sycl::range(half));
+
+                    h.parallel_for(sycl::range(half), [=](sycl::id<1> const& i) {
+                        xx[i] = 1;
+                    });
+                });
+
+                scale(q, x, y, n);
+            }
+
+            size_t n_err = 0;
+            for (size_t i = 0; i < n; i++) {
+                n_err += h_x.at(i) != (i < half ? 1 : 2);
+                n_err += h_y.at(i) != (i < half ? 10 : 20);
+            }
+            expect(n_err == 0_ul);
+        };
+
+        "buffer_region copied half"_test = [&]() {
+            std::vector<int> h_src(half, 3);
+            std::vector<int> h_y(n, -1);
+
+            {
+                sycl::buffer<int, 1> x{sycl::range(n)};
+                sycl::buffer y(h_y.data(), sycl::range(n));
+
+                q.submit([&](sycl::handler& h) {
+                    sycl::accessor<int, 1, sycl::access_mode::discard_write> xx(x, h);
+
+                    h.parallel_for(sycl::range(n), [=](sycl::id<1> const& i) {
+                        xx[i] = 1;
+                    });
+                });
+
+                // A copy from the host overwrites the second half.
+                q.submit([&](sycl::handler& h) {
+                    h.copy(h_src.data(),
+                           x.get_access(h, sycl::range(half), sycl::id<1>(half)));
+                });
+
+                scale(q, x, y, n);
+
+                sycl::host_accessor<int, 1, sycl::access_mode::read> xx(x);
+
+                size_t n_err = 0;
+                for (size_t i = 0; i < n; i++) {
+                    n_err += xx[i] != (i < half ? 1 : 3);
+                }
+                expect(n_err == 0_ul);
+            }
+
+            size_t n_err = 0;
+            for (size_t i = 0; i < n; i++) {
+                n_err += h_y.at(i) != (i < half ? 10 : 30);
+            }
+            expect(n_err == 0_ul);
+        };
+    };
+
+    return 0;
+}
@@ -0,0 +1,172 @@
+#include <algorithm>
+#include "ut_common.hpp"
+
+namespace {
+
+// Every call returns an object of the same closure type, so set_arg() can replace the kernel
+// object recorded for one call by that of another.
+auto add_to(int* x, int k) {
+    return [=](sycl::id<1> const& i) {
+        x[i[0]] += k;
+    };
+}
+
+void record(sycl::queue& q, sycl::buffer<int, 1>& x, size_t n) {
+    q.submit([&](sycl::handler& h) {
+        sycl::accessor<int, 1, sycl::access_mode::read_write> xx(x, h);
+
+        h.parallel_for(sycl::range(n), [=](sycl::id<1> const& i) {
+            xx[i] += 1;
+        });
+    });
+
+    q.submit([&](sycl::handler& h) {
+        sycl::accessor<int, 1, sycl::access_mode::read_write> xx(x, h);
+
+        h.parallel_for(sycl::range(n), [=](sycl::id<1> const& i) {
+            xx[i] *= 2;
+        });
+    });
+}
+
+size_t count_errors(sycl::buffer<int, 1>& x, size_t n, int expected) {
+    sycl::host_accessor<int, 1, sycl::access_mode::read> xx(x);
+
+    size_t n_err = 0;
+    for (size_t i = 0; i < n; i++) {
+        n_err += xx[i] != expected;
+    }
+    return n_err;
+}
+
+}  // namespace
+
+int main() {
+    sycl::queue q;
+
+    "command_graph"_test = [&]() {
+        "command_graph replay"_test = [&]() {
+            constexpr size_t n = 1000;
+            sycl::buffer<int, 1> x(sycl::range(n));
+
+            q.submit([&](sycl::handler& h) {
+                sycl::accessor<int, 1, sycl::access_mode::discard_write> xx(x, h);
+
+                h.parallel_for(sycl::range(n), [=](sycl::id<1> const& i) {
+                    xx[i] = 0;
+                });
+            });
+
+            sycl::command_graph g(q);
+
+            g.begin_recording();
+            record(q, x, n);
+            g.end_recording();
+
+            expect(g.size() == 2_ul);
+
+            // Nothing runs while recording.
+            expect(count_errors(x, n, 0) == 0_ul);
+
+            g.replay().wait();
+            expect(count_errors(x, n, 2) == 0_ul);
+
+            // The host accessor above accessed the buffer, so this replay analyzes the graph
+            // again, and the next one reuses the analysis.
+            g.replay();
+            g.replay().wait();
+            expect(count_errors(x, n, 14) == 0_ul);
+        };
+
+        "command_graph set_arg"_test = [&]() {
+            constexpr size_t n = 1023;
+
+            auto* x = sycl::malloc_shared<int>(n, q);
+
+            // Only some backends support USM.
+            if (x == nullptr) {
+                return;
+            }
+
+            std::fill(x, x + n, 0);
+
+            sycl::command_graph g(q);
+
+            g.begin_recording();
+            q.submit([&](sycl::handler& h) {
+                h.parallel_for(sycl::range(n), add_to(x, 1));
+            });
+            g.end_recording();
+
+            expect(g.size() == 1_ul);
+
+            g.replay().wait();
+
+            size_t n_err = 0;
+            for (size_t i = 0; i < n; i++) {
+                n_err += x[i] != 1;
+            }
+            expect(n_err == 0_ul);
+
+            g.set_arg(0, 0, add_to(x, 10));
+            g.replay().wait();
+
+            n_err = 0;
+            for (size_t i = 0; i < n; i++) {
+                n_err += x[i] != 11;
+            }
+            expect(n_err == 0_ul);
+
+            sycl::free(x, q);
+        };
+
+        "command_graph buffer outlives the queue"_test = [&]() {
+            constexpr size_t n = 999;
+            std::vector<int> x_host(n, 3);
+
+            {
+                sycl::buffer<int, 1> x(x_host.data(), sycl::range(n));
+
+                {
+                    sycl::queue q2;
+                    sycl::command_graph g(q2);
+
+                    g.begin_recording();
+                    record(q2, x, n);
+                    g.end_recording();
+
+                    g.replay();
+                    g.replay().wait();
+                }
+
+                expect(count_errors(x, n, 18) == 0_ul);
+            }
+
+            size_t n_err = 0;
+            for (size_t i = 0; i < n; i++) {
+                n_err += x_host.at(i) != 18;
+            }
+            expect(n_err == 0_ul);
+        };
+
+        "command_graph outlives the buffer"_test = [&]() {
+            constexpr size_t n = 100;
+            sycl::command_graph g(q);
+
+            {
+                sycl::buffer<int, 1> x(sycl::range(n));
+
+                g.begin_recording();
+                record(q, x, n);
+                g.end_recording();
+            }
+
+            // The graph keeps the buffer alive, although nothing can read the result.
+            g.replay().wait();
+
+            expect(g.size() == 2_ul);
+        };
+    };
+
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include "ut_common.hpp"
+
+namespace {
+
+// Every work-group reverses its items in local memory twice, so each barrier has to order all
+// the work-items of the group, whichever worker thread runs it.
+sycl::event reverse_twice(sycl::queue& q, sycl::buffer<int, 1>& x, size_t n, size_t l) {
+    return q.submit([&](sycl::handler& h) {
+        sycl::local_accessor<int, 1> smem({l}, h);
+        sycl::accessor<int, 1, sycl::access_mode::discard_write> out(x, h);
+
+        h.parallel_for(sycl::nd_range<1>({n}, {l}), [=](sycl::nd_item<1> const& item) {
+            auto const lid = item.get_local_linear_id();
+            auto const gid = item.get_global_linear_id();
+
+            smem[lid] = static_cast<int>(gid);
+            item.barrier(sycl::access::fence_space::local_space);
+
+            auto const r = smem[l - 1 - lid];
+            item.barrier(sycl::access::fence_space::local_space);
+
+            smem[lid] = r * 2;
+            item.barrier(sycl::access::fence_space::local_space);
+
+            out[gid] = smem[l - 1 - lid];
+        });
+    });
+}
+
+size_t count_errors(std::vector<int> const& x) {
+    size_t n_err = 0;
+    for (size_t i = 0; i < x.size(); i++) {
+        n_err += x.at(i) != static_cast<int>(i) * 2;
+    }
+    return n_err;
+}
+
+}  // namespace
+
+int main() {
+    sycl::queue q;
+
+    skip_if(iris()) / "fiber"_test = [&]() {
+        "fiber many groups"_test = [&]() {
+            // Many more groups than worker threads, with a local range that is not a power of
+            // two.
+            constexpr size_t l = 24;
+            constexpr size_t n = l * 257;
+            std::vector<int> x_host(n, -1);
+
+            {
+                sycl::buffer<int, 1> x(x_host.data(), {n});
+
+                reverse_twice(q, x, n, l).wait();
+            }
+
+            expect(count_errors(x_host) == 0_ul);
+        };
+
+        "fiber concurrent kernels"_test = [&]() {
+            // The worker pool is shared by the kernels of both queues.
+            sycl::queue q2;
+            constexpr size_t l = 16;
+            constexpr size_t n = l * 100;
+            std::vector<int> x_host(n, -1);
+            std::vector<int> y_host(n, -1);
+
+            {
+                sycl::buffer<int, 1> x(x_host.data(), {n});
+                sycl::buffer<int, 1> y(y_host.data(), {n});
+
+                auto ev1 = reverse_twice(q, x, n, l);
+                auto ev2 = reverse_twice(q2, y, n, l);
+
+                ev1.wait();
+                ev2.wait();
+            }
+
+            expect(count_errors(x_host) == 0_ul);
+            expect(count_errors(y_host) == 0_ul);
+        };
+    };
+
+    return 0;
+}
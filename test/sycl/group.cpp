@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <limits>
+#include "ut_common.hpp"
+
+int main() {
+    sycl::queue q;
+
+    "group"_test = [&]() {
+        "group 1d"_test = [&]() {
+            // The local range is not a power of two.
+            constexpr size_t n = 60;
+            constexpr size_t l = 12;
+
+            std::vector<int> red(n, -1), inc(n, -1), exc(n, -1), bc(n, -1);
+
+            {
+                sycl::buffer<int> red_buf(red.data(), sycl::range(n));
+                sycl::buffer<int> inc_buf(inc.data(), sycl::range(n));
+                sycl::buffer<int> exc_buf(exc.data(), sycl::range(n));
+                sycl::buffer<int> bc_buf(bc.data(), sycl::range(n));
+
+                q.submit([&](sycl::handler& h) {
+                    sycl::accessor<int, 1, sycl::access_mode::discard_write> rr(red_buf, h);
+                    sycl::accessor<int, 1, sycl::access_mode::discard_write> ii(inc_buf, h);
+                    sycl::accessor<int, 1, sycl::access_mode::discard_write> ee(exc_buf, h);
+                    sycl::accessor<int, 1, sycl::access_mode::discard_write> bb(bc_buf, h);
+
+                    h.parallel_for(sycl::nd_range<1>(sycl::range(n), sycl::range(l)),
+                                   [=](sycl::nd_item<1> const& it) {
+                                       auto const g = it.get_group();
+                                       auto const i = it.get_global_linear_id();
+                                       auto const v = static_cast<int>(i % 7) + 1;
+
+                                       rr[i] = sycl::reduce_over_group(g, v, sycl::plus<>());
+                                       ii[i] = sycl::inclusive_scan_over_group(g, v,
+                                                                               sycl::plus<>());
+                                       ee[i] = sycl::exclusive_scan_over_group(g, v,
+                                                                               sycl::plus<>());
+                                       bb[i] = sycl::group_broadcast(g, v, 5);
+                                   });
+                });
+            }
+
+            size_t n_err = 0;
+            for (size_t g = 0; g < n / l; g++) {
+                int sum = 0;
+                for (size_t k = 0; k < l; k++) {
+                    sum += static_cast<int>((g * l + k) % 7) + 1;
+                }
+
+                int acc = 0;
+                for (size_t k = 0; k < l; k++) {
+                    auto const i = g * l + k;
+                    auto const v = static_cast<int>(i % 7) + 1;
+
+                    n_err += red.at(i) != sum;
+                    n_err += exc.at(i) != acc;
+                    acc += v;
+                    n_err += inc.at(i) != acc;
+                    n_err += bc.at(i) != static_cast<int>((g * l + 5) % 7) + 1;
+                }
+            }
+
+            expect(n_err == 0_ul);
+        };
+
+        "group 2d"_test = [&]() {
+            // 3x5 work-items in each group, which are scanned in the order of the local
+            // linear ids.
+            constexpr size_t n0 = 6, n1 = 10;
+            constexpr size_t l0 = 3, l1 = 5;
+
+            std::vector<long> red(n0 * n1, -1), inc(n0 * n1, -1), bc(n0 * n1, -1);
+
+            {
+                sycl::buffer<long, 2> red_buf(red.data(), sycl::range(n0, n1));
+                sycl::buffer<long, 2> inc_buf(inc.data(), sycl::range(n0, n1));
+                sycl::buffer<long, 2> bc_buf(bc.data(), sycl::range(n0, n1));
+
+                q.submit([&](sycl::handler& h) {
+                    sycl::accessor<long, 2, sycl::access_mode::discard_write> rr(red_buf, h);
+                    sycl::accessor<long, 2, sycl::access_mode::discard_write> ii(inc_buf, h);
+                    sycl::accessor<long, 2, sycl::access_mode::discard_write> bb(bc_buf, h);
+
+                    h.parallel_for(
+                        sycl::nd_range<2>(sycl::range(n0, n1), sycl::range(l0, l1)),
+                        [=](sycl::nd_item<2> const& it) {
+                            auto const g = it.get_group();
+                            auto const i = it.get_global_id();
+                            auto const v = static_cast<long>((i[0] * 7 + i[1] * 3) % 11);
+
+                            rr[i] = sycl::reduce_over_group(g, v, sycl::maximum<>());
+                            ii[i] = sycl::inclusive_scan_over_group(g, v, sycl::plus<>());
+                            bb[i] = sycl::group_broadcast(g, v, sycl::id<2>(1, 2));
+                        });
+                });
+            }
+
+            auto const value = [](size_t i0, size_t i1) {
+                return static_cast<long>((i0 * 7 + i1 * 3) % 11);
+            };
+
+            size_t n_err = 0;
+            for (size_t g0 = 0; g0 < n0 / l0; g0++) {
+                for (size_t g1 = 0; g1 < n1 / l1; g1++) {
+                    long max = std::numeric_limits<long>::lowest();
+                    for (size_t k0 = 0; k0 < l0; k0++) {
+                        for (size_t k1 = 0; k1 < l1; k1++) {
+                            max = std::max(max, value(g0 * l0 + k0, g1 * l1 + k1));
+                        }
+                    }
+
+                    long acc = 0;
+                    for (size_t k0 = 0; k0 < l0; k0++) {
+                        for (size_t k1 = 0; k1 < l1; k1++) {
+                            auto const i0 = g0 * l0 + k0;
+                            auto const i1 = g1 * l1 + k1;
+                            auto const idx = i0 * n1 + i1;
+
+                            acc += value(i0, i1);
+                            n_err += red.at(idx) != max;
+                            n_err += inc.at(idx) != acc;
+                            n_err += bc.at(idx) != value(g0 * l0 + 1, g1 * l1 + 2);
+                        }
+                    }
+                }
+            }
+
+            expect(n_err == 0_ul);
+        };
+    };
+
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include "ut_common.hpp"
+
+namespace {
+
+using host_memory = sycl::property::buffer::host_memory;
+
+// Writes to a buffer whose host memory is allocated by `prop` and reads the values back. The
+// buffer spans several huge pages, so the memory is mapped instead of calloc'ed.
+size_t round_trip(sycl::queue& q, host_memory const& prop) {
+    constexpr size_t n = size_t(3) << 20;
+
+    sycl::buffer<int, 1> x(sycl::range(n), sycl::property_list(host_memory(prop)));
+
+    size_t n_err = 0;
+
+    {
+        sycl::host_accessor<int, 1, sycl::access_mode::read> xx(x);
+
+        // The memory is zero-filled.
+        for (size_t i = 0; i < n; i++) {
+            n_err += xx[i] != 0;
+        }
+    }
+
+    q.submit([&](sycl::handler& h) {
+        sycl::accessor<int, 1, sycl::access_mode::read_write> xx(x, h);
+
+        h.parallel_for(sycl::range(n), [=](sycl::id<1> const& i) {
+            xx[i] += static_cast<int>(i[0] % 1000);
+        });
+    });
+
+    sycl::host_accessor<int, 1, sycl::access_mode::read> xx(x);
+
+    for (size_t i = 0; i < n; i++) {
+        n_err += xx[i] != static_cast<int>(i % 1000);
+    }
+
+    return n_err;
+}
+
+}  // namespace
+
+int main() {
+    sycl::queue q;
+
+    "host_memory"_test = [&]() {
+        "host_memory first_touch"_test = [&]() {
+            expect(round_trip(q, {}) == 0_ul);
+        };
+
+        "host_memory interleave"_test = [&]() {
+            expect(round_trip(q, {.place = host_memory::placement::interleave}) == 0_ul);
+        };
+
+        "host_memory bind"_test = [&]() {
+            expect(round_trip(q, {.place = host_memory::placement::bind, .node = 0}) == 0_ul);
+        };
+
+        "host_memory transparent_huge"_test = [&]() {
+            expect(round_trip(q, {.page = host_memory::pages::transparent_huge}) == 0_ul);
+        };
+
+        "host_memory huge"_test = [&]() {
+            expect(round_trip(q, {.page = host_memory::pages::huge}) == 0_ul);
+        };
+    };
+
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include "ut_common.hpp"
+
+int main() {
+    sycl::queue q({sycl::property::queue::in_order()});
+
+    "in_order"_test = [&]() {
+        expect(q.is_in_order());
+
+        "in_order chain"_test = [&]() {
+            constexpr size_t n = 1000;
+            std::vector<int> x_host(n, -1);
+
+            {
+                sycl::buffer<int> x(x_host.data(), sycl::range(n));
+
+                q.submit([&](sycl::handler& h) {
+                    sycl::accessor<int, 1, sycl::access_mode::discard_write> xx(x, h);
+
+                    h.parallel_for(sycl::range(n), [=](sycl::id<1> const& i) {
+                        xx[i] = i[0];
+                    });
+                });
+
+                for (int k = 0; k < 8; k++) {
+                    q.submit([&](sycl::handler& h) {
+                        sycl::accessor<int, 1, sycl::access_mode::read_write> xx(x, h);
+
+                        h.parallel_for(sycl::range(n), [=](sycl::id<1> const& i) {
+                            xx[i] += 1;
+                        });
+                    });
+                }
+
+                q.wait();
+            }
+
+            size_t n_err = 0;
+            for (size_t i = 0; i < n; i++) {
+                n_err += x_host.at(i) != static_cast<int>(i) + 8;
+            }
+
+            expect(n_err == 0_ul);
+        };
+
+        "in_order reduction"_test = [&]() {
+            constexpr size_t n = 1023;
+            std::vector<double> x_host(n, 0);
+            double result = -999;
+
+            {
+                sycl::buffer<double> x(x_host.data(), sycl::range(n));
+                sycl::buffer<double> r(&result, 1);
+
+                q.submit([&](sycl::handler& h) {
+                    sycl::accessor<double, 1, sycl::access_mode::discard_write> xx(x, h);
+
+                    h.parallel_for(sycl::range(n), [=](sycl::id<1> const& i) {
+                        xx[i] = 2.0;
+                    });
+                });
+
+                // The reduction initializes `r` by a command group submitted to the same queue
+                // from the command-group function.
+                q.submit([&](sycl::handler& h) {
+                    sycl::accessor<double, 1, sycl::access_mode::read> xx(x, h);
+                    auto r_red = sycl::reduction(r, h, sycl::plus<>());
+
+                    h.parallel_for(sycl::range(n), r_red, [=](sycl::id<1> const& i, auto& rr) {
+                        rr += xx[i];
+                    });
+                });
+
+                q.submit([&](sycl::handler& h) {
+                    auto r_red = sycl::reduction(r, h, sycl::plus<>());
+
+                    h.parallel_for(sycl::range(n), r_red, [=](sycl::id<1> const&, auto& rr) {
+                        rr += 1.0;
+                    });
+                });
+
+                q.wait();
+            }
+
+            expect(result == 1023.00000_d);
+        };
+    };
+
+    return 0;
+}
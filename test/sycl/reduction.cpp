@@ -47,6 +47,141 @@ int main() {
 
             expect(result == 1023.00000_d);
         };
+
+        "reduction plus int"_test = [&]() {
+            int result = -999;
+
+            {
+                sycl::buffer<int> x(&result, 1);
+
+                q.submit([&](sycl::handler& h) {
+                    auto x_red = sycl::reduction(x, h, sycl::plus<>());
+
+                    h.parallel_for(
+                        sycl::range(1023), x_red, [=](sycl::id<1> const& i, auto& xx) {
+                            xx += static_cast<int>(i[0]);
+                        });
+                });
+            }
+
+            expect(result == 522753_i);
+        };
+
+        "reduction minimum long"_test = [&]() {
+            long result = 0;
+
+            {
+                sycl::buffer<long> x(&result, 1);
+
+                q.submit([&](sycl::handler& h) {
+                    auto x_red = sycl::reduction(x, h, sycl::minimum<>());
+
+                    h.parallel_for(
+                        sycl::range(1023), x_red, [=](sycl::id<1> const& i, auto& xx) {
+                            xx.combine(static_cast<long>(i[0]) - 500);
+                        });
+                });
+            }
+
+            expect(result == -500_l);
+        };
+
+        "reduction maximum float"_test = [&]() {
+            float result = 0;
+
+            {
+                sycl::buffer<float> x(&result, 1);
+
+                q.submit([&](sycl::handler& h) {
+                    auto x_red = sycl::reduction(x, h, sycl::maximum<>());
+
+                    h.parallel_for(
+                        sycl::range(1023), x_red, [=](sycl::id<1> const& i, auto& xx) {
+                            xx.combine(-static_cast<float>(i[0]) - 1.0f);
+                        });
+                });
+            }
+
+            expect(result == -1.0_f);
+        };
+
+        "reduction bit_or unsigned"_test = [&]() {
+            unsigned int result = 0;
+
+            {
+                sycl::buffer<unsigned int> x(&result, 1);
+
+                q.submit([&](sycl::handler& h) {
+                    auto x_red = sycl::reduction(x, h, sycl::bit_or<>());
+
+                    h.parallel_for(
+                        sycl::range(1000), x_red, [=](sycl::id<1> const& i, auto& xx) {
+                            xx |= 1u << (i[0] % 20);
+                        });
+                });
+            }
+
+            expect(result == 0xfffffu);
+        };
+
+        "reduction bit_and unsigned long long"_test = [&]() {
+            unsigned long long result = 0;
+
+            {
+                sycl::buffer<unsigned long long> x(&result, 1);
+
+                q.submit([&](sycl::handler& h) {
+                    auto x_red = sycl::reduction(x, h, sycl::bit_and<>());
+
+                    h.parallel_for(
+                        sycl::range(1000), x_red, [=](sycl::id<1> const& i, auto& xx) {
+                            xx &= ~(1ull << (i[0] % 40));
+                        });
+                });
+            }
+
+            expect(result == ~((1ull << 40) - 1));
+        };
+
+        "reduction bit_xor long long"_test = [&]() {
+            long long result = 0;
+
+            {
+                sycl::buffer<long long> x(&result, 1);
+
+                q.submit([&](sycl::handler& h) {
+                    auto x_red = sycl::reduction(x, h, sycl::bit_xor<>());
+
+                    h.parallel_for(
+                        sycl::range(999), x_red, [=](sycl::id<1> const& i, auto& xx) {
+                            xx ^= i[0] % 3 == 0 ? 5ll : 3ll;
+                        });
+                });
+            }
+
+            // 333 times 5 and 666 times 3.
+            expect(result == 5_ll);
+        };
+
+        "reduction 3D"_test = [&]() {
+            long result = 0;
+
+            {
+                sycl::buffer<long> x(&result, 1);
+
+                q.submit([&](sycl::handler& h) {
+                    auto x_red = sycl::reduction(x, h, sycl::plus<>());
+
+                    h.parallel_for(
+                        sycl::range(3, 5, 7), x_red, [=](sycl::id<3> const& i, auto& xx) {
+                            xx += static_cast<long>(i[0] * 10000 + i[1] * 100 + i[2]);
+                        });
+                });
+            }
+
+            // 35 * 10000 * (0 + 1 + 2) + 21 * 100 * (0 + ... + 4) + 15 * (0 + ... + 6)
+            expect(result == 1071315_l);
+        };
     };
 
     return 0;
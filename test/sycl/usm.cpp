@@ -0,0 +1,169 @@
+#include "ut_common.hpp"
+
+int main() {
+    sycl::queue q;
+
+    "usm"_test = [&]() {
+        "usm round trip"_test = [&]() {
+            constexpr size_t n = 1000;
+            constexpr size_t byte = n * sizeof(int);
+
+            auto* x = sycl::malloc_device<int>(n, q);
+            auto* y = sycl::malloc_device<int>(n, q);
+
+            // Only some backends support USM.
+            if (x == nullptr || y == nullptr) {
+                sycl::free(x, q);
+                sycl::free(y, q);
+                return;
+            }
+
+            std::vector<int> src(n), dst(n, -1);
+            for (size_t i = 0; i < n; i++) {
+                src[i] = static_cast<int>(i) * 3 - 7;
+            }
+
+            auto ev1 = q.memcpy(x, src.data(), byte);
+            auto ev2 = q.memcpy(y, x, byte, ev1);
+            q.memcpy(dst.data(), y, byte, ev2).wait();
+
+            size_t n_err = 0;
+            for (size_t i = 0; i < n; i++) {
+                n_err += dst.at(i) != src.at(i);
+            }
+
+            expect(n_err == 0_ul);
+
+            sycl::free(x, q);
+            sycl::free(y, q);
+        };
+
+        "usm fill"_test = [&]() {
+            constexpr size_t n = 1023;
+
+            auto* x = sycl::malloc_shared<double>(n, q);
+
+            if (x == nullptr) {
+                return;
+            }
+
+            q.fill(x, 2.5, n).wait();
+
+            size_t n_err = 0;
+            for (size_t i = 0; i < n; i++) {
+                n_err += x[i] != 2.5;
+            }
+
+            expect(n_err == 0_ul);
+
+            auto ev = q.fill(x, -1.0, n / 2);
+            q.memset(x + n / 2, 0, (n - n / 2) * sizeof(double), ev).wait();
+
+            n_err = 0;
+            for (size_t i = 0; i < n; i++) {
+                n_err += x[i] != (i < n / 2 ? -1.0 : 0.0);
+            }
+
+            expect(n_err == 0_ul);
+
+            sycl::free(x, q);
+        };
+
+        "usm kernel device"_test = [&]() {
+            constexpr size_t n = 1000;
+            constexpr size_t byte = n * sizeof(int);
+
+            auto* x = sycl::malloc_device<int>(n, q);
+            auto* y = sycl::malloc_device<int>(n, q);
+
+            if (x == nullptr || y == nullptr) {
+                sycl::free(x, q);
+                sycl::free(y, q);
+                return;
+            }
+
+            std::vector<int> src(n), dst_x(n, -1), dst_y(n, -1);
+            for (size_t i = 0; i < n; i++) {
+                src[i] = static_cast<int>(i) - 300;
+            }
+
+            q.memcpy(x, src.data(), byte).wait();
+
+            q.submit([&](sycl::handler& h) {
+                h.parallel_for(sycl::range(n), [=](sycl::id<1> const& i) {
+                    y[i[0]] = x[i[0]] * 2 + 1;
+                    x[i[0]] += 1;
+                });
+            }).wait();
+
+            auto ev = q.memcpy(dst_x.data(), x, byte);
+            q.memcpy(dst_y.data(), y, byte, ev).wait();
+
+            size_t n_err = 0;
+            for (size_t i = 0; i < n; i++) {
+                n_err += dst_x.at(i) != src.at(i) + 1;
+                n_err += dst_y.at(i) != src.at(i) * 2 + 1;
+            }
+
+            expect(n_err == 0_ul);
+
+            sycl::free(x, q);
+            sycl::free(y, q);
+        };
+
+        "usm kernel shared"_test = [&]() {
+            constexpr size_t n = 1023;
+
+            auto* x = sycl::malloc_shared<double>(n, q);
+
+            if (x == nullptr) {
+                return;
+            }
+
+            for (size_t i = 0; i < n; i++) {
+                x[i] = static_cast<double>(i);
+            }
+
+            q.submit([&](sycl::handler& h) {
+                h.parallel_for(sycl::range(n), [=](sycl::id<1> const& i) {
+                    x[i[0]] = x[i[0]] * 0.5 + 1.0;
+                });
+            }).wait();
+
+            size_t n_err = 0;
+            for (size_t i = 0; i < n; i++) {
+                n_err += x[i] != static_cast<double>(i) * 0.5 + 1.0;
+            }
+
+            expect(n_err == 0_ul);
+
+            sycl::free(x, q);
+        };
+
+        "usm reuse"_test = [&]() {
+            constexpr size_t n = 4096;
+
+            // Freed blocks go back to the pool of the runtime and are handed out again.
+            for (int k = 0; k < 4; k++) {
+                auto* x = sycl::malloc_host<int>(n, q);
+
+                if (x == nullptr) {
+                    return;
+                }
+
+                q.fill(x, k, n).wait();
+
+                size_t n_err = 0;
+                for (size_t i = 0; i < n; i++) {
+                    n_err += x[i] != k;
+                }
+
+                expect(n_err == 0_ul);
+
+                sycl::free(x, q);
+            }
+        };
+    };
+
+    return 0;
+}